@@ -0,0 +1,155 @@
+/***************************************************************************
+*@brief ADC Filter: fixed-point filters and decimation for ADC samples
+***************************************************************************/
+#include <string.h>
+#include "adc_filter.h"
+
+/*********************
+*   MOVING AVERAGE
+*********************/
+void adc_filter_ma_init(adc_filter_ma_t *f, uint8_t len)
+{
+    memset(f, 0, sizeof(*f));
+    f->len = (len == 0) ? 1 : (len > ADC_FILTER_MA_MAX ? ADC_FILTER_MA_MAX : len);
+}
+
+uint16_t adc_filter_ma_step(adc_filter_ma_t *f, uint16_t x)
+{
+    /*Running sum: add the new sample and remove the oldest one*/
+    if (f->count < f->len)
+    {
+        f->count++;
+    }
+    else
+    {
+        f->sum -= f->window[f->pos];
+    }
+    f->window[f->pos] = x;
+    f->sum += x;
+    if (++f->pos == f->len)
+    {
+        f->pos = 0;
+    }
+    return f->sum / f->count;
+}
+
+void adc_filter_ma_process(adc_filter_ma_t *f, const uint16_t *in, uint16_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = adc_filter_ma_step(f, in[i]);
+    }
+}
+
+/*********************
+*   MEDIAN
+*********************/
+void adc_filter_median_init(adc_filter_median_t *f, uint8_t len)
+{
+    memset(f, 0, sizeof(*f));
+    f->len = (len == 0) ? 1 : (len > ADC_FILTER_MEDIAN_MAX ? ADC_FILTER_MEDIAN_MAX : len);
+}
+
+uint16_t adc_filter_median_step(adc_filter_median_t *f, uint16_t x)
+{
+    uint8_t i;
+
+    /*Remove the oldest sample from the sorted window once it is full*/
+    if (f->count == f->len)
+    {
+        uint16_t old = f->window[f->pos];
+        for (i = 0; f->sorted[i] != old; i++)
+        {
+        }
+        for (; i + 1 < f->count; i++)
+        {
+            f->sorted[i] = f->sorted[i + 1];
+        }
+        f->count--;
+    }
+    f->window[f->pos] = x;
+    if (++f->pos == f->len)
+    {
+        f->pos = 0;
+    }
+
+    /*Insertion of the new sample keeps the window sorted in O(len)*/
+    for (i = f->count; i > 0 && f->sorted[i - 1] > x; i--)
+    {
+        f->sorted[i] = f->sorted[i - 1];
+    }
+    f->sorted[i] = x;
+    f->count++;
+
+    return f->sorted[f->count / 2];
+}
+
+void adc_filter_median_process(adc_filter_median_t *f, const uint16_t *in, uint16_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = adc_filter_median_step(f, in[i]);
+    }
+}
+
+/*********************
+*   SINGLE-POLE IIR
+*********************/
+void adc_filter_iir_init(adc_filter_iir_t *f, uint8_t shift)
+{
+    f->acc = 0;
+    f->shift = (shift > 15) ? 15 : shift;
+    f->primed = false;
+}
+
+uint16_t adc_filter_iir_step(adc_filter_iir_t *f, uint16_t x)
+{
+    /*The first sample initializes the output to avoid a slow start from 0*/
+    if (!f->primed)
+    {
+        f->acc = (int32_t)x << f->shift;
+        f->primed = true;
+    }
+    else
+    {
+        f->acc += (int32_t)x - (f->acc >> f->shift);
+    }
+    return (uint16_t)(f->acc >> f->shift);
+}
+
+void adc_filter_iir_process(adc_filter_iir_t *f, const uint16_t *in, uint16_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = adc_filter_iir_step(f, in[i]);
+    }
+}
+
+/*********************
+*   CIC DECIMATOR
+*********************/
+void adc_filter_decim_init(adc_filter_decim_t *f, uint16_t ratio)
+{
+    f->acc = 0;
+    f->ratio = (ratio == 0) ? 1 : ratio;
+    f->count = 0;
+}
+
+size_t adc_filter_decim_process(adc_filter_decim_t *f, const uint16_t *in, uint16_t *out, size_t n)
+{
+    size_t written = 0;
+
+    /*Integrate 'ratio' samples and dump: one division per output sample.
+      Samples that do not complete an output stay in the accumulator*/
+    for (size_t i = 0; i < n; i++)
+    {
+        f->acc += in[i];
+        if (++f->count == f->ratio)
+        {
+            out[written++] = f->acc / f->ratio;
+            f->acc = 0;
+            f->count = 0;
+        }
+    }
+    return written;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+*@brief ADC Filter: fixed-point filters and decimation for ADC samples
+Integer-only filters with all of their state stored inside the filter
+structure, so they never allocate memory. Every filter can process a single
+sample (_step) or a whole block of samples in one call (_process). Blocks
+may be processed in place ('in' equal to 'out').
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADC_FILTER_MA_MAX       64      /*Longest moving average window*/
+#define ADC_FILTER_MEDIAN_MAX   15      /*Longest median window*/
+
+/*Moving average of the last 'len' samples*/
+typedef struct {
+    uint16_t window[ADC_FILTER_MA_MAX];
+    uint32_t sum;
+    uint8_t len;
+    uint8_t pos;
+    uint8_t count;
+} adc_filter_ma_t;
+
+/*Median of the last 'len' samples, 'len' should be odd*/
+typedef struct {
+    uint16_t window[ADC_FILTER_MEDIAN_MAX];     /*Samples in arrival order*/
+    uint16_t sorted[ADC_FILTER_MEDIAN_MAX];     /*Same samples kept sorted*/
+    uint8_t len;
+    uint8_t pos;
+    uint8_t count;
+} adc_filter_median_t;
+
+/*Single-pole IIR: y += (x - y) / 2^shift. The output is kept with 'shift'
+  fractional bits so small steps are not lost by the integer division*/
+typedef struct {
+    int32_t acc;
+    uint8_t shift;
+    bool primed;
+} adc_filter_iir_t;
+
+/*First order CIC (boxcar) decimator: outputs the average of every 'ratio'
+  consecutive samples*/
+typedef struct {
+    uint32_t acc;
+    uint16_t ratio;
+    uint16_t count;
+} adc_filter_decim_t;
+
+void adc_filter_ma_init(adc_filter_ma_t *f, uint8_t len);
+uint16_t adc_filter_ma_step(adc_filter_ma_t *f, uint16_t x);
+void adc_filter_ma_process(adc_filter_ma_t *f, const uint16_t *in, uint16_t *out, size_t n);
+
+void adc_filter_median_init(adc_filter_median_t *f, uint8_t len);
+uint16_t adc_filter_median_step(adc_filter_median_t *f, uint16_t x);
+void adc_filter_median_process(adc_filter_median_t *f, const uint16_t *in, uint16_t *out, size_t n);
+
+void adc_filter_iir_init(adc_filter_iir_t *f, uint8_t shift);
+uint16_t adc_filter_iir_step(adc_filter_iir_t *f, uint16_t x);
+void adc_filter_iir_process(adc_filter_iir_t *f, const uint16_t *in, uint16_t *out, size_t n);
+
+void adc_filter_decim_init(adc_filter_decim_t *f, uint16_t ratio);
+/*Returns the number of samples written to 'out' (at most n / ratio + 1)*/
+size_t adc_filter_decim_process(adc_filter_decim_t *f, const uint16_t *in, uint16_t *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,97 @@
+/***************************************************************************
+*@brief ADC mV LUT: cached raw to millivolts conversion
+***************************************************************************/
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "adc_mv_lut.h"
+
+static const char *TAG = "adc_mv_lut";
+
+/*Full scale voltage of each attenuation: Vref (1100 mV) times the attenuation*/
+static uint32_t full_scale_mv(adc_atten_t atten)
+{
+    switch (atten)
+    {
+    case ADC_ATTEN_DB_0:
+        return 1100;
+    case ADC_ATTEN_DB_2_5:
+        return 1467;
+    case ADC_ATTEN_DB_6:
+        return 2200;
+    default:
+        return 3905;
+    }
+}
+
+uint16_t adc_mv_lut_reference(adc_atten_t atten, uint16_t raw)
+{
+    /*Rounded to the nearest millivolt*/
+    return (uint16_t)((raw * full_scale_mv(atten) + (ADC_MV_LUT_SIZE - 1) / 2) / (ADC_MV_LUT_SIZE - 1));
+}
+
+/*Creates the calibration scheme supported by the target*/
+static esp_err_t create_cali_scheme(adc_unit_t unit, adc_channel_t channel, adc_atten_t atten, adc_cali_handle_t *handle)
+{
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cali_config = {
+        .unit_id = unit,
+        .chan = channel,
+        .atten = atten,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    return adc_cali_create_scheme_curve_fitting(&cali_config, handle);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_config = {
+        .unit_id = unit,
+        .atten = atten,
+        .bitwidth = ADC_BITWIDTH_12,
+        .default_vref = 1100,   /*Used by ESP32 chips without Vref in eFuse*/
+    };
+    return adc_cali_create_scheme_line_fitting(&cali_config, handle);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static void delete_cali_scheme(adc_cali_handle_t handle)
+{
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_delete_scheme_curve_fitting(handle);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_delete_scheme_line_fitting(handle);
+#endif
+}
+
+esp_err_t adc_mv_lut_build(adc_mv_lut_t *lut, adc_unit_t unit, adc_channel_t channel, adc_atten_t atten)
+{
+    adc_cali_handle_t handle = NULL;
+    int voltage = 0;
+
+    ESP_RETURN_ON_FALSE(lut, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    lut->calibrated = (create_cali_scheme(unit, channel, atten, &handle) == ESP_OK);
+    if (!lut->calibrated)
+    {
+        ESP_LOGW(TAG, "No calibration data in eFuse, using the reference formula");
+    }
+
+    for (uint32_t raw = 0; raw < ADC_MV_LUT_SIZE; raw++)
+    {
+        if (lut->calibrated && adc_cali_raw_to_voltage(handle, raw, &voltage) == ESP_OK)
+        {
+            lut->mv[raw] = (uint16_t)voltage;
+        }
+        else
+        {
+            lut->mv[raw] = adc_mv_lut_reference(atten, raw);
+        }
+    }
+
+    if (handle)
+    {
+        delete_cali_scheme(handle);
+    }
+    return ESP_OK;
+}
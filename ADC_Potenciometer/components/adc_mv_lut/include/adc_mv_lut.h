@@ -0,0 +1,41 @@
+/***************************************************************************
+*@brief ADC mV LUT: cached raw to millivolts conversion
+The calibration scheme from adc_cali (curve fitting or line fitting, the one
+supported by the target) is evaluated once for every raw value and stored in
+a table, so converting a sample to millivolts is a single memory load.
+If the eFuse has no calibration data, the ideal (reference) formula is used.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "hal/adc_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADC_MV_LUT_BITS     12                      /*Resolution of the raw values*/
+#define ADC_MV_LUT_SIZE     (1 << ADC_MV_LUT_BITS)  /*One entry per raw value*/
+
+typedef struct {
+    uint16_t mv[ADC_MV_LUT_SIZE];   /*Millivolts of every raw value*/
+    bool calibrated;                /*false when the reference formula was used*/
+} adc_mv_lut_t;
+
+/*Fills the table for a channel, it must be built again if the attenuation changes*/
+esp_err_t adc_mv_lut_build(adc_mv_lut_t *lut, adc_unit_t unit, adc_channel_t channel, adc_atten_t atten);
+
+/*Ideal conversion of a raw value (no calibration) for an attenuation*/
+uint16_t adc_mv_lut_reference(adc_atten_t atten, uint16_t raw);
+
+/*Conversion on the hot path: one load*/
+static inline uint16_t adc_mv_lut_get(const adc_mv_lut_t *lut, uint16_t raw)
+{
+    return lut->mv[raw & (ADC_MV_LUT_SIZE - 1)];
+}
+
+#ifdef __cplusplus
+}
+#endif
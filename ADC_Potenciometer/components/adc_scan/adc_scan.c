@@ -0,0 +1,288 @@
+/***************************************************************************
+*@brief ADC Scan: multi-channel scan sequencer
+***************************************************************************/
+#include <stdlib.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "adc_filter.h"
+#include "adc_scan.h"
+
+#define CHANNEL_FIELD_VALUES    16      /*Channel numbers that fit in the 4 bits of a result*/
+#define NO_SLOT                 0xFF
+
+static const char *TAG = "adc_scan";
+
+typedef struct {
+    uint16_t ring[ADC_SCAN_RING_LEN];   /*Decimated samples of the channel*/
+    uint32_t head;                      /*Samples ever written, the ring index is head % LEN*/
+    uint32_t frame_start;               /*head when the current frame started*/
+    bool use_median;
+    bool use_ma;
+    bool use_iir;
+    adc_filter_median_t median;
+    adc_filter_decim_t decim;
+    adc_filter_ma_t ma;
+    adc_filter_iir_t iir;
+} adc_scan_slot_t;
+
+struct adc_scan_t {
+    adc_stream_handle_t stream;
+    adc_scan_update_cb_t on_update;
+    void *arg;
+    uint8_t channel_count;
+    uint8_t slot_of_channel[CHANNEL_FIELD_VALUES];  /*Channel number -> index in the table*/
+    adc_scan_slot_t slots[ADC_SCAN_MAX_CHANNELS];
+
+    /*Snapshot published with a sequence lock: odd while it is being written*/
+    atomic_uint sequence;
+    _Atomic uint16_t latest[ADC_SCAN_MAX_CHANNELS];
+};
+
+static void adc_scan_stream_frame(const uint8_t *frame, uint32_t len, void *arg)
+{
+    adc_scan_process_frame((adc_scan_handle_t)arg, frame, len);
+}
+
+/*********************
+*   PUBLIC API
+*********************/
+esp_err_t adc_scan_new(const adc_scan_config_t *config, adc_scan_handle_t *ret_scan)
+{
+    esp_err_t ret = ESP_OK;
+    adc_stream_channel_t stream_channels[ADC_SCAN_MAX_CHANNELS];
+
+    ESP_RETURN_ON_FALSE(config && ret_scan && config->channels, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->channel_count > 0 && config->channel_count <= ADC_SCAN_MAX_CHANNELS,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid channel count");
+
+    adc_scan_handle_t scan = calloc(1, sizeof(struct adc_scan_t));
+    ESP_RETURN_ON_FALSE(scan, ESP_ERR_NO_MEM, TAG, "no memory for scan");
+    scan->on_update = config->on_update;
+    scan->arg = config->arg;
+    scan->channel_count = config->channel_count;
+    atomic_init(&scan->sequence, 0);
+
+    for (uint8_t i = 0; i < CHANNEL_FIELD_VALUES; i++)
+    {
+        scan->slot_of_channel[i] = NO_SLOT;
+    }
+
+    for (uint8_t i = 0; i < config->channel_count; i++)
+    {
+        const adc_scan_channel_t *channel = &config->channels[i];
+        adc_scan_slot_t *slot = &scan->slots[i];
+
+        ESP_GOTO_ON_FALSE(channel->channel < CHANNEL_FIELD_VALUES && scan->slot_of_channel[channel->channel] == NO_SLOT,
+                          ESP_ERR_INVALID_ARG, err, TAG, "channel %d is invalid or repeated", channel->channel);
+        scan->slot_of_channel[channel->channel] = i;
+        atomic_init(&scan->latest[i], 0);
+
+        slot->use_median = channel->filter.median_len > 1;
+        slot->use_ma = channel->filter.ma_len > 1;
+        slot->use_iir = channel->filter.iir_shift > 0;
+        adc_filter_median_init(&slot->median, channel->filter.median_len);
+        adc_filter_decim_init(&slot->decim, channel->rate_div);
+        adc_filter_ma_init(&slot->ma, channel->filter.ma_len);
+        adc_filter_iir_init(&slot->iir, channel->filter.iir_shift);
+
+        stream_channels[i].channel = channel->channel;
+        stream_channels[i].atten = channel->atten;
+    }
+
+    /*One pattern with every channel of the table*/
+    adc_stream_config_t stream_config = {
+        .channels = stream_channels,
+        .channel_count = config->channel_count,
+        .sample_freq_hz = config->sample_freq_hz,
+        .frame_samples = config->frame_samples,
+        .buffer_frames = config->buffer_frames,
+        .on_frame = adc_scan_stream_frame,
+        .arg = scan,
+        .task_priority = config->task_priority,
+        .task_stack = config->task_stack,
+    };
+    ESP_GOTO_ON_ERROR(adc_stream_new(&stream_config, &scan->stream), err, TAG, "stream was not created");
+
+    *ret_scan = scan;
+    return ESP_OK;
+
+err:
+    free(scan);
+    return ret;
+}
+
+esp_err_t adc_scan_start(adc_scan_handle_t scan)
+{
+    ESP_RETURN_ON_FALSE(scan, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return adc_stream_start(scan->stream);
+}
+
+esp_err_t adc_scan_stop(adc_scan_handle_t scan)
+{
+    ESP_RETURN_ON_FALSE(scan, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return adc_stream_stop(scan->stream);
+}
+
+esp_err_t adc_scan_delete(adc_scan_handle_t scan)
+{
+    ESP_RETURN_ON_FALSE(scan, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (scan->stream)
+    {
+        adc_stream_delete(scan->stream);
+    }
+    free(scan);
+    return ESP_OK;
+}
+
+esp_err_t adc_scan_get_stream_stats(adc_scan_handle_t scan, adc_stream_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(scan, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return adc_stream_get_stats(scan->stream, stats);
+}
+
+/*********************
+*   DEMULTIPLEXER
+*********************/
+/*Runs the smoothing filters over the samples stored since the frame started,
+  it takes two blocks when the new samples wrap around the end of the ring*/
+static uint16_t smooth_new_samples(adc_scan_slot_t *slot)
+{
+    uint32_t count = slot->head - slot->frame_start;
+    uint32_t start = 0;
+
+    if (count > ADC_SCAN_RING_LEN)
+    {
+        count = ADC_SCAN_RING_LEN;
+    }
+    start = (slot->head - count) & (ADC_SCAN_RING_LEN - 1);
+
+    while (count > 0)
+    {
+        uint32_t block = ADC_SCAN_RING_LEN - start;
+        uint16_t *samples = &slot->ring[start];
+
+        if (block > count)
+        {
+            block = count;
+        }
+        if (slot->use_ma)
+        {
+            adc_filter_ma_process(&slot->ma, samples, samples, block);
+        }
+        if (slot->use_iir)
+        {
+            adc_filter_iir_process(&slot->iir, samples, samples, block);
+        }
+        count -= block;
+        start = 0;
+    }
+    return slot->ring[(slot->head - 1) & (ADC_SCAN_RING_LEN - 1)];
+}
+
+void adc_scan_process_frame(adc_scan_handle_t scan, const uint8_t *frame, uint32_t len)
+{
+    uint32_t samples = adc_stream_sample_count(len);
+    uint16_t decimated = 0;
+
+    for (uint8_t i = 0; i < scan->channel_count; i++)
+    {
+        scan->slots[i].frame_start = scan->slots[i].head;
+    }
+
+    /*Every result is read from the DMA frame and stored in the ring of its channel*/
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        uint8_t index = scan->slot_of_channel[adc_stream_sample_channel(frame, i)];
+        if (index == NO_SLOT)
+        {
+            continue;
+        }
+
+        adc_scan_slot_t *slot = &scan->slots[index];
+        uint16_t value = adc_stream_sample_value(frame, i);
+        if (slot->use_median)
+        {
+            value = adc_filter_median_step(&slot->median, value);
+        }
+        if (adc_filter_decim_process(&slot->decim, &value, &decimated, 1))
+        {
+            slot->ring[slot->head & (ADC_SCAN_RING_LEN - 1)] = decimated;
+            slot->head++;
+        }
+    }
+
+    /*Publish the new values: the sequence is odd while they are written*/
+    unsigned sequence = atomic_load_explicit(&scan->sequence, memory_order_relaxed);
+    atomic_store_explicit(&scan->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (uint8_t i = 0; i < scan->channel_count; i++)
+    {
+        adc_scan_slot_t *slot = &scan->slots[i];
+        if (slot->head != slot->frame_start)
+        {
+            atomic_store_explicit(&scan->latest[i], smooth_new_samples(slot), memory_order_relaxed);
+        }
+    }
+    atomic_store_explicit(&scan->sequence, sequence + 2, memory_order_release);
+
+    if (scan->on_update)
+    {
+        scan->on_update(scan, scan->arg);
+    }
+}
+
+/*********************
+*   READERS
+*********************/
+void adc_scan_read(adc_scan_handle_t scan, adc_scan_snapshot_t *snapshot)
+{
+    unsigned before = 0;
+    unsigned after = 0;
+
+    /*Retry while the writer was publishing during the copy*/
+    do
+    {
+        before = atomic_load_explicit(&scan->sequence, memory_order_acquire);
+        for (uint8_t i = 0; i < scan->channel_count; i++)
+        {
+            snapshot->value[i] = atomic_load_explicit(&scan->latest[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&scan->sequence, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    snapshot->sequence = before / 2;
+}
+
+esp_err_t adc_scan_latest(adc_scan_handle_t scan, uint8_t index, uint16_t *value)
+{
+    ESP_RETURN_ON_FALSE(scan && value, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(index < scan->channel_count, ESP_ERR_INVALID_ARG, TAG, "channel index %u out of the table",
+                        index);
+
+    *value = atomic_load_explicit(&scan->latest[index], memory_order_relaxed);
+    return ESP_OK;
+}
+
+uint32_t adc_scan_history(adc_scan_handle_t scan, uint8_t index, uint16_t *out, uint32_t n)
+{
+    if (index >= scan->channel_count)
+    {
+        return 0;
+    }
+    const adc_scan_slot_t *slot = &scan->slots[index];
+
+    if (n > ADC_SCAN_RING_LEN)
+    {
+        n = ADC_SCAN_RING_LEN;
+    }
+    if (n > slot->head)
+    {
+        n = slot->head;
+    }
+    for (uint32_t i = 0; i < n; i++)
+    {
+        out[i] = slot->ring[(slot->head - n + i) & (ADC_SCAN_RING_LEN - 1)];
+    }
+    return n;
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+*@brief ADC Scan: multi-channel scan sequencer
+All the channels of a table are converted by one continuous (DMA) pattern.
+Every frame is demultiplexed straight from the DMA frame into a ring buffer
+per channel: each sample goes through the channel median filter and rate
+divisor (decimation) before being stored. The new samples of every ring are
+then smoothed (moving average and/or IIR) and the latest value of every
+channel is published in a snapshot that can be read without locks.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "adc_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADC_SCAN_MAX_CHANNELS   ADC_STREAM_MAX_CHANNELS
+#define ADC_SCAN_RING_LEN       256     /*Decimated samples kept per channel, power of two*/
+
+typedef struct adc_scan_t *adc_scan_handle_t;
+
+/*Filter stages of a channel, 0 disables a stage*/
+typedef struct {
+    uint8_t median_len;         /*Median window applied to every raw sample*/
+    uint8_t ma_len;             /*Moving average applied after the rate divisor*/
+    uint8_t iir_shift;          /*IIR applied after the moving average*/
+} adc_scan_filter_t;
+
+typedef struct {
+    adc_channel_t channel;
+    adc_atten_t atten;
+    uint16_t rate_div;          /*Raw samples averaged into one stored sample*/
+    adc_scan_filter_t filter;
+} adc_scan_channel_t;
+
+/*Called from the stream task after every frame has been demultiplexed*/
+typedef void (*adc_scan_update_cb_t)(adc_scan_handle_t scan, void *arg);
+
+typedef struct {
+    const adc_scan_channel_t *channels;
+    uint8_t channel_count;
+    uint32_t sample_freq_hz;    /*Conversions per second shared by all the channels*/
+    uint32_t frame_samples;     /*Conversions (of all the channels) per frame*/
+    uint32_t buffer_frames;
+    adc_scan_update_cb_t on_update;
+    void *arg;
+    UBaseType_t task_priority;
+    uint32_t task_stack;
+} adc_scan_config_t;
+
+typedef struct {
+    uint16_t value[ADC_SCAN_MAX_CHANNELS];  /*Latest filtered value, same order as the channel table*/
+    uint32_t sequence;                      /*Increases every time new values are published*/
+} adc_scan_snapshot_t;
+
+esp_err_t adc_scan_new(const adc_scan_config_t *config, adc_scan_handle_t *ret_scan);
+esp_err_t adc_scan_start(adc_scan_handle_t scan);
+esp_err_t adc_scan_stop(adc_scan_handle_t scan);
+esp_err_t adc_scan_delete(adc_scan_handle_t scan);
+esp_err_t adc_scan_get_stream_stats(adc_scan_handle_t scan, adc_stream_stats_t *stats);
+
+/*Demultiplexes and filters a frame. It is the consumer of the stream frames
+  and it can also be fed with recorded frames*/
+void adc_scan_process_frame(adc_scan_handle_t scan, const uint8_t *frame, uint32_t len);
+
+/*Lock-free read of the latest values of every channel (from any task)*/
+void adc_scan_read(adc_scan_handle_t scan, adc_scan_snapshot_t *snapshot);
+
+/*Lock-free read of the latest value of one channel of the table,
+  ESP_ERR_INVALID_ARG for an index beyond the table*/
+esp_err_t adc_scan_latest(adc_scan_handle_t scan, uint8_t index, uint16_t *value);
+
+/*Copies up to 'n' of the newest stored samples of a channel, oldest first, and
+  none for an index beyond the table. Must be called from the on_update callback
+  (the stream task)*/
+uint32_t adc_scan_history(adc_scan_handle_t scan, uint8_t index, uint16_t *out, uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
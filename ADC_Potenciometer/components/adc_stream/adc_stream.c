@@ -0,0 +1,231 @@
+/***************************************************************************
+*@brief ADC Stream: continuous (DMA) ADC sampling
+***************************************************************************/
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_adc/adc_continuous.h"
+#include "adc_stream.h"
+
+#define STAMP_LEN   32      /*Completion times kept for the frames not read yet, power of two*/
+/*Wait for a frame notified but not stored yet, in whole ticks (1 ms is 0 ticks at
+  100 Hz): two, as a one tick timeout can expire at the very next tick interrupt*/
+#define LATE_FRAME_MS   (2 * portTICK_PERIOD_MS)
+
+static const char *TAG = "adc_stream";
+
+struct adc_stream_t {
+    adc_continuous_handle_t handle;     /*Driver that owns the DMA and the ring buffer*/
+    TaskHandle_t task;                  /*Task that hands the frames to the consumer*/
+    adc_stream_frame_cb_t on_frame;
+    void *arg;
+    uint8_t *frame;                     /*Frame read from the driver ring buffer*/
+    uint32_t frame_bytes;
+    volatile uint32_t frames;
+    volatile uint32_t overflows;
+
+    /*64 bit times are not written in one store: the ISR and the readers use the lock*/
+    portMUX_TYPE lock;
+    uint32_t completed;                 /*Frames completed by the DMA*/
+    int64_t stamps[STAMP_LEN];          /*Completion time of every frame, indexed by its number*/
+    uint32_t next;                      /*Number of the next frame read from the driver*/
+    int64_t last_frame_us;              /*Completion time of the frame handed to the consumer*/
+};
+
+/*********************
+*   DRIVER CALLBACKS
+*********************/
+/*A frame has been completed by the DMA: wake up the stream task*/
+static bool IRAM_ATTR adc_stream_conv_done(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data)
+{
+    adc_stream_handle_t stream = (adc_stream_handle_t)user_data;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    portENTER_CRITICAL_ISR(&stream->lock);
+    stream->stamps[stream->completed & (STAMP_LEN - 1)] = esp_timer_get_time();
+    stream->completed++;
+    portEXIT_CRITICAL_ISR(&stream->lock);
+    vTaskNotifyGiveFromISR(stream->task, &xHigherPriorityTaskWoken);
+    return xHigherPriorityTaskWoken == pdTRUE;
+}
+
+/*The ring buffer was full and the driver dropped a frame*/
+static bool IRAM_ATTR adc_stream_pool_ovf(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data)
+{
+    adc_stream_handle_t stream = (adc_stream_handle_t)user_data;
+
+    stream->overflows++;
+    return false;
+}
+
+/*********************
+*   STREAM TASK
+*********************/
+static void adc_stream_task(void *pvParameters)
+{
+    adc_stream_handle_t stream = (adc_stream_handle_t)pvParameters;
+    uint32_t len = 0;
+    uint32_t completed = 0;
+    uint32_t overflows = 0;
+    uint32_t timeout_ms = 0;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        /*Hand every stored frame to the consumer before sleeping again*/
+        while (1)
+        {
+            portENTER_CRITICAL(&stream->lock);
+            completed = stream->completed;
+            portEXIT_CRITICAL(&stream->lock);
+
+            if (adc_continuous_read(stream->handle, stream->frame, stream->frame_bytes, &len, timeout_ms) != ESP_OK)
+            {
+                /*After an overflow the frame numbers are synchronized again: every frame
+                  completed before the failed read was handed over or dropped*/
+                if (stream->overflows != overflows)
+                {
+                    overflows = stream->overflows;
+                    stream->next = completed;
+                    break;
+                }
+                /*on_conv_done can run before the driver stores the frame: a frame
+                  completed and not read yet is waited for once*/
+                if (timeout_ms == 0 && completed != stream->next)
+                {
+                    timeout_ms = LATE_FRAME_MS;
+                    continue;
+                }
+                timeout_ms = 0;
+                break;
+            }
+            timeout_ms = 0;
+
+            /*Frames are read in order, so the frame number selects its completion time*/
+            portENTER_CRITICAL(&stream->lock);
+            if (stream->completed - stream->next <= STAMP_LEN)
+            {
+                stream->last_frame_us = stream->stamps[stream->next & (STAMP_LEN - 1)];
+            }
+            stream->frames++;
+            portEXIT_CRITICAL(&stream->lock);
+            stream->next++;
+
+            stream->on_frame(stream->frame, len, stream->arg);
+        }
+    }
+}
+
+/*********************
+*   PUBLIC API
+*********************/
+esp_err_t adc_stream_new(const adc_stream_config_t *config, adc_stream_handle_t *ret_stream)
+{
+    esp_err_t ret = ESP_OK;
+    adc_stream_handle_t stream = NULL;
+
+    ESP_RETURN_ON_FALSE(config && ret_stream && config->on_frame, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->channels && config->channel_count > 0 && config->channel_count <= ADC_STREAM_MAX_CHANNELS,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid channel table");
+    ESP_RETURN_ON_FALSE(config->frame_samples > 0 && config->buffer_frames > 0, ESP_ERR_INVALID_ARG, TAG, "invalid frame size");
+
+    stream = calloc(1, sizeof(struct adc_stream_t));
+    ESP_RETURN_ON_FALSE(stream, ESP_ERR_NO_MEM, TAG, "no memory for stream");
+    stream->on_frame = config->on_frame;
+    stream->arg = config->arg;
+    portMUX_INITIALIZE(&stream->lock);
+
+    /*The driver only accepts frames made of whole DMA conversions*/
+    stream->frame_bytes = config->frame_samples * ADC_STREAM_SAMPLE_BYTES;
+    stream->frame_bytes += (SOC_ADC_DIGI_DATA_BYTES_PER_CONV - stream->frame_bytes % SOC_ADC_DIGI_DATA_BYTES_PER_CONV) % SOC_ADC_DIGI_DATA_BYTES_PER_CONV;
+    stream->frame = malloc(stream->frame_bytes);
+    ESP_GOTO_ON_FALSE(stream->frame, ESP_ERR_NO_MEM, err, TAG, "no memory for frame");
+
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = stream->frame_bytes * config->buffer_frames,
+        .conv_frame_size = stream->frame_bytes,
+    };
+    ESP_GOTO_ON_ERROR(adc_continuous_new_handle(&handle_config, &stream->handle), err, TAG, "driver handle failed");
+
+    /*One pattern entry per channel, all of them in ADC1*/
+    adc_digi_pattern_config_t pattern[ADC_STREAM_MAX_CHANNELS] = {0};
+    for (uint8_t i = 0; i < config->channel_count; i++)
+    {
+        pattern[i].unit = ADC_UNIT_1;
+        pattern[i].channel = config->channels[i].channel;
+        pattern[i].atten = config->channels[i].atten;
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    adc_continuous_config_t dig_config = {
+        .pattern_num = config->channel_count,
+        .adc_pattern = pattern,
+        .sample_freq_hz = config->sample_freq_hz,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_STREAM_OUTPUT_FORMAT,
+    };
+    ESP_GOTO_ON_ERROR(adc_continuous_config(stream->handle, &dig_config), err, TAG, "driver config failed");
+
+    ESP_GOTO_ON_FALSE(xTaskCreate(adc_stream_task, "adc_stream", config->task_stack, stream,
+                                  config->task_priority, &stream->task) == pdPASS,
+                      ESP_ERR_NO_MEM, err, TAG, "stream task was not created");
+
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = adc_stream_conv_done,
+        .on_pool_ovf = adc_stream_pool_ovf,
+    };
+    ESP_GOTO_ON_ERROR(adc_continuous_register_event_callbacks(stream->handle, &cbs, stream), err, TAG, "callbacks failed");
+
+    *ret_stream = stream;
+    return ESP_OK;
+
+err:
+    adc_stream_delete(stream);
+    return ret;
+}
+
+esp_err_t adc_stream_start(adc_stream_handle_t stream)
+{
+    ESP_RETURN_ON_FALSE(stream, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return adc_continuous_start(stream->handle);
+}
+
+esp_err_t adc_stream_stop(adc_stream_handle_t stream)
+{
+    ESP_RETURN_ON_FALSE(stream, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return adc_continuous_stop(stream->handle);
+}
+
+/*The stream must be stopped (or never started) before deleting it*/
+esp_err_t adc_stream_delete(adc_stream_handle_t stream)
+{
+    ESP_RETURN_ON_FALSE(stream, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    if (stream->handle)
+    {
+        adc_continuous_deinit(stream->handle);
+    }
+    if (stream->task)
+    {
+        vTaskDelete(stream->task);
+    }
+    free(stream->frame);
+    free(stream);
+    return ESP_OK;
+}
+
+esp_err_t adc_stream_get_stats(adc_stream_handle_t stream, adc_stream_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(stream && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    portENTER_CRITICAL(&stream->lock);
+    stats->frames = stream->frames;
+    stats->overflows = stream->overflows;
+    stats->last_frame_us = stream->last_frame_us;
+    portEXIT_CRITICAL(&stream->lock);
+    return ESP_OK;
+}
@@ -0,0 +1,92 @@
+/***************************************************************************
+*@brief ADC Stream: continuous (DMA) ADC sampling
+The adc_continuous driver converts the configured channels at a fixed rate
+and stores the results in its own ring buffer. Every time a frame is
+completed the stream task is woken up and hands all the stored frames to a
+consumer callback, so no conversion blocks the CPU.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "hal/adc_types.h"
+#include "soc/soc_caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADC_STREAM_MAX_CHANNELS     SOC_ADC_PATT_LEN_MAX        /*Channels that fit in one conversion pattern*/
+#define ADC_STREAM_SAMPLE_BYTES     SOC_ADC_DIGI_RESULT_BYTES   /*Bytes used by each conversion result*/
+
+typedef struct adc_stream_t *adc_stream_handle_t;
+
+/*Consumer of raw frames. 'frame' holds 'len' bytes of conversion results and
+  is only valid until the callback returns*/
+typedef void (*adc_stream_frame_cb_t)(const uint8_t *frame, uint32_t len, void *arg);
+
+typedef struct {
+    adc_channel_t channel;      /*ADC1 channel to be converted*/
+    adc_atten_t atten;          /*Attenuation (input range) of the channel*/
+} adc_stream_channel_t;
+
+typedef struct {
+    const adc_stream_channel_t *channels;   /*Channels converted one after the other in the pattern*/
+    uint8_t channel_count;
+    uint32_t sample_freq_hz;                /*Conversions per second, shared between all channels*/
+    uint32_t frame_samples;                 /*Conversions handed to the consumer per frame*/
+    uint32_t buffer_frames;                 /*Frames the driver can store before overflowing*/
+    adc_stream_frame_cb_t on_frame;         /*Consumer called from the stream task*/
+    void *arg;                              /*Argument passed to the consumer*/
+    UBaseType_t task_priority;
+    uint32_t task_stack;                    /*Stack of the stream task in bytes*/
+} adc_stream_config_t;
+
+typedef struct {
+    uint32_t frames;            /*Frames delivered to the consumer*/
+    uint32_t overflows;         /*Times the driver ring buffer was full and lost data*/
+    int64_t last_frame_us;      /*esp_timer time when the DMA completed the last frame handed to the consumer*/
+} adc_stream_stats_t;
+
+esp_err_t adc_stream_new(const adc_stream_config_t *config, adc_stream_handle_t *ret_stream);
+esp_err_t adc_stream_start(adc_stream_handle_t stream);
+esp_err_t adc_stream_stop(adc_stream_handle_t stream);
+esp_err_t adc_stream_delete(adc_stream_handle_t stream);
+esp_err_t adc_stream_get_stats(adc_stream_handle_t stream, adc_stream_stats_t *stats);
+
+/*********************
+*   FRAME PARSING
+*********************/
+/*ESP32 and ESP32-S2 use the TYPE1 output format, the rest of targets TYPE2*/
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_STREAM_OUTPUT_FORMAT    ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_STREAM_RESULT(p)        ((p)->type1)
+#else
+#define ADC_STREAM_OUTPUT_FORMAT    ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_STREAM_RESULT(p)        ((p)->type2)
+#endif
+
+/*Number of conversion results stored in a frame of 'len' bytes*/
+static inline uint32_t adc_stream_sample_count(uint32_t len)
+{
+    return len / ADC_STREAM_SAMPLE_BYTES;
+}
+
+/*Raw value of the conversion 'i' of a frame*/
+static inline uint16_t adc_stream_sample_value(const uint8_t *frame, uint32_t i)
+{
+    const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&frame[i * ADC_STREAM_SAMPLE_BYTES];
+    return ADC_STREAM_RESULT(p).data;
+}
+
+/*Channel of the conversion 'i' of a frame*/
+static inline uint8_t adc_stream_sample_channel(const uint8_t *frame, uint32_t i)
+{
+    const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&frame[i * ADC_STREAM_SAMPLE_BYTES];
+    return ADC_STREAM_RESULT(p).channel;
+}
+
+#ifdef __cplusplus
+}
+#endif
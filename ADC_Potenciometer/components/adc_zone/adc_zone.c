@@ -0,0 +1,75 @@
+/***************************************************************************
+*@brief ADC Zone: zone detection with hysteresis
+***************************************************************************/
+#include "adc_zone.h"
+
+void adc_zone_init(adc_zone_t *detector, const adc_zone_config_t *config)
+{
+    detector->config = *config;
+    detector->stats = (adc_zone_stats_t){0};
+    detector->zone = 0;
+    detector->primed = false;
+}
+
+/*Zone of a value without hysteresis*/
+static uint8_t zone_of(const adc_zone_config_t *config, uint16_t value)
+{
+    uint8_t zone = 0;
+
+    while (zone < config->edge_count && value >= config->edges[zone])
+    {
+        zone++;
+    }
+    return zone;
+}
+
+bool adc_zone_update(adc_zone_t *detector, uint16_t value)
+{
+    const adc_zone_config_t *config = &detector->config;
+    uint8_t zone = detector->zone;
+    bool first = !detector->primed;
+
+    if (first)
+    {
+        /*The first value always produces an event so the outputs get initialized*/
+        zone = zone_of(config, value);
+    }
+    else
+    {
+        /*Move up while the next edge is passed by more than the hysteresis...*/
+        while (zone < config->edge_count && value >= config->edges[zone] + config->hysteresis)
+        {
+            zone++;
+        }
+        /*...or down while the value is far enough below the current edge*/
+        while (zone > 0 && value + config->hysteresis < config->edges[zone - 1])
+        {
+            zone--;
+        }
+    }
+
+    if (zone == detector->zone && !first)
+    {
+        detector->stats.suppressed++;
+        return false;
+    }
+
+    adc_zone_event_t event = {
+        .from = detector->zone,
+        .to = zone,
+        .value = value,
+    };
+
+    /*The zone only changes once the subscriber has the event: when the queue is
+      full the detector stays in the zone the subscriber knows, and the next
+      value beyond the edge sends the transition again*/
+    if (config->subscriber && xQueueSend(config->subscriber, &event, 0) != pdPASS)
+    {
+        detector->stats.dropped_events++;
+        return false;
+    }
+    detector->zone = zone;
+    detector->primed = true;
+    detector->stats.transitions++;
+    return true;
+}
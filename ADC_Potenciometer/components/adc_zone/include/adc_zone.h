@@ -0,0 +1,65 @@
+/***************************************************************************
+*@brief ADC Zone: zone detection with hysteresis
+A table of ascending edges splits the ADC range in zones (zone 0 is below
+the first edge). To leave its zone, a value has to cross the edge by more
+than the hysteresis, so noise around an edge does not toggle the zone.
+An event is sent to the subscriber queue only when the zone changes, and
+the zone only changes when the event was sent: with the queue full the
+transition is sent again by the next value, so the subscriber never misses
+the current zone.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const uint16_t *edges;      /*Ascending lower edge of zones 1..edge_count*/
+    uint8_t edge_count;
+    uint16_t hysteresis;        /*Distance beyond an edge needed to change zone*/
+    QueueHandle_t subscriber;   /*Queue of adc_zone_event_t, may be NULL*/
+} adc_zone_config_t;
+
+typedef struct {
+    uint8_t from;               /*Previous zone*/
+    uint8_t to;                 /*New zone*/
+    uint16_t value;             /*Value that caused the transition*/
+} adc_zone_event_t;
+
+typedef struct {
+    uint32_t transitions;       /*Updates that changed the zone*/
+    uint32_t suppressed;        /*Updates that kept the same zone (nothing was done)*/
+    uint32_t dropped_events;    /*Transitions delayed because the subscriber queue was full*/
+} adc_zone_stats_t;
+
+typedef struct {
+    adc_zone_config_t config;
+    adc_zone_stats_t stats;
+    uint8_t zone;
+    bool primed;                /*false until the first value is received*/
+} adc_zone_t;
+
+void adc_zone_init(adc_zone_t *detector, const adc_zone_config_t *config);
+
+/*Returns true when 'value' moved the detector to another zone (and the event was sent)*/
+bool adc_zone_update(adc_zone_t *detector, uint16_t value);
+
+static inline uint8_t adc_zone_current(const adc_zone_t *detector)
+{
+    return detector->zone;
+}
+
+static inline adc_zone_stats_t adc_zone_get_stats(const adc_zone_t *detector)
+{
+    return detector->stats;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,51 @@
+/***************************************************************************
+*@brief PWM Taper: ADC value to PWM duty transfer table
+The transfer curve (taper) is evaluated once for every 12-bit input value
+and stored in a table, so mapping an ADC value to a duty cycle is a single
+memory load with no division or floating point on the hot path.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWM_TAPER_BITS      12                      /*Resolution of the input values*/
+#define PWM_TAPER_SIZE      (1 << PWM_TAPER_BITS)   /*One entry per input value*/
+
+typedef enum {
+    PWM_TAPER_LINEAR,       /*duty proportional to the input*/
+    PWM_TAPER_GAMMA,        /*duty = max * x^gamma, corrects the eye response*/
+    PWM_TAPER_LOG,          /*duty = (max + 1)^x - 1, like a log potenciometer*/
+} pwm_taper_curve_t;
+
+typedef struct {
+    uint16_t duty[PWM_TAPER_SIZE];
+} pwm_taper_lut_t;
+
+/*'gamma' is only used by PWM_TAPER_GAMMA, 'max_duty' is the duty of the full scale input*/
+esp_err_t pwm_taper_build(pwm_taper_lut_t *lut, pwm_taper_curve_t curve, float gamma, uint32_t max_duty);
+
+/*Duty of an input shifted by 'offset' (used to blend several channels from
+  one input), inputs out of the table are clamped*/
+static inline uint16_t pwm_taper_get(const pwm_taper_lut_t *lut, int32_t input, int32_t offset)
+{
+    int32_t index = input - offset;
+
+    if (index < 0)
+    {
+        index = 0;
+    }
+    else if (index >= PWM_TAPER_SIZE)
+    {
+        index = PWM_TAPER_SIZE - 1;
+    }
+    return lut->duty[index];
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,37 @@
+/***************************************************************************
+*@brief PWM Taper: ADC value to PWM duty transfer table
+***************************************************************************/
+#include <math.h>
+#include "esp_check.h"
+#include "pwm_taper.h"
+
+static const char *TAG = "pwm_taper";
+
+esp_err_t pwm_taper_build(pwm_taper_lut_t *lut, pwm_taper_curve_t curve, float gamma, uint32_t max_duty)
+{
+    ESP_RETURN_ON_FALSE(lut && max_duty <= UINT16_MAX, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(curve != PWM_TAPER_GAMMA || gamma > 0.0f, ESP_ERR_INVALID_ARG, TAG, "invalid gamma");
+
+    /*Floating point is only used here, once at init*/
+    for (uint32_t i = 0; i < PWM_TAPER_SIZE; i++)
+    {
+        float x = (float)i / (PWM_TAPER_SIZE - 1);
+        float duty = 0.0f;
+
+        switch (curve)
+        {
+        case PWM_TAPER_GAMMA:
+            duty = max_duty * powf(x, gamma);
+            break;
+        case PWM_TAPER_LOG:
+            duty = powf(max_duty + 1.0f, x) - 1.0f;
+            break;
+        case PWM_TAPER_LINEAR:
+        default:
+            duty = max_duty * x;
+            break;
+        }
+        lut->duty[i] = (uint16_t)(duty + 0.5f);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,110 @@
+/***************************************************************************
+*@brief Benchmarks of the ADC processing path
+***************************************************************************/
+#include <stdio.h>
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "adc_filter.h"
+#include "gpio_bank.h"
+#include "benchmark.h"
+
+#define BENCH_SAMPLES   1000    /*Samples processed by every benchmark block*/
+#define BENCH_UPDATES   1000    /*Updates of the output pins*/
+
+static const char *TAG = "Benchmark";
+
+static uint16_t benchIn[BENCH_SAMPLES];
+static uint16_t benchOut[BENCH_SAMPLES];
+
+/*Synthetic potenciometer signal: a slow ramp with +-64 counts of noise*/
+static void fill_noisy_signal(void)
+{
+    uint32_t seed = 12345;
+
+    for (size_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        seed = seed * 1664525 + 1013904223;     /*LCG, enough for noise*/
+        int value = (int)(i * 4) + (int)(seed >> 25) - 64;
+        benchIn[i] = (value < 0) ? 0 : (value > 4095 ? 4095 : value);
+    }
+}
+
+static void report(const char *name, uint32_t cycles)
+{
+    ESP_LOGI(TAG, "%-12s %5lu cycles/sample", name, (unsigned long)(cycles / BENCH_SAMPLES));
+}
+
+/*********************
+*   FILTERS
+*********************/
+esp_err_t benchmark_filters(void)
+{
+    adc_filter_ma_t ma;
+    adc_filter_median_t median;
+    adc_filter_iir_t iir;
+    adc_filter_decim_t decim;
+    uint32_t start;
+
+    fill_noisy_signal();
+
+    adc_filter_ma_init(&ma, 16);
+    start = esp_cpu_get_cycle_count();
+    adc_filter_ma_process(&ma, benchIn, benchOut, BENCH_SAMPLES);
+    report("ma(16)", esp_cpu_get_cycle_count() - start);
+
+    adc_filter_median_init(&median, 5);
+    start = esp_cpu_get_cycle_count();
+    adc_filter_median_process(&median, benchIn, benchOut, BENCH_SAMPLES);
+    report("median(5)", esp_cpu_get_cycle_count() - start);
+
+    adc_filter_iir_init(&iir, 2);
+    start = esp_cpu_get_cycle_count();
+    adc_filter_iir_process(&iir, benchIn, benchOut, BENCH_SAMPLES);
+    report("iir(>>2)", esp_cpu_get_cycle_count() - start);
+
+    adc_filter_decim_init(&decim, 50);
+    start = esp_cpu_get_cycle_count();
+    adc_filter_decim_process(&decim, benchIn, benchOut, BENCH_SAMPLES);
+    report("decim(50)", esp_cpu_get_cycle_count() - start);
+
+    return ESP_OK;
+}
+
+/*********************
+*   GPIO BANK
+*********************/
+/*Pins must be configured as outputs, they toggle between all ON and all OFF*/
+esp_err_t benchmark_gpio_bank(const gpio_num_t *pins, uint8_t count)
+{
+    gpio_bank_t bank;
+    gpio_bank_state_t states[2];
+    uint32_t start;
+
+    if (gpio_bank_init(&bank, pins, count) != ESP_OK)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gpio_bank_prepare(&bank, 0, &states[0]);
+    gpio_bank_prepare(&bank, count >= 32 ? UINT32_MAX : (1UL << count) - 1, &states[1]);
+
+    start = esp_cpu_get_cycle_count();
+    for (uint32_t i = 0; i < BENCH_UPDATES; i++)
+    {
+        for (uint8_t p = 0; p < count; p++)
+        {
+            gpio_set_level(pins[p], i & 1);
+        }
+    }
+    ESP_LOGI(TAG, "%-12s %5lu cycles/update", "set_level", (unsigned long)((esp_cpu_get_cycle_count() - start) / BENCH_UPDATES));
+
+    start = esp_cpu_get_cycle_count();
+    for (uint32_t i = 0; i < BENCH_UPDATES; i++)
+    {
+        gpio_bank_apply(&states[i & 1]);
+    }
+    ESP_LOGI(TAG, "%-12s %5lu cycles/update", "bank_apply", (unsigned long)((esp_cpu_get_cycle_count() - start) / BENCH_UPDATES));
+
+    gpio_bank_apply(&states[0]);
+    return ESP_OK;
+}
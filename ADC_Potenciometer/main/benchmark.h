@@ -0,0 +1,12 @@
+/***************************************************************************
+*@brief Benchmarks of the ADC processing path
+Each benchmark runs on the target, measures CPU cycles with
+esp_cpu_get_cycle_count() and prints the results with ESP_LOGI.
+***************************************************************************/
+#pragma once
+
+#include "esp_err.h"
+#include "hal/gpio_types.h"
+
+esp_err_t benchmark_filters(void);      /*Cycles per sample of every filter in adc_filter*/
+esp_err_t benchmark_gpio_bank(const gpio_num_t *pins, uint8_t count);  /*Cycles per update of a group of output pins*/
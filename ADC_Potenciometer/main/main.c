@@ -1,145 +1,396 @@
 /***************************************************************************
 *@brief ADC with Pternciometer and RGB LEDs
 This project will let you to manipulate RGB LEDs level from a
-potenciometer, which will be read using the ADC peripheral.
-Expected behavior:  ADC from 0 to 999     -> All LEDS OFF
-                    ADC from 1000 to 1999 -> LED Red ON
-                    ADC from 2000 to 2999 -> LED Red-Green ON
-                    ADC from 3000 to 3999 -> LED Red-Green-Blue ON
-                    ADC from 4000 to 4095 -> All LEDS OFF
+potenciometer, which will be read using the ADC peripheral in continuous
+(DMA) mode. The scan sequencer converts every channel of 'adcChannels' and
+filters each one with a median filter (removes spikes), a decimator and an
+IIR filter to obtain a stable ADC value. The Potenciometer value is
+converted to millivolts with the calibration table of the channel.
+Expected behavior (LED_MODE_ZONES): LEDs are only written (and logged) when
+the value moves to another zone.
+                    ADC from 0 to 749 mV     -> All LEDS OFF
+                    ADC from 750 to 1499 mV  -> LED Red ON
+                    ADC from 1500 to 2249 mV -> LED Red-Green ON
+                    ADC from 2250 to 2999 mV -> LED Red-Green-Blue ON
+                    ADC from 3000 mV         -> All LEDS OFF
+Expected behavior (LED_MODE_PWM): the brightness of every LED follows the
+Potenciometer through the PWM transfer table. Green and Blue are shifted
+by an offset, so Red starts at the beginning of the turn, Green at 1/3 and
+Blue at 2/3. With the gamma curve the color never reaches White: at the end
+of the turn Red is at 100 %, Green at ~41 % and Blue at ~9 % of the duty, so
+the knob blends the color from dim Red to Orange. Frames are shortened to
+0.5 ms, so the oldest sample of a frame reaches the duty in less than 1 ms
+(the latency report counts the updates over that target). The report is
+only stored as a deferred record by the ADC task, a low priority task prints
+it.
 ***************************************************************************/
 #include <stdio.h>
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
-#include "freertos/timers.h"
+#include "adc_scan.h"
+#include "adc_mv_lut.h"
+#include "adc_zone.h"
+#include "pwm_taper.h"
+#include "gpio_bank.h"
+#include "board_init.h"
 #include "driver/ledc.h"
-#include "driver/adc.h"
+#include "esp_timer.h"
+#include "deferred_log.h"
+#include "benchmark.h"
 
 #define ledR    33      /*LED Red connected to PIN 33 from MCU*/
 #define ledG    25      /*LED Green connected to PIN 25 from MCU*/
 #define ledB    26      /*LED Blue connected to PIN 26 from MCU*/
 
+#define LED_MODE_ZONES  0   /*LEDs ON/OFF by zones of the Potenciometer*/
+#define LED_MODE_PWM    1   /*LEDs brightness proportional to the Potenciometer*/
+#define LED_MODE        LED_MODE_ZONES
+
+#define ADC_SAMPLE_FREQ_KHZ 20      /*Conversions per second in kHz (20 kHz is the minimum on ESP32)*/
+#if LED_MODE == LED_MODE_PWM
+#define ADC_FRAME_US        500     /*Short frames: the duty follows the knob with less than 1 ms of latency*/
+#define ADC_BUFFER_FRAMES   16      /*Frames the driver can store if the consumer is late*/
+#else
+#define ADC_FRAME_US        50000   /*Microseconds of samples processed every time a frame is completed*/
+#define ADC_BUFFER_FRAMES   4
+#endif
+#define ADC_FRAME_SAMPLES   (ADC_SAMPLE_FREQ_KHZ * ADC_FRAME_US / 1000)
+#define POT_CHANNEL         ADC_CHANNEL_4   /*Remember: GPIO32 from MCU is ADC1 CH4*/
+#define POT_ATTEN           ADC_ATTEN_DB_12 /*Input range up to ~3100 mV for the whole Potenciometer turn*/
+#define ZONE_HYSTERESIS_MV  40      /*Millivolts beyond an edge needed to change the LEDs zone*/
+#define ZONE_QUEUE_LEN      8       /*Zone changes waiting to be applied to the LEDs*/
+
+#define MEDIAN_LEN          5       /*Samples in the median window used to remove spikes*/
+#if LED_MODE == LED_MODE_PWM
+#define DECIMATION          ADC_FRAME_SAMPLES   /*One decimated sample per frame, so no sample waits for the next frame*/
+#else
+#define DECIMATION          50      /*Samples averaged into each decimated sample (20 kHz / channels / 50)*/
+#endif
+#define IIR_SHIFT           2       /*IIR smoothing: each new sample weights 1/2^IIR_SHIFT*/
+
+#define PWM_CURVE           PWM_TAPER_GAMMA /*Taper of the transfer table: LINEAR, GAMMA or LOG*/
+#define PWM_GAMMA           2.2f    /*Gamma used by PWM_TAPER_GAMMA*/
+#define PWM_MAX_DUTY        1023    /*PWM is set as 10 bit resolution, so equals to 1023 as max value*/
+#define LATENCY_REPORT      2000    /*PWM updates between every latency report (1 s with 0.5 ms frames)*/
+#define LATENCY_TARGET_US   1000    /*Oldest sample of a frame to duty set*/
+#define TO_TEXT(x)          #x
+#define VALUE_TEXT(x)       TO_TEXT(x)  /*Value of a macro as a string literal*/
+
+#define LED_R   (1 << 0)    /*Bits of the LEDs turned ON in every zone (order of ledPins)*/
+#define LED_G   (1 << 1)
+#define LED_B   (1 << 2)
+#define ZONES   5           /*Zones defined by zoneEdges*/
+
+#define STACK_SIZE 1024*2    /*Number of bytes the stack will hold*/
+#define LOG_RING_LENGTH     16      /*Deferred records that can wait to be printed, a power of two*/
+#define LOG_FLUSH_PERIOD    100     /*Miliseconds between prints of the pending records*/
+#define LOG_STACK_SIZE      1024*3  /*printf() of the flush task*/
+#define LOG_PRIORITY        1       /*Below the ADC stream task*/
+
+#define RUN_BENCHMARKS      0       /*Set to 1 to measure the cycles of the filters and LEDs updates at startup*/
+
 static const char *TAG = "Main";    /*Tag for the LOGS mns in terminal*/
 
-TimerHandle_t xTimers;  /*Variable for Timer task that stores the configuration to be set*/
-int interval = 50;      /*Miliseconds before Timer callback executes*/
-int timerId = 1;        /*ID for the Timer Task created*/
+adc_scan_handle_t adcScan;          /*Continuous ADC that scans every channel of the table*/
 int adc_val = 0;        /*ADC value obtained from Potenciometer*/
+int adc_mv = 0;         /*ADC value converted to millivolts*/
+adc_mv_lut_t adcLut;    /*Calibrated millivolts of every raw ADC value*/
+
+QueueHandle_t ZoneQueue = 0;    /*Zone changes sent from the ADC to the LEDS task*/
+adc_zone_t zoneDetector;
+
+static const gpio_num_t ledPins[] = { ledR, ledG, ledB };
+gpio_bank_t ledBank;                    /*Red, Green and Blue LEDs updated at once*/
+gpio_bank_state_t zoneStates[ZONES];    /*Register masks of the LEDs of every zone*/
+
+/*Lower edge (mV) of every zone, zone 0 goes from 0 mV to the first edge*/
+static const uint16_t zoneEdges[] = { 750, 1500, 2250, 3000 };
+
+/*LEDs turned ON in every zone*/
+static const uint8_t zoneLeds[ZONES] = {
+    0,                      /*Zone 0: All LEDS OFF*/
+    LED_R,                  /*Zone 1: LED Red ON*/
+    LED_R | LED_G,          /*Zone 2: LED Red-Green ON*/
+    LED_R | LED_G | LED_B,  /*Zone 3: LED Red-Green-Blue ON*/
+    0,                      /*Zone 4: All LEDS OFF*/
+};
+
+pwm_taper_lut_t pwmLut;         /*Duty of every raw ADC value*/
+int64_t latencyMax = 0;         /*Worst time (us) from the oldest sample of a frame to the new duty*/
+int64_t latencySum = 0;
+uint32_t latencyCount = 0;
+uint32_t latencyMissed = 0;     /*Updates over LATENCY_TARGET_US*/
+deferred_log_t AdcLog;          /*Latency reports of the ADC task, printed by the flush task*/
+static deferred_log_slot_t adcLogStorage[LOG_RING_LENGTH];
+
+/*PWM channel of every LED, the offset (raw ADC counts) shifts the LED in the transfer table*/
+typedef struct {
+    ledc_channel_t channel;
+    int gpio;
+    int32_t offset;
+} pwm_led_t;
+
+static const pwm_led_t pwmLeds[] = {
+    { LEDC_CHANNEL_0, ledR, 0 },
+    { LEDC_CHANNEL_1, ledG, 1365 },
+    { LEDC_CHANNEL_2, ledB, 2730 },
+};
+
+/*Channels converted by the ADC, add a line per Potenciometer or sensor*/
+enum { POT_INDEX };     /*Index of every channel in the table*/
+static const adc_scan_channel_t adcChannels[] = {
+    [POT_INDEX] = {
+        .channel = POT_CHANNEL,
+        .atten = POT_ATTEN,
+        .rate_div = DECIMATION,
+        .filter = { .median_len = MEDIAN_LEN, .iir_shift = IIR_SHIFT },
+    },
+};
 
 /**********************
 * Function Prototypes
 **********************/
-void vTimerCallback( TimerHandle_t pxTimer );
+void adc_update_callback(adc_scan_handle_t scan, void *arg);
 void app_main(void);
-esp_err_t set_timer(void);      /*Timers task created in here*/
-esp_err_t set_adc(void);        /*ADC configurations: Channel, Attenuation and Resolution*/ 
+esp_err_t set_adc(void);        /*ADC configurations: Channels, Attenuation, Filters, Sample rate and Frames*/ 
+esp_err_t set_zones(void);      /*Zone detector and task that updates the LEDs on every zone change*/
+void vTask_LEDS(void *pvParameters);
 esp_err_t init_led(void);       /*Setting LEDS directions and inital level*/
+esp_err_t set_pwm(void);        /*Cofigures every PWM setting of each LED and the transfer table*/
+esp_err_t set_pwm_duty(int value);  /*Sets the duty cycle of each LED from an ADC value*/
+esp_err_t create_log(void);     /*Flush task of the deferred latency reports*/
 
 /*******************************
 *   CONFIGURATION SET SECTION
 *******************************/
 void app_main(void)
 {
+#if LED_MODE == LED_MODE_PWM
+    create_log();
+    set_pwm();
+#else
     init_led();
-    set_timer();
+    set_zones();
+#endif
+#if RUN_BENCHMARKS
+    benchmark_filters();
+    benchmark_gpio_bank(ledPins, sizeof(ledPins) / sizeof(ledPins[0]));
+#endif
     set_adc();
 }
 
 /*********************
-*   TIMER SECTION
+*   ADC SECTION
 *********************/
-esp_err_t set_timer(void)
-{
-    ESP_LOGI(TAG, "Timer init configuration");
-    xTimers = xTimerCreate("Timer",         // Just a text name, not used by the kernel.
-                              (pdMS_TO_TICKS(interval)), // The timer period in ticks.
-                              pdTRUE,          // The timers will auto-reload themselves when they expire.
-                              (void *)timerId,       // Assign each timer a unique id equal to its array index.
-                              vTimerCallback   // Each timer calls the same callback when it expires.
-    );
+/*Executed by the ADC stream task every time a frame has been filtered*/
+void adc_update_callback(adc_scan_handle_t scan, void *arg){
+    uint16_t latest = 0;
+
+    if (adc_scan_latest(scan, POT_INDEX, &latest) != ESP_OK)
+    {
+        return;     /*POT_INDEX is not in the channel table*/
+    }
+    adc_val = latest;
 
-    if (xTimers == NULL)
+#if LED_MODE == LED_MODE_PWM
+    adc_stream_stats_t stats;
+
+    set_pwm_duty(adc_val);
+
+    /*Latency from the first sample of the frame (one frame before the DMA
+      completed it) to the new duty being set*/
+    adc_scan_get_stream_stats(scan, &stats);
+    int64_t latency = esp_timer_get_time() - stats.last_frame_us + ADC_FRAME_US;
+    latencySum += latency;
+    if (latency > latencyMax)
     {
-        ESP_LOGE(TAG, "Timer was not created");
+        latencyMax = latency;
     }
-    else
+    if (latency > LATENCY_TARGET_US)
     {
-        if (xTimerStart(xTimers, 0) != pdPASS)
-        {
-            ESP_LOGE(TAG, "The timer could not be set into the Active state.");
-        }
+        latencyMissed++;
     }
-    return ESP_OK;
-}
-
-void vTimerCallback( TimerHandle_t pxTimer ){
-    adc_val = adc1_get_raw(ADC1_CHANNEL_4);         /*Remember: GPIO32 from MCU is ADC CH4*/
-    ESP_LOGI(TAG, "ADC Raw Value: %d", adc_val);
-    
-    int adc_case = adc_val / 1000;  /*Raw ADC value divided by 1000 (4095/1000) to obtained 4 differents brightness cases*/
-
-    switch (adc_case)
-    {
-    case 0:
-        gpio_set_level(ledR, 0);
-        gpio_set_level(ledG, 0);
-        gpio_set_level(ledB, 0);
-        break;
-    case 1:
-        gpio_set_level(ledR, 1);
-        gpio_set_level(ledG, 0);
-        gpio_set_level(ledB, 0);
-        break;
-    case 2:
-        gpio_set_level(ledR, 1);
-        gpio_set_level(ledG, 1);
-        gpio_set_level(ledB, 0);
-        break;
-    case 3:
-        gpio_set_level(ledR, 1);
-        gpio_set_level(ledG, 1);
-        gpio_set_level(ledB, 1);
-        break;            
-    default:
-        gpio_set_level(ledR, 0);
-        gpio_set_level(ledG, 0);
-        gpio_set_level(ledB, 0);
-        break;
+    if (++latencyCount == LATENCY_REPORT)
+    {
+        /*Stored without formatting, the ADC task does not wait for the UART*/
+        DEFERRED_LOG(&AdcLog, "Sample to duty latency: avg %lu us, max %lu us, over "
+                     VALUE_TEXT(LATENCY_TARGET_US) " us: %lu/%lu",
+                     (uint32_t)(latencySum / latencyCount), (uint32_t)latencyMax, latencyMissed, latencyCount);
+        latencyMax = 0;
+        latencySum = 0;
+        latencyCount = 0;
+        latencyMissed = 0;
     }
+#else
+    adc_mv = adc_mv_lut_get(&adcLut, adc_val);
 
+    /*LEDs and logs are only updated by vTask_LEDS when the zone changes*/
+    adc_zone_update(&zoneDetector, adc_mv);
+#endif
 }
 
 /*********************
-*   ADC SECTION
+*   ZONES SECTION
 *********************/
-esp_err_t set_adc(void){
+esp_err_t set_zones(void){
+    ZoneQueue = xQueueCreate(ZONE_QUEUE_LEN, sizeof(adc_zone_event_t));
+    if (ZoneQueue == NULL)
+    {
+        ESP_LOGE(TAG, "Zone queue was not created");
+        return ESP_ERR_NO_MEM;
+    }
+
+    adc_zone_config_t config = {
+        .edges = zoneEdges,
+        .edge_count = sizeof(zoneEdges) / sizeof(zoneEdges[0]),
+        .hysteresis = ZONE_HYSTERESIS_MV,
+        .subscriber = ZoneQueue,
+    };
+    adc_zone_init(&zoneDetector, &config);
 
-    adc2_config_channel_atten(ADC2_CHANNEL_4, ADC_ATTEN_DB_0);
-    adc1_config_width(ADC_WIDTH_BIT_12);
+    /*Register masks of every zone are computed once*/
+    for (uint8_t i = 0; i < ZONES; i++)
+    {
+        gpio_bank_prepare(&ledBank, zoneLeds[i], &zoneStates[i]);
+    }
 
+    if (xTaskCreate(vTask_LEDS, "vTask_LEDS", STACK_SIZE, NULL, 1, NULL) != pdPASS)
+    {
+        ESP_LOGE(TAG, "LEDS task was not created");
+        return ESP_ERR_NO_MEM;
+    }
     return ESP_OK;
 }
 
+/*Task that sets the LEDs of every new zone, it sleeps while the zone does not change*/
+void vTask_LEDS(void *pvParameters)
+{
+    adc_zone_event_t event;
+
+    while (1)
+    {
+        if (xQueueReceive(ZoneQueue, &event, portMAX_DELAY))
+        {
+            gpio_bank_apply(&zoneStates[event.to]);
+
+            adc_zone_stats_t stats = adc_zone_get_stats(&zoneDetector);
+            ESP_LOGI(TAG, "Zone %u -> %u at %u mV (transitions: %lu, suppressed: %lu)",
+                     event.from, event.to, event.value,
+                     (unsigned long)stats.transitions, (unsigned long)stats.suppressed);
+        }
+    }
+}
+
+esp_err_t set_adc(void){
+    /*Calibration is computed once for every raw value before sampling starts*/
+    esp_err_t ret = adc_mv_lut_build(&adcLut, ADC_UNIT_1, POT_CHANNEL, POT_ATTEN);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "ADC calibration table was not built");
+        return ret;
+    }
+    ESP_LOGI(TAG, "ADC calibration: %s", adcLut.calibrated ? "eFuse" : "reference formula");
+
+    adc_scan_config_t config = {
+        .channels = adcChannels,
+        .channel_count = sizeof(adcChannels) / sizeof(adcChannels[0]),
+        .sample_freq_hz = ADC_SAMPLE_FREQ_KHZ * 1000,
+        .frame_samples = ADC_FRAME_SAMPLES,
+        .buffer_frames = ADC_BUFFER_FRAMES,
+        .on_update = adc_update_callback,
+        .arg = NULL,
+        .task_priority = 2,
+        .task_stack = 1024*3,
+    };
+
+    ret = adc_scan_new(&config, &adcScan);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "ADC scan was not created");
+        return ret;
+    }
+
+    ret = adc_scan_start(adcScan);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "The ADC scan could not be started");
+    }
+    return ret;
+}
+
 /*********************
 *   LEDS SECTION
 *********************/
 esp_err_t init_led(void)
 {
-    gpio_reset_pin(ledR);
-    gpio_set_direction(ledR, GPIO_MODE_OUTPUT);
+    /*Every LED as output and initialized in LOW level with a single configuration*/
+    static const board_pin_t boardPins[] = {
+        { .pin = ledR, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+        { .pin = ledG, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+        { .pin = ledB, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+    };
 
-    gpio_reset_pin(ledG);
-    gpio_set_direction(ledG, GPIO_MODE_OUTPUT);
+    esp_err_t ret = board_init_pins(boardPins, sizeof(boardPins) / sizeof(boardPins[0]), NULL);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    return gpio_bank_init(&ledBank, ledPins, sizeof(ledPins) / sizeof(ledPins[0]));
+}
+
+/*********************
+*   PWM SECTION
+*********************/
+esp_err_t set_pwm(void){
+    /*Same LEDC settings used in PWM_LEDS: 10 bit resolution at 20 kHz*/
+    ledc_timer_config_t timerConfig = {0};
+    timerConfig.speed_mode = LEDC_HIGH_SPEED_MODE;
+    timerConfig.duty_resolution = LEDC_TIMER_10_BIT;
+    timerConfig.timer_num = LEDC_TIMER_0;
+    timerConfig.freq_hz = 20000; 
+
+    ledc_timer_config(&timerConfig);
 
-    gpio_reset_pin(ledB);
-    gpio_set_direction(ledB, GPIO_MODE_OUTPUT);
+    for (size_t i = 0; i < sizeof(pwmLeds) / sizeof(pwmLeds[0]); i++)
+    {
+        ledc_channel_config_t channelConfig = {0};
+        channelConfig.gpio_num = pwmLeds[i].gpio;
+        channelConfig.speed_mode = LEDC_HIGH_SPEED_MODE;
+        channelConfig.channel = pwmLeds[i].channel;
+        channelConfig.intr_type = LEDC_INTR_DISABLE;
+        channelConfig.timer_sel = LEDC_TIMER_0;
+        channelConfig.duty = 0;
 
-    /*Initialize each LED in LOW level*/
-    gpio_set_level(ledR, 0);
-    gpio_set_level(ledG, 0);
-    gpio_set_level(ledB, 0);
+        ledc_channel_config(&channelConfig);
+    }
 
+    /*Transfer table is computed once, every update is then a table load per LED*/
+    return pwm_taper_build(&pwmLut, PWM_CURVE, PWM_GAMMA, PWM_MAX_DUTY);
+}
+
+esp_err_t create_log(void)
+{
+    esp_err_t ret = deferred_log_init(&AdcLog, adcLogStorage, LOG_RING_LENGTH, DEFERRED_LOG_TEXT);
+    if (ret == ESP_OK)
+    {
+        ret = deferred_log_start(&AdcLog, "deferred_log", LOG_STACK_SIZE, LOG_PRIORITY, tskNO_AFFINITY,
+                                 LOG_FLUSH_PERIOD);
+    }
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Deferred log was not started");
+    }
+    return ret;
+}
+
+esp_err_t set_pwm_duty(int value){
+    for (size_t i = 0; i < sizeof(pwmLeds) / sizeof(pwmLeds[0]); i++)
+    {
+        ledc_set_duty(LEDC_HIGH_SPEED_MODE, pwmLeds[i].channel, pwm_taper_get(&pwmLut, value, pwmLeds[i].offset));
+        ledc_update_duty(LEDC_HIGH_SPEED_MODE, pwmLeds[i].channel);
+    }
     return ESP_OK;
-}
\ No newline at end of file
+}
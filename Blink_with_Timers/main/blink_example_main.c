@@ -12,9 +12,12 @@ status level of the LED will change to the opposite.
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "board_init.h"
 #include "freertos/timers.h"
+#include "log_rate.h"
 
 #define led 2 // GPIO 2 from MCU
+#define TIMER_LOG_PERIOD 10000  // Miliseconds between logs of the timer events, the blinks in between are counted
 
 static const char *TAG = "Main";
 
@@ -30,7 +33,7 @@ int interval = 1000;    //time in miliseconds
 int timerId = 1;
 
 void vTimerCallback( TimerHandle_t pxTimer ){
-    ESP_LOGI(TAG, "Event was called from timer");
+    LOG_EVERY_MS(TIMER_LOG_PERIOD, ESP_LOGI, TAG, "Event was called from timer");
     blink_led();
 }
 void app_main(void)
@@ -41,9 +44,11 @@ void app_main(void)
 
 esp_err_t init_led(void)
 {
-    gpio_reset_pin(led);
-    gpio_set_direction(led, GPIO_MODE_OUTPUT);
-    return ESP_OK;
+    static const board_pin_t ledPins[] = {
+        { .pin = led, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+    };
+
+    return board_init_pins(ledPins, sizeof(ledPins) / sizeof(ledPins[0]), NULL);
 }
 
 esp_err_t blink_led(void)
@@ -0,0 +1,263 @@
+/***************************************************************************
+*@brief Benchmarks of the signals between tasks
+***************************************************************************/
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_log.h"
+#include "task_signal.h"
+#include "event_dispatch.h"
+#include "benchmark.h"
+
+#define BENCH_SIGNALS   1000    /*Gives measured for every kind of signal*/
+#define BENCH_STACK     1024*3
+
+/*Dispatcher against polling: "sensor ready AND link up", the link comes up last*/
+#define BENCH_SENSOR_READY  (1 << 0)
+#define BENCH_LINK_UP       (1 << 1)
+#define BENCH_CONDITION     (BENCH_SENSOR_READY | BENCH_LINK_UP)
+#define BENCH_ROUNDS        20      /*Times the condition becomes true*/
+#define BENCH_ROUND_GAP     200     /*Miliseconds between rounds*/
+#define BENCH_POLL_PERIOD   10      /*Miliseconds between checks of the polling loop*/
+
+/*CPU used by the waiting task, needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS*/
+#if configGENERATE_RUN_TIME_STATS
+#define RUN_TIME_NOW()          ((uint32_t)portGET_RUN_TIME_COUNTER_VALUE())
+#define TASK_RUN_TIME(task)     ((uint32_t)ulTaskGetRunTimeCounter(task))
+#else
+#define RUN_TIME_NOW()          0
+#define TASK_RUN_TIME(task)     0
+#endif
+
+static const char *TAG = "Benchmark";
+
+typedef struct {
+    task_signal_t signal;
+    volatile uint32_t given;    /*Cycle count just before the give*/
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    TaskHandle_t caller;        /*Notified when every signal was measured*/
+} signal_bench_t;
+
+/*Runs above the giver on the same core, so every give switches to it right away.
+  Both timestamps come from the same core, its cycle counter is not shared*/
+static void waiter_task(void *pvParameters)
+{
+    signal_bench_t *bench = (signal_bench_t *)pvParameters;
+
+    for (uint32_t i = 0; i < BENCH_SIGNALS; i++)
+    {
+        task_signal_wait(&bench->signal, portMAX_DELAY);
+        uint32_t latency = esp_cpu_get_cycle_count() - bench->given;
+
+        bench->min = (latency < bench->min) ? latency : bench->min;
+        bench->max = (latency > bench->max) ? latency : bench->max;
+        bench->total += latency;
+    }
+    xTaskNotifyGive(bench->caller);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t measure(const char *name, task_signal_kind_t kind)
+{
+    static signal_bench_t bench;
+    TaskHandle_t waiter = NULL;
+
+    bench = (signal_bench_t) {
+        .min = UINT32_MAX,
+        .caller = xTaskGetCurrentTaskHandle(),
+    };
+    if (kind == TASK_SIGNAL_SEMAPHORE)
+    {
+        task_signal_init_semaphore(&bench.signal);
+    }
+    else
+    {
+        task_signal_init_notify(&bench.signal, NULL);
+    }
+
+    if (xTaskCreatePinnedToCore(waiter_task, "bench_waiter", BENCH_STACK, &bench, uxTaskPriorityGet(NULL) + 1,
+                                &waiter, xPortGetCoreID()) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Benchmark of %s could not start", name);
+        return ESP_ERR_NO_MEM;
+    }
+    task_signal_set_waiter(&bench.signal, waiter);
+
+    for (uint32_t i = 0; i < BENCH_SIGNALS; i++)
+    {
+        bench.given = esp_cpu_get_cycle_count();
+        task_signal_give(&bench.signal);        /*The waiter runs and waits again before this returns*/
+    }
+
+    /*The waiter notifies this task after its last measure*/
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (bench.signal.semaphore)
+    {
+        vSemaphoreDelete(bench.signal.semaphore);
+    }
+
+    ESP_LOGI(TAG, "%-9s give -> wake: min %lu avg %lu max %lu cycles", name, (unsigned long)bench.min,
+             (unsigned long)(bench.total / BENCH_SIGNALS), (unsigned long)bench.max);
+    return ESP_OK;
+}
+
+esp_err_t benchmark_signal_latency(void)
+{
+    esp_err_t err = measure("notify", TASK_SIGNAL_NOTIFY);
+
+    if (err == ESP_OK)
+    {
+        err = measure("semaphore", TASK_SIGNAL_SEMAPHORE);
+    }
+    return err;
+}
+
+/*************************************
+*   DISPATCHER AGAINST POLLING
+*************************************/
+typedef struct {
+    event_dispatch_t dispatcher;
+    EventGroupHandle_t group;       /*Polled event group*/
+    StaticEventGroup_t groupStorage;
+    volatile uint32_t completed;    /*Cycle count just before the last bit is set*/
+    uint32_t max;
+    uint64_t total;
+    uint32_t fired;                 /*Times the condition was seen true*/
+    uint32_t runtime;               /*Run time counts used by the task that waits for the condition*/
+    volatile bool polling;
+    TaskHandle_t caller;
+} dispatch_bench_t;
+
+static void record_wake(dispatch_bench_t *bench)
+{
+    uint32_t latency = esp_cpu_get_cycle_count() - bench->completed;
+
+    bench->max = (latency > bench->max) ? latency : bench->max;
+    bench->total += latency;
+    bench->fired++;
+}
+
+static void on_condition(EventBits_t bits, void *arg)
+{
+    record_wake((dispatch_bench_t *)arg);
+}
+
+/*What the firmware does today: check the condition, sleep a while and check again*/
+static void poller_task(void *pvParameters)
+{
+    dispatch_bench_t *bench = (dispatch_bench_t *)pvParameters;
+    uint32_t wakeups = 0;
+
+    while (bench->polling)
+    {
+        wakeups++;
+        if ((xEventGroupGetBits(bench->group) & BENCH_CONDITION) == BENCH_CONDITION)
+        {
+            xEventGroupClearBits(bench->group, BENCH_CONDITION);
+            record_wake(bench);
+        }
+        vTaskDelay(pdMS_TO_TICKS(BENCH_POLL_PERIOD));
+    }
+    bench->runtime = TASK_RUN_TIME(NULL);
+    xTaskNotify(bench->caller, wakeups, eSetValueWithOverwrite);
+    vTaskDelete(NULL);
+}
+
+/*Sensor ready first, the link some ticks later, so only the second set completes the condition*/
+static void run_rounds(dispatch_bench_t *bench, bool dispatched)
+{
+    for (uint32_t i = 0; i < BENCH_ROUNDS; i++)
+    {
+        if (dispatched)
+        {
+            event_dispatch_set(&bench->dispatcher, BENCH_SENSOR_READY);
+        }
+        else
+        {
+            xEventGroupSetBits(bench->group, BENCH_SENSOR_READY);
+        }
+        vTaskDelay(pdMS_TO_TICKS(BENCH_ROUND_GAP) / 2 + 1);
+
+        bench->completed = esp_cpu_get_cycle_count();
+        if (dispatched)
+        {
+            event_dispatch_set(&bench->dispatcher, BENCH_LINK_UP);
+        }
+        else
+        {
+            xEventGroupSetBits(bench->group, BENCH_LINK_UP);
+        }
+        vTaskDelay(pdMS_TO_TICKS(BENCH_ROUND_GAP) / 2 + 1);
+    }
+}
+
+/*'window' are the run time counts elapsed while the rounds ran*/
+static void report_wakes(const char *name, const dispatch_bench_t *bench, uint32_t wakeups, uint32_t window)
+{
+    uint32_t cyclesPerUs = esp_rom_get_cpu_ticks_per_us();
+    uint32_t fired = bench->fired ? bench->fired : 1;
+
+    ESP_LOGI(TAG, "%-10s %lu/%d conditions, wake latency avg %lu max %lu us, %lu wake ups (%lu.%02lu per condition)",
+             name, (unsigned long)bench->fired, BENCH_ROUNDS,
+             (unsigned long)(bench->total / fired / cyclesPerUs), (unsigned long)(bench->max / cyclesPerUs),
+             (unsigned long)wakeups, (unsigned long)(wakeups / fired), (unsigned long)(wakeups * 100 / fired % 100));
+#if configGENERATE_RUN_TIME_STATS
+    /*Thousandths of a percent of one core*/
+    uint32_t cpu = window ? (uint32_t)((uint64_t)bench->runtime * 100000 / window) : 0;
+    ESP_LOGI(TAG, "%-10s CPU %lu.%03lu %% of one core (%lu of %lu run time counts)", name,
+             (unsigned long)(cpu / 1000), (unsigned long)(cpu % 1000), (unsigned long)bench->runtime,
+             (unsigned long)window);
+#else
+    ESP_LOGI(TAG, "%-10s CPU n/a, enable CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS", name);
+#endif
+}
+
+esp_err_t benchmark_event_dispatch(void)
+{
+    static dispatch_bench_t bench;
+    static event_dispatch_entry_t entries[1];
+    UBaseType_t priority = uxTaskPriorityGet(NULL) + 1;
+    TaskHandle_t poller = NULL;
+    uint32_t start = 0;
+
+    /*Dispatcher: woken only when a bit arrives, the handler runs on the completing one*/
+    bench = (dispatch_bench_t) { .caller = xTaskGetCurrentTaskHandle() };
+    ESP_RETURN_ON_ERROR(event_dispatch_init(&bench.dispatcher, entries, 1), TAG, "dispatcher init failed");
+    ESP_RETURN_ON_ERROR(event_dispatch_register(&bench.dispatcher, BENCH_CONDITION, EVENT_DISPATCH_ALL, true,
+                                                on_condition, &bench), TAG, "handler not registered");
+    ESP_RETURN_ON_ERROR(event_dispatch_start(&bench.dispatcher, "bench_dispatch", BENCH_STACK, priority,
+                                             xPortGetCoreID()), TAG, "dispatcher not started");
+    start = RUN_TIME_NOW();
+    run_rounds(&bench, true);
+    bench.runtime = TASK_RUN_TIME(bench.dispatcher.task);
+    uint32_t window = RUN_TIME_NOW() - start;
+    event_dispatch_stop(&bench.dispatcher);
+    report_wakes("dispatcher", &bench, bench.dispatcher.wakeups, window);
+
+    /*Polling: woken every period whether something changed or not*/
+    bench = (dispatch_bench_t) { .caller = xTaskGetCurrentTaskHandle(), .polling = true };
+    bench.group = xEventGroupCreateStatic(&bench.groupStorage);
+    start = RUN_TIME_NOW();
+    if (xTaskCreatePinnedToCore(poller_task, "bench_poller", BENCH_STACK, &bench, priority, &poller,
+                                xPortGetCoreID()) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Benchmark of polling could not start");
+        return ESP_ERR_NO_MEM;
+    }
+    run_rounds(&bench, false);
+    vTaskDelay(pdMS_TO_TICKS(BENCH_POLL_PERIOD));   /*Lets the poller see the last round*/
+    bench.polling = false;
+
+    uint32_t wakeups = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &wakeups, portMAX_DELAY);
+    window = RUN_TIME_NOW() - start;
+    vEventGroupDelete(bench.group);
+    report_wakes("polling", &bench, wakeups, window);
+    return ESP_OK;
+}
@@ -0,0 +1,11 @@
+/***************************************************************************
+*@brief Benchmarks of the signals between tasks
+Each benchmark runs on the target, measures CPU cycles with
+esp_cpu_get_cycle_count() and prints the results with ESP_LOGI.
+***************************************************************************/
+#pragma once
+
+#include "esp_err.h"
+
+esp_err_t benchmark_signal_latency(void);   /*Cycles from a give until the waiting task runs, notify and semaphore*/
+esp_err_t benchmark_event_dispatch(void);   /*Wake latency, wake ups and CPU of a two bits condition, dispatcher and polling*/
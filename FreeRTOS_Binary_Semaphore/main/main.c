@@ -15,6 +15,9 @@ times too. You will see at the monitor device a LOG Informative (in green) a mns
 "Task G is working" when Key have just taken.
 "Task G is entering into sleep..." when Task G finished from executing.
 "Task G is sleeping" when there was no Key available to be taken.
+
+3. A dispatcher waits for both events of a round, "Key given" AND "Task G done", and
+logs "Round N complete" exactly once when the second one arrives, without polling.
 *******************************************************************************************/
 #include <stdio.h>
 #include "driver/gpio.h"
@@ -22,6 +25,12 @@ times too. You will see at the monitor device a LOG Informative (in green) a mns
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_check.h"
+#include "board_init.h"
+#include "task_registry.h"
+#include "task_signal.h"
+#include "event_dispatch.h"
+#include "benchmark.h"
 
 #define LEDR    33      /*LED Red connected to PIN 33 from MCU*/
 #define LEDG    25      /*LED Green connected to PIN 25 from MCU*/
@@ -30,10 +39,31 @@ times too. You will see at the monitor device a LOG Informative (in green) a mns
 #define LEDR_DELAY  10000   /*10 sec*/
 
 #define STACK_SIZE 1024*2    /*Number of bytes the stack will hold*/
+#define STACK_REPORT_PERIOD 0   /*Miliseconds between stack usage reports, 0 disables them*/
+#define RUN_BENCHMARKS      0   /*Set to 1 to measure the give to wake latency at startup*/
+
+#define KEY_MODE_NOTIFY     0   /*Key given with a notification straight to Task G*/
+#define KEY_MODE_SEMAPHORE  1   /*Key given through a Binary Semaphore*/
+#define KEY_MODE            KEY_MODE_NOTIFY
+
+/*Events of a round, the dispatcher runs its handler once both are set*/
+#define EVENT_KEY_GIVEN     (1 << 0)    /*Task R gave the Key*/
+#define EVENT_G_DONE        (1 << 1)    /*Task G finished its blinks*/
+#define EVENT_HANDLERS      1
+#define DISPATCH_STACK      1024*2
+#define DISPATCH_PRIORITY   1
+
+/*Task placement: WiFi and the timer daemon run on core 0, the LEDs I/O on the last core*/
+#define IO_CORE     (portNUM_PROCESSORS - 1)
+/*Task G above Task R, so it runs as soon as the Key is given*/
+#define LEDR_PRIORITY   2
+#define LEDG_PRIORITY   3
 
 static const char *TAG = "Main";    /*Tag for the LOGS mns in terminal*/
 
-SemaphoreHandle_t GlobalKey = 0;    /*Key that will be given or taken in Binary Semaphore*/
+task_signal_t GlobalKey;            /*Key that will be given by Task R or taken by Task G*/
+event_dispatch_t RoundEvents;       /*Wakes the round handler when every event of a round arrived*/
+static event_dispatch_entry_t roundHandlers[EVENT_HANDLERS];
 
 /**********************
 * Function Prototypes
@@ -44,14 +74,28 @@ void vTask_LEDG(void *pvParameters);    /*Task from LED GREEN created in here*/
 esp_err_t init_led(void);               /*Setting LEDS directions and inital level*/
 esp_err_t create_tasks(void);           /*Creating a Task for each LED*/         
 esp_err_t blink_indicator(int led);     /*Resource that makes blink a LED 8 times*/        
+esp_err_t create_dispatcher(void);      /*Handlers woken by combinations of events*/
+void round_complete(EventBits_t bits, void *arg);
 
 /*******************************
 *   MAIN AND INIFINITE LOOP
 *******************************/
 void app_main(void)
 {
-    GlobalKey = xSemaphoreCreateBinary();   /*Creating the Binary Semaphore*/
+#if RUN_BENCHMARKS
+    benchmark_signal_latency();
+    benchmark_event_dispatch();
+#endif
+#if KEY_MODE == KEY_MODE_SEMAPHORE
+    task_signal_init_semaphore(&GlobalKey);     /*Creating the Binary Semaphore*/
+#else
+    task_signal_init_notify(&GlobalKey, NULL);  /*Task G is known once created*/
+#endif
     init_led();
+    if (create_dispatcher() != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Round dispatcher was not started, rounds will not be logged");
+    }
     create_tasks();    
 }
 
@@ -60,17 +104,13 @@ void app_main(void)
 *********************/
 esp_err_t init_led(void)
 {
-    gpio_reset_pin( LEDR);
-    gpio_set_direction( LEDR, GPIO_MODE_OUTPUT);
+    /*Every LED as output and initialized in LOW level with a single configuration*/
+    static const board_pin_t ledPins[] = {
+        { .pin = LEDR, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+        { .pin = LEDG, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+    };
 
-    gpio_reset_pin( LEDG);
-    gpio_set_direction( LEDG, GPIO_MODE_OUTPUT);
-
-    /*Initialize each LED in LOW level*/
-    gpio_set_level(LEDR, 0);
-    gpio_set_level(LEDG, 0);
-
-    return ESP_OK;
+    return board_init_pins(ledPins, sizeof(ledPins) / sizeof(ledPins[0]), NULL);
 }
 
 /*Make LED blink 8 times to indicate when Task R gives the Key to Task G 
@@ -90,25 +130,51 @@ esp_err_t blink_indicator(int led){
 /*********************
 *   TASKS SECTION
 *********************/
+/*Every task with its own static stack and TCB, nothing is taken from the heap*/
+static const task_registry_entry_t taskTable[] = {
+    TASK_REGISTRY_PINNED(vTask_LEDR, "vTask_LEDR", STACK_SIZE, NULL, LEDR_PRIORITY, IO_CORE),
+    TASK_REGISTRY_PINNED(vTask_LEDG, "vTask_LEDG", STACK_SIZE, NULL, LEDG_PRIORITY, IO_CORE),
+};
+
+#define TASKS       (sizeof(taskTable) / sizeof(taskTable[0]))
+#define TASK_LEDG   1       /*Index of Task G in taskTable*/
+
+static TaskHandle_t taskHandles[TASKS];
+
 esp_err_t create_tasks(void){
-    static uint8_t ucParameterToPass;
-    TaskHandle_t xHandle = NULL;
-
-    /*Creating Task for LED RED*/
-    xTaskCreate( vTask_LEDR, 
-                "vTask_LEDR", 
-                STACK_SIZE, 
-                &ucParameterToPass, 
-                1, &xHandle );
-
-    /*Creating Task for LED GREEN*/
-    xTaskCreate( vTask_LEDG, 
-                "vTask_LEDG", 
-                STACK_SIZE, 
-                &ucParameterToPass, 
-                1, &xHandle );
+    esp_err_t err = task_registry_start(taskTable, TASKS, taskHandles);
 
-    return ESP_OK;
+    /*Task R blinks 8 times before its first give, Task G is known long before*/
+    task_signal_set_waiter(&GlobalKey, taskHandles[TASK_LEDG]);
+
+#if STACK_REPORT_PERIOD > 0
+    /*Diagnostic mode: report how much of every stack is really used*/
+    if (err == ESP_OK)
+    {
+        err = task_registry_monitor(taskTable, TASKS, taskHandles, STACK_REPORT_PERIOD);
+    }
+#endif
+    return err;
+}
+
+/*********************
+*   EVENTS SECTION
+*********************/
+esp_err_t create_dispatcher(void)
+{
+    ESP_RETURN_ON_ERROR(event_dispatch_init(&RoundEvents, roundHandlers, EVENT_HANDLERS), TAG, "dispatcher init failed");
+    /*Both events consumed, so the next round starts from zero*/
+    ESP_RETURN_ON_ERROR(event_dispatch_register(&RoundEvents, EVENT_KEY_GIVEN | EVENT_G_DONE, EVENT_DISPATCH_ALL, true,
+                                                round_complete, NULL), TAG, "round handler not registered");
+    return event_dispatch_start(&RoundEvents, "event_dispatch", DISPATCH_STACK, DISPATCH_PRIORITY, IO_CORE);
+}
+
+/*Runs in the dispatcher task*/
+void round_complete(EventBits_t bits, void *arg)
+{
+    static uint32_t rounds = 0;
+
+    ESP_LOGI(TAG, "Round %lu complete: Key given and Task G done", (unsigned long)++rounds);
 }
 
 /******************************
@@ -122,8 +188,9 @@ void vTask_LEDR(void *pvParameters)
     {
         blink_indicator(LEDR);                  /*Blink Red LED to see that Key was given*/
         ESP_LOGE(TAG, "Task R is giving the Key");
-        xSemaphoreGive(GlobalKey);              /*Task R gives Key (Binary Semaphore in '1')...
+        task_signal_give(&GlobalKey);           /*Task R gives Key (Binary Semaphore in '1')...
                                                 Once the Task gives the Key, it returns Binary Semmaphore to '0' inmediatly*/            
+        event_dispatch_set(&RoundEvents, EVENT_KEY_GIVEN);
         vTaskDelay(pdMS_TO_TICKS(LEDR_DELAY));  /*Delay to wait 10 seconds to give again the Key*/
     }    
 }
@@ -134,13 +201,14 @@ void vTask_LEDG(void *pvParameters)
     while (1)
     {
         /*Check if the key was given*/
-        if(xSemaphoreTake(GlobalKey, portMAX_DELAY)){       /*Wait a maximum of 12hrs without consuming CPU resources until the Key is given*/
+        if(task_signal_wait(&GlobalKey, portMAX_DELAY)){    /*Wait without consuming CPU resources until the Key is given*/
             ESP_LOGI(TAG, "Task G is working");      
             blink_indicator(LEDG);                          /*Indicator that Task G has taken the key*/
             ESP_LOGI(TAG, "Task G is entering into sleep...");
+            event_dispatch_set(&RoundEvents, EVENT_G_DONE);
        }
-        /*Task G is not working since Key is not given (Binary Semaphore in '0')*/
+        /*Task G is not working since Key is not given (Binary Semaphore in '0'), it
+          sleeps blocked in the wait, which already leaves the CPU to IDLE and the watchdog*/
         ESP_LOGI(TAG, "Task G is sleeping");
-        vTaskDelay(pdMS_TO_TICKS(100));   /*To avoid errors with Watchdog timer*/            
     }
 }
\ No newline at end of file
@@ -0,0 +1,292 @@
+/***************************************************************************
+*@brief Benchmarks of the access to a shared resource
+***************************************************************************/
+#include <stdio.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "resource_server.h"
+#include "fair_lock.h"
+#include "benchmark.h"
+
+#define BENCH_CLIENTS       2
+#define BENCH_REQUESTS      200     /*Uses of the resource by every client*/
+#define BENCH_RESOURCE_US   500     /*Time the resource works on every use*/
+#define BENCH_CLIENT_US     300     /*Work of the client between two uses*/
+#define BENCH_STACK         1024*3
+#define BENCH_OPERATION     0
+
+/*Adversarial periods: a greedy task on the last core takes the lock again right
+  after giving it, a slow one on core 0 asks once per tick*/
+#define BENCH_FAIR_MS       2000    /*Duration of every measure*/
+#define BENCH_HOLD_US       200     /*Time every task holds the lock*/
+
+static const char *TAG = "Benchmark";
+
+typedef struct client_bench client_bench_t;
+
+/*Every request of the server design, alive until the server completes it*/
+typedef struct {
+    client_bench_t *client;
+    int64_t started;                /*esp_timer time when the client asked for the resource*/
+} request_bench_t;
+
+struct client_bench {
+    SemaphoreHandle_t key;          /*Mutex design*/
+    resource_server_t *server;      /*Server design*/
+    uint32_t index;
+    request_bench_t requests[BENCH_REQUESTS];
+    int64_t maxLatency;             /*Microseconds from asking for the resource to the end of its use*/
+    int64_t latency;
+    int64_t maxBlocked;             /*Microseconds the client was blocked in a single take or post*/
+    int64_t blocked;
+    TaskHandle_t caller;            /*Notified when the client finished*/
+};
+
+/*What the resource does on every use, the same for both designs*/
+static esp_err_t busy_resource(uint32_t op, uint32_t arg, void *resource)
+{
+    esp_rom_delay_us(BENCH_RESOURCE_US);
+    return ESP_OK;
+}
+
+/*esp_timer is shared by the cores, the server and the clients run on different ones*/
+static void record(int64_t *max, int64_t *total, int64_t started)
+{
+    int64_t elapsed = esp_timer_get_time() - started;
+
+    *max = (elapsed > *max) ? elapsed : *max;
+    *total += elapsed;
+}
+
+/*Holds the mutex for the whole use of the resource*/
+static void mutex_client(void *pvParameters)
+{
+    client_bench_t *client = (client_bench_t *)pvParameters;
+
+    for (uint32_t i = 0; i < BENCH_REQUESTS; i++)
+    {
+        int64_t started = esp_timer_get_time();
+        xSemaphoreTake(client->key, portMAX_DELAY);
+        record(&client->maxBlocked, &client->blocked, started);
+        busy_resource(BENCH_OPERATION, client->index, NULL);
+        record(&client->maxLatency, &client->latency, started);
+        xSemaphoreGive(client->key);
+        esp_rom_delay_us(BENCH_CLIENT_US);
+    }
+    xTaskNotifyGive(client->caller);
+    vTaskDelete(NULL);
+}
+
+/*Runs in the server task once the resource was used for the request*/
+static void request_done(esp_err_t result, void *ctx)
+{
+    request_bench_t *request = (request_bench_t *)ctx;
+
+    record(&request->client->maxLatency, &request->client->latency, request->started);
+}
+
+/*Posts and goes on, it only blocks while the queue is full*/
+static void server_client(void *pvParameters)
+{
+    client_bench_t *client = (client_bench_t *)pvParameters;
+    resource_request_t request = {
+        .op = BENCH_OPERATION,
+        .done = request_done,
+    };
+
+    for (uint32_t i = 0; i < BENCH_REQUESTS; i++)
+    {
+        /*A different argument for every request, so none is coalesced and the
+          server does the same work as the mutex design*/
+        request.arg = client->index * BENCH_REQUESTS + i;
+        request.ctx = &client->requests[i];
+        /*Requests are completed in order, the last one tells when every use is done*/
+        request.client = (i == BENCH_REQUESTS - 1) ? xTaskGetCurrentTaskHandle() : NULL;
+
+        client->requests[i] = (request_bench_t) { .client = client, .started = esp_timer_get_time() };
+        resource_server_post(client->server, &request, portMAX_DELAY);
+        record(&client->maxBlocked, &client->blocked, client->requests[i].started);
+        esp_rom_delay_us(BENCH_CLIENT_US);
+    }
+    resource_server_wait(NULL, portMAX_DELAY);
+    xTaskNotifyGive(client->caller);
+    vTaskDelete(NULL);
+}
+
+/*Clients spread over the cores, the result once every client finished*/
+static esp_err_t run_clients(const char *name, TaskFunction_t clientTask, client_bench_t *clients, uint32_t *executed)
+{
+    int64_t started = esp_timer_get_time();
+
+    for (uint32_t i = 0; i < BENCH_CLIENTS; i++)
+    {
+        clients[i].index = i;
+        clients[i].caller = xTaskGetCurrentTaskHandle();
+        ESP_RETURN_ON_FALSE(xTaskCreatePinnedToCore(clientTask, "bench_client", BENCH_STACK, &clients[i],
+                                                    uxTaskPriorityGet(NULL) + 1, NULL,
+                                                    i % portNUM_PROCESSORS) == pdPASS,
+                            ESP_ERR_NO_MEM, TAG, "Benchmark of %s could not start", name);
+    }
+    for (uint32_t i = 0; i < BENCH_CLIENTS; i++)
+    {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    }
+    int64_t elapsedUs = esp_timer_get_time() - started;
+
+    int64_t latency = 0;
+    int64_t maxLatency = 0;
+    int64_t blocked = 0;
+    int64_t maxBlocked = 0;
+    for (uint32_t i = 0; i < BENCH_CLIENTS; i++)
+    {
+        latency += clients[i].latency;
+        maxLatency = (clients[i].maxLatency > maxLatency) ? clients[i].maxLatency : maxLatency;
+        blocked += clients[i].blocked;
+        maxBlocked = (clients[i].maxBlocked > maxBlocked) ? clients[i].maxBlocked : maxBlocked;
+    }
+    ESP_LOGI(TAG, "%-6s request to done avg %lld max %lld us, client blocked avg %lld max %lld us", name,
+             latency / (BENCH_CLIENTS * BENCH_REQUESTS), maxLatency,
+             blocked / (BENCH_CLIENTS * BENCH_REQUESTS), maxBlocked);
+    ESP_LOGI(TAG, "%-6s %lu uses of the resource for %d requests, %lld uses/s", name, (unsigned long)*executed,
+             BENCH_CLIENTS * BENCH_REQUESTS, (int64_t)*executed * 1000000 / elapsedUs);
+    return ESP_OK;
+}
+
+esp_err_t benchmark_resource_access(void)
+{
+    static client_bench_t clients[BENCH_CLIENTS];
+    static resource_server_t server;
+    static uint8_t requestStorage[RESOURCE_SERVER_STORAGE_SIZE(RESOURCE_SERVER_BATCH)];
+    uint32_t executed = BENCH_CLIENTS * BENCH_REQUESTS;
+
+    /*Mutex: every client waits until the resource is free*/
+    SemaphoreHandle_t key = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(key, ESP_ERR_NO_MEM, TAG, "mutex was not created");
+    for (uint32_t i = 0; i < BENCH_CLIENTS; i++)
+    {
+        clients[i] = (client_bench_t) { .key = key };
+    }
+    esp_err_t err = run_clients("mutex", mutex_client, clients, &executed);
+    vSemaphoreDelete(key);
+    ESP_RETURN_ON_ERROR(err, TAG, "mutex benchmark failed");
+
+    /*Server: above the clients, every request is executed*/
+    ESP_RETURN_ON_ERROR(resource_server_init(&server, requestStorage, RESOURCE_SERVER_BATCH, busy_resource, NULL),
+                        TAG, "server init failed");
+    ESP_RETURN_ON_ERROR(resource_server_start(&server, "bench_server", BENCH_STACK, uxTaskPriorityGet(NULL) + 2, 0),
+                        TAG, "server not started");
+    for (uint32_t i = 0; i < BENCH_CLIENTS; i++)
+    {
+        clients[i] = (client_bench_t) { .server = &server };
+    }
+    err = run_clients("server", server_client, clients, &server.executed);
+    resource_server_stop(&server);
+    return err;
+}
+
+/*************************************
+*   FAIRNESS UNDER ADVERSARIAL PERIODS
+*************************************/
+typedef struct {
+    SemaphoreHandle_t key;          /*NULL to use the fair lock*/
+    fair_lock_t *fair;
+    volatile bool *running;
+    TickType_t period;              /*0 for a greedy task*/
+    uint32_t uses;
+    uint32_t maxWait;               /*Cycles*/
+    TaskHandle_t caller;
+} fair_bench_t;
+
+static void fairness_task(void *pvParameters)
+{
+    fair_bench_t *task = (fair_bench_t *)pvParameters;
+
+    while (*task->running)
+    {
+        uint32_t started = esp_cpu_get_cycle_count();
+        if (task->key)
+        {
+            xSemaphoreTake(task->key, portMAX_DELAY);
+        }
+        else
+        {
+            fair_lock_take(task->fair, portMAX_DELAY);
+        }
+        uint32_t wait = esp_cpu_get_cycle_count() - started;
+        task->maxWait = (wait > task->maxWait) ? wait : task->maxWait;
+        task->uses++;
+
+        esp_rom_delay_us(BENCH_HOLD_US);
+        if (task->key)
+        {
+            xSemaphoreGive(task->key);
+        }
+        else
+        {
+            fair_lock_give(task->fair);
+        }
+        if (task->period)
+        {
+            vTaskDelay(task->period);
+        }
+    }
+    xTaskNotifyGive(task->caller);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t measure_fairness(const char *name, SemaphoreHandle_t key, fair_lock_t *fair)
+{
+    static volatile bool running;
+    static fair_bench_t tasks[2];
+    static const char *roles[2] = { "greedy", "slow" };
+    uint32_t cyclesPerUs = esp_rom_get_cpu_ticks_per_us();
+
+    running = true;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        tasks[i] = (fair_bench_t) {
+            .key = key,
+            .fair = fair,
+            .running = &running,
+            .period = i,                /*The greedy one never sleeps, the slow one for a tick*/
+            .caller = xTaskGetCurrentTaskHandle(),
+        };
+        /*The greedy one shares its priority with this task, which still gets its time slices*/
+        ESP_RETURN_ON_FALSE(xTaskCreatePinnedToCore(fairness_task, "bench_fair", BENCH_STACK, &tasks[i],
+                                                    uxTaskPriorityGet(NULL) + i, NULL,
+                                                    i ? 0 : portNUM_PROCESSORS - 1) == pdPASS,
+                            ESP_ERR_NO_MEM, TAG, "Benchmark of %s could not start", name);
+    }
+    vTaskDelay(pdMS_TO_TICKS(BENCH_FAIR_MS));
+    running = false;
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        ESP_LOGI(TAG, "%-4s %-6s %6lu uses, worst wait %lu us", name, roles[i], (unsigned long)tasks[i].uses,
+                 (unsigned long)(tasks[i].maxWait / cyclesPerUs));
+    }
+    return ESP_OK;
+}
+
+esp_err_t benchmark_fair_lock(void)
+{
+    static fair_lock_t fair;
+    SemaphoreHandle_t key = xSemaphoreCreateMutex();
+
+    ESP_RETURN_ON_FALSE(key, ESP_ERR_NO_MEM, TAG, "mutex was not created");
+    esp_err_t err = measure_fairness("mutex", key, NULL);
+    vSemaphoreDelete(key);
+    ESP_RETURN_ON_ERROR(err, TAG, "mutex benchmark failed");
+
+    fair_lock_init(&fair);
+    return measure_fairness("fair", NULL, &fair);
+}
@@ -0,0 +1,12 @@
+/***************************************************************************
+*@brief Benchmarks of the access to a shared resource
+Each benchmark runs on the target, measures CPU cycles with
+esp_cpu_get_cycle_count() (or esp_timer when the tasks run on different
+cores) and prints the results with ESP_LOGI.
+***************************************************************************/
+#pragma once
+
+#include "esp_err.h"
+
+esp_err_t benchmark_resource_access(void);  /*Request latency, client wait and uses/s, mutex against resource server*/
+esp_err_t benchmark_fair_lock(void);        /*Worst wait of a slow task against a greedy one, mutex against fair lock*/
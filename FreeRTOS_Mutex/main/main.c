@@ -7,13 +7,32 @@ If Task R takes the key, Red LED will blink.
 If Task G takes the key, Green LED will blink.
 Everytime a task finished to execute the shared resource, the key is given back
 to the mutex, so the shared resource could be available again.
+With RESOURCE_MODE_SERVER the LEDs are owned by a server task instead: Task R and
+Task G post blink requests without waiting and the server blinks them in order,
+repeated requests still pending are blinked once. A task does not post again
+while its previous blink is pending: the blink takes longer than the task delays,
+so it would only fill the queue.
+With RESOURCE_MODE_FAIR the key is a FIFO lock: each task waits its turn in order of
+arrival, so Task G gets the LEDs as often as Task R even with its longer delay.
+In every mode a dispatcher waits for "Task R blinked" AND "Task G blinked" and logs
+"Round N complete" once both LEDs were used, without polling.
 *********************************************************************************/
 #include <stdio.h>
+#include <stdatomic.h>
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/timers.h"
 #include "esp_log.h"
+#include "esp_check.h"
+#include "board_init.h"
+#include "task_registry.h"
+#include "resource_server.h"
+#include "mutex_prof.h"
+#include "fair_lock.h"
+#include "event_dispatch.h"
+#include "benchmark.h"
 
 #define LEDR    33      /*LED Red connected to PIN 33 from MCU*/
 #define LEDG    25      /*LED Green connected to PIN 25 from MCU*/
@@ -23,10 +42,49 @@ to the mutex, so the shared resource could be available again.
 #define LEDG_DELAY  2000    
 
 #define STACK_SIZE 1024*2    /*Number of bytes the stack will hold*/
+#define STACK_REPORT_PERIOD 0   /*Miliseconds between stack usage reports, 0 disables them*/
+#define RUN_BENCHMARKS      0   /*Set to 1 to compare the mutex and the server at startup*/
+#define LOCK_REPORT_PERIOD  30000   /*Miliseconds between GlobalKey contention reports, 0 disables them.
+                                    The statistics are recorded with CONFIG_MUTEX_PROF_ENABLE*/
+
+#define RESOURCE_MODE_MUTEX     0   /*Every task holds GlobalKey while it blinks*/
+#define RESOURCE_MODE_SERVER    1   /*A server task owns the LEDs, the tasks post requests*/
+#define RESOURCE_MODE_FAIR      2   /*Every task holds FairKey, handed over in order of arrival*/
+#define RESOURCE_MODE           RESOURCE_MODE_SERVER
+
+#define REQUEST_QUEUE_LENGTH    RESOURCE_SERVER_BATCH
+#define BLINK_REQUEST           0   /*Operation of the server: blink the LED in the argument*/
+
+/*Events of a round, the dispatcher runs its handler once both are set*/
+#define EVENT_R_DONE        (1 << 0)    /*Red LED finished a blink*/
+#define EVENT_G_DONE        (1 << 1)    /*Green LED finished a blink*/
+#define EVENT_HANDLERS      1
+#define DISPATCH_STACK      1024*2
+#define DISPATCH_PRIORITY   1
+
+/*Task placement: WiFi and the timer daemon run on core 0, the LEDs I/O on the last core*/
+#define IO_CORE     (portNUM_PROCESSORS - 1)
+/*Same priority, so the tasks keep alternating on the key*/
+#define LEDR_PRIORITY   2
+#define LEDG_PRIORITY   2
+#define SERVER_PRIORITY 2
 
 static const char *TAG = "Main";    /*Tag for the LOGS mns in terminal*/
 
-SemaphoreHandle_t GlobalKey = 0;    /*Variable to save the Mutex created*/
+mutex_prof_t GlobalKey;             /*Mutex created, profiled with CONFIG_MUTEX_PROF_ENABLE*/
+resource_server_t LedServer;        /*Owner of the LEDs in RESOURCE_MODE_SERVER*/
+fair_lock_t FairKey;                /*FIFO key of RESOURCE_MODE_FAIR*/
+static uint8_t requestStorage[RESOURCE_SERVER_STORAGE_SIZE(REQUEST_QUEUE_LENGTH)];
+
+/*Client of the server, one per LED task*/
+typedef struct {
+    const char *name;
+    atomic_bool pending;            /*Set by the post, cleared when the blink is done*/
+    atomic_uint skipped;            /*Uses skipped while the previous blink was pending*/
+} led_client_t;
+static led_client_t ledClients[] = { { .name = "Task R" }, { .name = "Task G" } };
+event_dispatch_t RoundEvents;       /*Wakes the round handler when both LEDs were used*/
+static event_dispatch_entry_t roundHandlers[EVENT_HANDLERS];
 
 /**********************
 * Function Prototypes
@@ -37,14 +95,38 @@ void vTask_LEDG(void *pvParameters);    /*Task from LED GREEN created in here*/
 esp_err_t init_led(void);               /*Setting LEDS directions and inital level*/
 esp_err_t create_tasks(void);           /*Creating a Task for each LED*/         
 esp_err_t shared_resource(int led);     /*Resource that makes blink a LED 8 times*/        
+esp_err_t create_server(void);          /*Server task owning the LEDs*/
+esp_err_t use_resource(int led, const char *client);   /*Blinks the LED through the mutex or the server*/
+void log_owner(int led, const char *client);          /*Which task holds the key*/
+void report_locks(TimerHandle_t xTimer);                /*Wait and hold statistics of the mutexes*/
+esp_err_t create_dispatcher(void);      /*Handlers woken by combinations of events*/
+void blink_finished(int led);           /*Event of the LED for the dispatcher*/
+void round_complete(EventBits_t bits, void *arg);
 
 /*******************************
 *   MAIN AND INIFINITE LOOP
 *******************************/
 void app_main(void)
 {
-    GlobalKey = xSemaphoreCreateMutex();    /*Creating the Mutex*/
+#if RUN_BENCHMARKS
+    benchmark_resource_access();
+    benchmark_fair_lock();
+#endif
+#if RESOURCE_MODE == RESOURCE_MODE_SERVER
+    create_server();
+#elif RESOURCE_MODE == RESOURCE_MODE_FAIR
+    fair_lock_init(&FairKey);
+#else
+    mutex_prof_init(&GlobalKey, "GlobalKey");   /*Creating the Mutex*/
+#if LOCK_REPORT_PERIOD > 0
+    xTimerStart(xTimerCreate("lock_report", pdMS_TO_TICKS(LOCK_REPORT_PERIOD), pdTRUE, NULL, report_locks), 0);
+#endif
+#endif
     init_led();
+    if (create_dispatcher() != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Round dispatcher was not started, rounds will not be logged");
+    }
     create_tasks();    
 }
 
@@ -53,41 +135,65 @@ void app_main(void)
 *********************/
 esp_err_t init_led(void)
 {
-    gpio_reset_pin( LEDR);
-    gpio_set_direction( LEDR, GPIO_MODE_OUTPUT);
-
-    gpio_reset_pin( LEDG);
-    gpio_set_direction( LEDG, GPIO_MODE_OUTPUT);
-
-    /*Initialize each LED in LOW level*/
-    gpio_set_level(LEDR, 0);
-    gpio_set_level(LEDG, 0);
+    /*Every LED as output and initialized in LOW level with a single configuration*/
+    static const board_pin_t ledPins[] = {
+        { .pin = LEDR, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+        { .pin = LEDG, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+    };
 
-    return ESP_OK;
+    return board_init_pins(ledPins, sizeof(ledPins) / sizeof(ledPins[0]), NULL);
 }
 
 /*********************
 *   TASKS SECTION
 *********************/
+/*Every task with its own static stack and TCB, nothing is taken from the heap*/
+static const task_registry_entry_t taskTable[] = {
+    TASK_REGISTRY_PINNED(vTask_LEDR, "vTask_LEDR", STACK_SIZE, NULL, LEDR_PRIORITY, IO_CORE),
+    TASK_REGISTRY_PINNED(vTask_LEDG, "vTask_LEDG", STACK_SIZE, NULL, LEDG_PRIORITY, IO_CORE),
+};
+
+#define TASKS   (sizeof(taskTable) / sizeof(taskTable[0]))
+
+static TaskHandle_t taskHandles[TASKS];
+
 esp_err_t create_tasks(void){
-    static uint8_t ucParameterToPass;
-    TaskHandle_t xHandle = NULL;
-
-    /*Creating Task for LED RED*/
-    xTaskCreate( vTask_LEDR, 
-                "vTask_LEDR", 
-                STACK_SIZE, 
-                &ucParameterToPass, 
-                1, &xHandle );
-
-    /*Creating Task for LED GREEN*/
-    xTaskCreate( vTask_LEDG, 
-                "vTask_LEDG", 
-                STACK_SIZE, 
-                &ucParameterToPass, 
-                1, &xHandle );
+    esp_err_t err = task_registry_start(taskTable, TASKS, taskHandles);
 
-    return ESP_OK;
+#if STACK_REPORT_PERIOD > 0
+    /*Diagnostic mode: report how much of every stack is really used*/
+    if (err == ESP_OK)
+    {
+        err = task_registry_monitor(taskTable, TASKS, taskHandles, STACK_REPORT_PERIOD);
+    }
+#endif
+    return err;
+}
+
+/*********************
+*   EVENTS SECTION
+*********************/
+esp_err_t create_dispatcher(void)
+{
+    ESP_RETURN_ON_ERROR(event_dispatch_init(&RoundEvents, roundHandlers, EVENT_HANDLERS), TAG, "dispatcher init failed");
+    /*Both events consumed, so the next round starts from zero*/
+    ESP_RETURN_ON_ERROR(event_dispatch_register(&RoundEvents, EVENT_R_DONE | EVENT_G_DONE, EVENT_DISPATCH_ALL, true,
+                                                round_complete, NULL), TAG, "round handler not registered");
+    return event_dispatch_start(&RoundEvents, "event_dispatch", DISPATCH_STACK, DISPATCH_PRIORITY, IO_CORE);
+}
+
+/*Called by whoever blinked the LED: the task holding the key or the server*/
+void blink_finished(int led)
+{
+    event_dispatch_set(&RoundEvents, (led == LEDR) ? EVENT_R_DONE : EVENT_G_DONE);
+}
+
+/*Runs in the dispatcher task*/
+void round_complete(EventBits_t bits, void *arg)
+{
+    static uint32_t rounds = 0;
+
+    ESP_LOGI(TAG, "Round %lu complete: both LEDs were used", (unsigned long)++rounds);
 }
 
 /*********************
@@ -105,17 +211,121 @@ esp_err_t shared_resource(int led){
     return ESP_OK;
 }
 
+/*Logs which task holds the key, Task R in red as its LED*/
+void log_owner(int led, const char *client)
+{
+    if (led == LEDR)
+    {
+        ESP_LOGE(TAG, "%s took the resource", client);  /*In red, as the LED*/
+    }
+    else
+    {
+        ESP_LOGI(TAG, "%s took the resource", client);
+    }
+}
+
+#if RESOURCE_MODE == RESOURCE_MODE_SERVER
+/*Executed only by the server task, the single owner of the LEDs*/
+static esp_err_t led_server(uint32_t op, uint32_t arg, void *resource)
+{
+    if (op != BLINK_REQUEST)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    esp_err_t err = shared_resource((int)arg);
+    blink_finished((int)arg);
+    return err;
+}
+
+/*Completion callback, runs in the server task once the LED finished blinking*/
+static void blink_done(esp_err_t result, void *ctx)
+{
+    led_client_t *client = (led_client_t *)ctx;
+
+    ESP_LOGI(TAG, "%s request done: %lu served, %lu blinked, %lu dropped, %u skipped while pending", client->name,
+             (unsigned long)LedServer.served, (unsigned long)LedServer.executed,
+             (unsigned long)atomic_load_explicit(&LedServer.rejected, memory_order_relaxed),
+             atomic_load_explicit(&client->skipped, memory_order_relaxed));
+    atomic_store(&client->pending, false);     /*The task may post again*/
+}
+
+esp_err_t create_server(void)
+{
+    ESP_RETURN_ON_ERROR(resource_server_init(&LedServer, requestStorage, REQUEST_QUEUE_LENGTH, led_server, NULL),
+                        TAG, "server init failed");
+    return resource_server_start(&LedServer, "led_server", STACK_SIZE, SERVER_PRIORITY, IO_CORE);
+}
+
+/*Posts the request and returns at once. While the previous blink of the task is
+  pending nothing is posted, the LED will blink anyway; a full queue drops it*/
+esp_err_t use_resource(int led, const char *client)
+{
+    led_client_t *owner = &ledClients[(led == LEDR) ? 0 : 1];
+    const resource_request_t request = {
+        .op = BLINK_REQUEST,
+        .arg = (uint32_t)led,
+        .done = blink_done,
+        .ctx = owner,
+    };
+
+    if (atomic_exchange(&owner->pending, true))
+    {
+        atomic_fetch_add_explicit(&owner->skipped, 1, memory_order_relaxed);
+        return ESP_OK;
+    }
+    esp_err_t err = resource_server_post(&LedServer, &request, 0);
+    if (err != ESP_OK)
+    {
+        atomic_store(&owner->pending, false);
+    }
+    return err;
+}
+#elif RESOURCE_MODE == RESOURCE_MODE_FAIR
+/*Blinks holding the key, the task waits in the queue without timeout: the wait is bounded
+  by the holds of the tasks ahead of it, one blink of the other task here*/
+esp_err_t use_resource(int led, const char *client)
+{
+    fair_lock_take(&FairKey, portMAX_DELAY);
+    log_owner(led, client);
+    shared_resource(led);
+    fair_lock_give(&FairKey);       /*Straight to the other task if it is waiting*/
+    blink_finished(led);
+    return ESP_OK;
+}
+#else
+/*Blinks holding the key, the other task cannot use the LEDs meanwhile*/
+esp_err_t use_resource(int led, const char *client)
+{
+    /*Check if the key is available*/
+    if(!mutex_prof_take(&GlobalKey, pdMS_TO_TICKS(100))){
+        return ESP_ERR_TIMEOUT;
+    }
+    log_owner(led, client);
+    shared_resource(led);           /*If so, the task takes the shared resource from mutex*/
+    mutex_prof_give(&GlobalKey);    /*After taken the shared resource, the task returns the key to the mutex*/
+    blink_finished(led);
+    return ESP_OK;
+}
+
+/*Runs in the timer daemon, every wait for GlobalKey and how long it was held*/
+void report_locks(TimerHandle_t xTimer)
+{
+    mutex_prof_dump_all();
+}
+#endif
+
 /*Task R that executesthe shared resource when the Key is available*/
 void vTask_LEDR(void *pvParameters)
 {
+    uint32_t dropped = 0;   /*Uses lost to a full server queue or a key timeout*/
+
     while (1)
     {
-        /*Check if the key is available*/
-       if(xSemaphoreTake(GlobalKey, pdMS_TO_TICKS(100))){
-            ESP_LOGE(TAG, "Task R took the resource");      
-            shared_resource(LEDR);                          /*If so, Task R takes the shared resource from mutex*/
-            xSemaphoreGive(GlobalKey);                      /*After taken the shared resource, Task R returns the key to the mutex*/
-       }       
+       esp_err_t err = use_resource(LEDR, "Task R");
+       if (err != ESP_OK)
+       {
+           ESP_LOGW(TAG, "Task R could not use the LEDs (%s), %lu dropped", esp_err_to_name(err), (unsigned long)++dropped);
+       }
        vTaskDelay(pdMS_TO_TICKS(LEDR_DELAY));   /*To avoid errors with Watchdog timer*/
     }    
 }
@@ -123,15 +333,15 @@ void vTask_LEDR(void *pvParameters)
 /*Task G that executesthe shared resource when the Key is available*/
 void vTask_LEDG(void *pvParameters)
 {
+    uint32_t dropped = 0;   /*Uses lost to a full server queue or a key timeout*/
 
     while (1)
     {
-        /*Check if the key is available*/
-       if(xSemaphoreTake(GlobalKey, pdMS_TO_TICKS(100))){
-            ESP_LOGI(TAG, "Task G took the resource");      
-            shared_resource(LEDG);                          /*If so, Task G takes the shared resource from mutex*/
-            xSemaphoreGive(GlobalKey);                      /*After taken the shared resource, Task G returns the key to the mutex*/
-       }       
+       esp_err_t err = use_resource(LEDG, "Task G");
+       if (err != ESP_OK)
+       {
+           ESP_LOGW(TAG, "Task G could not use the LEDs (%s), %lu dropped", esp_err_to_name(err), (unsigned long)++dropped);
+       }
        vTaskDelay(pdMS_TO_TICKS(LEDG_DELAY));   /*To avoid errors with Watchdog timer*/
     }
 }
\ No newline at end of file
@@ -0,0 +1,386 @@
+/***************************************************************************
+*@brief Benchmarks of the communication between tasks
+***************************************************************************/
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_cpu.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "msg_pool.h"
+#include "spsc_ring.h"
+#include "deferred_log.h"
+#include "benchmark.h"
+
+#define BENCH_MESSAGES  1000    /*Round trips measured by every placement*/
+#define BENCH_PRIORITY  5       /*Above the LEDs tasks, so they do not disturb the measure*/
+#define BENCH_STACK     1024*3
+
+#define STREAM_MESSAGES     2000    /*Messages streamed for every payload size*/
+#define STREAM_DEPTH        8       /*Messages that can wait in the queue*/
+#define STREAM_MAX_PAYLOAD  2048
+
+#define RING_ITEMS          100000  /*Values streamed through the ring and the queue*/
+#define RING_LENGTH         32
+
+#define LOG_CALLS           64      /*Lines logged by every method, the deferred ones fit in the ring*/
+
+static const char *TAG = "Benchmark";
+
+/*Producer and consumer pinned to a pair of cores*/
+typedef struct {
+    const char *name;
+    BaseType_t producerCore;
+    BaseType_t consumerCore;
+} placement_t;
+
+static const placement_t placements[] = {
+    { "same core",  portNUM_PROCESSORS - 1, portNUM_PROCESSORS - 1 },
+    { "cross core", 0,                      portNUM_PROCESSORS - 1 },
+};
+
+typedef struct {
+    QueueHandle_t request;
+    QueueHandle_t reply;
+    TaskHandle_t caller;        /*Notified when the producer finishes*/
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} latency_t;
+
+/*Consumer: returns every message to the producer*/
+static void echo_task(void *pvParameters)
+{
+    latency_t *bench = (latency_t *)pvParameters;
+    uint32_t value;
+
+    while (1)
+    {
+        xQueueReceive(bench->request, &value, portMAX_DELAY);
+        xQueueSend(bench->reply, &value, portMAX_DELAY);
+    }
+}
+
+/*Producer: the cycle counter of every core runs on its own, so the latency is
+  measured as half of a round trip timed on the producer core*/
+static void producer_task(void *pvParameters)
+{
+    latency_t *bench = (latency_t *)pvParameters;
+    uint32_t value;
+
+    for (uint32_t i = 0; i < BENCH_MESSAGES; i++)
+    {
+        uint32_t start = esp_cpu_get_cycle_count();
+        xQueueSend(bench->request, &i, portMAX_DELAY);
+        xQueueReceive(bench->reply, &value, portMAX_DELAY);
+        uint32_t latency = (esp_cpu_get_cycle_count() - start) / 2;
+
+        bench->min = (latency < bench->min) ? latency : bench->min;
+        bench->max = (latency > bench->max) ? latency : bench->max;
+        bench->total += latency;
+    }
+    xTaskNotifyGive(bench->caller);
+    vTaskDelete(NULL);
+}
+
+esp_err_t benchmark_queue_latency(void)
+{
+    uint32_t cyclesPerUs = esp_rom_get_cpu_ticks_per_us();
+
+    for (size_t i = 0; i < sizeof(placements) / sizeof(placements[0]); i++)
+    {
+        latency_t bench = {
+            .request = xQueueCreate(1, sizeof(uint32_t)),
+            .reply = xQueueCreate(1, sizeof(uint32_t)),
+            .caller = xTaskGetCurrentTaskHandle(),
+            .min = UINT32_MAX,
+        };
+        TaskHandle_t echo = NULL;
+
+        if (!bench.request || !bench.reply ||
+            xTaskCreatePinnedToCore(echo_task, "bench_echo", BENCH_STACK, &bench, BENCH_PRIORITY,
+                                    &echo, placements[i].consumerCore) != pdPASS ||
+            xTaskCreatePinnedToCore(producer_task, "bench_producer", BENCH_STACK, &bench, BENCH_PRIORITY,
+                                    NULL, placements[i].producerCore) != pdPASS)
+        {
+            ESP_LOGE(TAG, "Benchmark of %s could not start", placements[i].name);
+            if (echo)
+            {
+                vTaskDelete(echo);
+            }
+            if (bench.request)
+            {
+                vQueueDelete(bench.request);
+            }
+            if (bench.reply)
+            {
+                vQueueDelete(bench.reply);
+            }
+            return ESP_ERR_NO_MEM;
+        }
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        vTaskDelete(echo);
+        vQueueDelete(bench.request);
+        vQueueDelete(bench.reply);
+
+        uint32_t avg = bench.total / BENCH_MESSAGES;
+        ESP_LOGI(TAG, "%-10s (core %d -> core %d): min %lu avg %lu max %lu cycles, avg %lu us",
+                 placements[i].name, (int)placements[i].producerCore, (int)placements[i].consumerCore,
+                 (unsigned long)bench.min, (unsigned long)avg, (unsigned long)bench.max,
+                 (unsigned long)(avg / cyclesPerUs));
+    }
+    return ESP_OK;
+}
+
+/*********************
+*   ZERO-COPY MESSAGES
+*********************/
+static const uint16_t payloads[] = { 4, 64, 256, 1024, 2048 };
+
+typedef struct {
+    QueueHandle_t queue;
+    msg_pool_t *pool;           /*NULL: the payload is copied into the queue*/
+    size_t payload;
+    TaskHandle_t caller;        /*Notified when the consumer finishes*/
+    uint32_t checksum;          /*Keeps the consumer reading the payload*/
+} stream_t;
+
+static uint8_t streamPoolStorage[MSG_POOL_STORAGE_SIZE(STREAM_MAX_PAYLOAD, STREAM_DEPTH)] __attribute__((aligned(MSG_POOL_ALIGN)));
+static uint8_t producerFrame[STREAM_MAX_PAYLOAD];   /*Frames of the copy mode, static to keep the stacks small*/
+static uint8_t consumerFrame[STREAM_MAX_PAYLOAD];
+
+static void stream_consumer(void *pvParameters)
+{
+    stream_t *stream = (stream_t *)pvParameters;
+
+    for (uint32_t i = 0; i < STREAM_MESSAGES; i++)
+    {
+        if (stream->pool)
+        {
+            uint8_t *block = msg_pool_receive(stream->queue, portMAX_DELAY);
+            stream->checksum += block[stream->payload - 1];
+            msg_pool_free(stream->pool, block);
+        }
+        else
+        {
+            xQueueReceive(stream->queue, consumerFrame, portMAX_DELAY);
+            stream->checksum += consumerFrame[stream->payload - 1];
+        }
+    }
+    xTaskNotifyGive(stream->caller);
+    vTaskDelete(NULL);
+}
+
+/*Streams STREAM_MESSAGES from the calling task to a consumer on the same core,
+  returns the microseconds taken or 0 if the benchmark could not run*/
+static int64_t stream_messages(msg_pool_t *pool, size_t payload)
+{
+    stream_t stream = {
+        .queue = pool ? msg_pool_queue_create(pool) : xQueueCreate(STREAM_DEPTH, payload),
+        .pool = pool,
+        .payload = payload,
+        .caller = xTaskGetCurrentTaskHandle(),
+    };
+
+    if (stream.queue == NULL)
+    {
+        return 0;
+    }
+    if (xTaskCreatePinnedToCore(stream_consumer, "bench_consumer", BENCH_STACK, &stream,
+                                uxTaskPriorityGet(NULL), NULL, xPortGetCoreID()) != pdPASS)
+    {
+        vQueueDelete(stream.queue);
+        return 0;
+    }
+
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < STREAM_MESSAGES; i++)
+    {
+        if (pool)
+        {
+            uint8_t *block = msg_pool_alloc(pool, portMAX_DELAY);
+            block[payload - 1] = (uint8_t)i;
+            msg_pool_send(stream.queue, block, portMAX_DELAY);
+        }
+        else
+        {
+            producerFrame[payload - 1] = (uint8_t)i;
+            xQueueSend(stream.queue, producerFrame, portMAX_DELAY);
+        }
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    vQueueDelete(stream.queue);
+    return elapsed;
+}
+
+static void report_stream(const char *name, size_t payload, int64_t elapsed)
+{
+    if (elapsed <= 0)
+    {
+        ESP_LOGE(TAG, "%-5s %4u B: benchmark could not run", name, (unsigned)payload);
+        return;
+    }
+    uint32_t nsPerMessage = (uint32_t)(elapsed * 1000 / STREAM_MESSAGES);
+    ESP_LOGI(TAG, "%-5s %4u B: %7lu msg/s %4lu.%02lu us/msg", name, (unsigned)payload,
+             (unsigned long)(STREAM_MESSAGES * 1000000LL / elapsed),
+             (unsigned long)(nsPerMessage / 1000), (unsigned long)(nsPerMessage % 1000 / 10));
+}
+
+esp_err_t benchmark_msg_pool(void)
+{
+    static msg_pool_t pool;
+
+    ESP_RETURN_ON_ERROR(msg_pool_init(&pool, streamPoolStorage, STREAM_MAX_PAYLOAD, STREAM_DEPTH), TAG,
+                        "pool was not created");
+    for (size_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++)
+    {
+        report_stream("copy", payloads[i], stream_messages(NULL, payloads[i]));
+        report_stream("pool", payloads[i], stream_messages(&pool, payloads[i]));
+    }
+    return ESP_OK;
+}
+
+/*********************
+*   SPSC RING
+*********************/
+typedef struct {
+    spsc_ring_t *ring;          /*NULL: the values go through 'queue'*/
+    QueueHandle_t queue;
+    TaskHandle_t caller;        /*Notified when the consumer finishes*/
+    uint32_t outOfOrder;        /*Values that did not arrive in sequence, lost ones included*/
+} ring_stream_t;
+
+static void ring_consumer(void *pvParameters)
+{
+    ring_stream_t *stream = (ring_stream_t *)pvParameters;
+    uint32_t value;
+
+    for (uint32_t i = 0; i < RING_ITEMS; i++)
+    {
+        if (stream->ring)
+        {
+            spsc_ring_receive(stream->ring, &value, portMAX_DELAY);
+        }
+        else
+        {
+            xQueueReceive(stream->queue, &value, portMAX_DELAY);
+        }
+        stream->outOfOrder += (value != i);
+    }
+    xTaskNotifyGive(stream->caller);
+    vTaskDelete(NULL);
+}
+
+static void ring_producer(void *pvParameters)
+{
+    ring_stream_t *stream = (ring_stream_t *)pvParameters;
+
+    for (uint32_t i = 0; i < RING_ITEMS; i++)
+    {
+        if (stream->ring)
+        {
+            spsc_ring_send(stream->ring, &i, portMAX_DELAY);
+        }
+        else
+        {
+            xQueueSend(stream->queue, &i, portMAX_DELAY);
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+/*Streams RING_ITEMS values with the given placement, returns the microseconds taken*/
+static int64_t stream_values(ring_stream_t *stream, const placement_t *placement)
+{
+    TaskHandle_t consumer = NULL;
+
+    stream->caller = xTaskGetCurrentTaskHandle();
+    stream->outOfOrder = 0;
+    int64_t start = esp_timer_get_time();
+    if (xTaskCreatePinnedToCore(ring_consumer, "bench_consumer", BENCH_STACK, stream, BENCH_PRIORITY,
+                                &consumer, placement->consumerCore) != pdPASS)
+    {
+        return 0;
+    }
+    if (xTaskCreatePinnedToCore(ring_producer, "bench_producer", BENCH_STACK, stream, BENCH_PRIORITY,
+                                NULL, placement->producerCore) != pdPASS)
+    {
+        vTaskDelete(consumer);
+        return 0;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return esp_timer_get_time() - start;
+}
+
+static void report_values(const char *name, const placement_t *placement, const ring_stream_t *stream,
+                          int64_t elapsed)
+{
+    if (elapsed <= 0)
+    {
+        ESP_LOGE(TAG, "%-6s %-10s: benchmark could not run", name, placement->name);
+        return;
+    }
+    ESP_LOGI(TAG, "%-6s %-10s: %8lu values/s %5lu ns/value, %lu out of order", name, placement->name,
+             (unsigned long)(RING_ITEMS * 1000000LL / elapsed), (unsigned long)(elapsed * 1000 / RING_ITEMS),
+             (unsigned long)stream->outOfOrder);
+}
+
+esp_err_t benchmark_spsc_ring(void)
+{
+    static spsc_ring_t ring;
+    static uint32_t ringStorage[RING_LENGTH];
+
+    for (size_t i = 0; i < sizeof(placements) / sizeof(placements[0]); i++)
+    {
+        ring_stream_t queueStream = { .queue = xQueueCreate(RING_LENGTH, sizeof(uint32_t)) };
+        ring_stream_t ringStream = { .ring = &ring };
+
+        ESP_RETURN_ON_FALSE(queueStream.queue, ESP_ERR_NO_MEM, TAG, "queue was not created");
+        report_values("xQueue", &placements[i], &queueStream, stream_values(&queueStream, &placements[i]));
+        vQueueDelete(queueStream.queue);
+
+        ESP_RETURN_ON_ERROR(spsc_ring_init(&ring, ringStorage, sizeof(uint32_t), RING_LENGTH), TAG,
+                            "ring was not created");
+        report_values("ring", &placements[i], &ringStream, stream_values(&ringStream, &placements[i]));
+    }
+    return ESP_OK;
+}
+
+/*************************************
+*   DEFERRED LOG AGAINST ESP_LOGI
+*************************************/
+/*Only the cost seen by the caller: ESP_LOGI formats and waits for the UART,
+  the deferred record is printed later by deferred_log_flush()*/
+esp_err_t benchmark_deferred_log(void)
+{
+    static deferred_log_t log;
+    static deferred_log_slot_t logStorage[LOG_CALLS];
+    uint32_t direct = 0;
+    uint32_t deferred = 0;
+
+    ESP_RETURN_ON_ERROR(deferred_log_init(&log, logStorage, LOG_CALLS, DEFERRED_LOG_TEXT), TAG, "log init failed");
+
+    for (uint32_t i = 0; i < LOG_CALLS; i++)
+    {
+        uint32_t started = esp_cpu_get_cycle_count();
+        ESP_LOGI(TAG, "Sending: %lu to Queue", (unsigned long)i);
+        direct += esp_cpu_get_cycle_count() - started;
+    }
+    for (uint32_t i = 0; i < LOG_CALLS; i++)
+    {
+        uint32_t started = esp_cpu_get_cycle_count();
+        DEFERRED_LOG(&log, "Sending: %lu to Queue", i);
+        deferred += esp_cpu_get_cycle_count() - started;
+    }
+    deferred_log_flush(&log);
+
+    ESP_LOGI(TAG, "ESP_LOGI     %lu cycles per line", (unsigned long)(direct / LOG_CALLS));
+    ESP_LOGI(TAG, "DEFERRED_LOG %lu cycles per line", (unsigned long)(deferred / LOG_CALLS));
+    return ESP_OK;
+}
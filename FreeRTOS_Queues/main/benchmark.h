@@ -0,0 +1,13 @@
+/***************************************************************************
+*@brief Benchmarks of the communication between tasks
+Each benchmark runs on the target, measures CPU cycles with
+esp_cpu_get_cycle_count() and prints the results with ESP_LOGI.
+***************************************************************************/
+#pragma once
+
+#include "esp_err.h"
+
+esp_err_t benchmark_queue_latency(void);    /*Producer to consumer latency with same core and cross core pinning*/
+esp_err_t benchmark_msg_pool(void);         /*Messages per second copying the payload and passing pool blocks*/
+esp_err_t benchmark_spsc_ring(void);        /*Values per second through the lock-free ring and through a Queue*/
+esp_err_t benchmark_deferred_log(void);     /*Cycles spent by the caller per log line, ESP_LOGI against a deferred record*/
@@ -11,11 +11,21 @@ A Log in Red can be seen when data could not be sent because of a full Queue or
 either received because of an empty Queue.
 *********************************************************************************/
 #include <stdio.h>
+#include <string.h>
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_check.h"
+#include "board_init.h"
+#include "task_registry.h"
+#include "msg_pool.h"
+#include "spsc_ring.h"
+#include "msg_channel.h"
+#include "deferred_log.h"
+#include "log_rate.h"
+#include "benchmark.h"
 
 #define LEDR    33      /*LED Red connected to PIN 33 from MCU*/
 #define LEDG    25      /*LED Green connected to PIN 25 from MCU*/
@@ -23,12 +33,95 @@ either received because of an empty Queue.
 #define LEDR_DELAY  400     /*Delay set to Task from LED Red*/
 #define LEDG_DELAY  2000    /*Delay set to Task from LED Green*/
 
+#define MESSAGE_MODE_COPY   0   /*Values copied into and out of the Queue*/
+#define MESSAGE_MODE_POOL   1   /*Frames taken from a pool, only their pointers go through the Queue*/
+#define MESSAGE_MODE_RING   2   /*Values in a lock-free ring instead of a Queue*/
+#define MESSAGE_MODE_VARIABLE 3 /*Telemetry messages of 8 to 512 bytes in a MessageBuffer*/
+#define MESSAGE_MODE        MESSAGE_MODE_POOL
+
+#define CONSUMER_MODE_SINGLE    0   /*Task G takes one value per wake up*/
+#define CONSUMER_MODE_BATCH     1   /*Task G drains every pending value per wake up*/
+#define CONSUMER_MODE           CONSUMER_MODE_BATCH
+
+#define QUEUE_LENGTH    20      /*Messages that can wait in the Queue*/
+#define RING_LENGTH     32      /*Values that can wait in the ring, a power of two*/
+#define TELEMETRY_MIN   8       /*Bytes of the shortest telemetry message (value 0)*/
+#define TELEMETRY_MAX   512     /*Bytes of the longest telemetry message (value 7)*/
+#define TELEMETRY_BUFFER 2048   /*Bytes shared by all the telemetry messages waiting*/
+#define BACKPRESSURE_TIMEOUT 5000  /*Miliseconds Task R waits for Task G to make room before dropping a value*/
+#define COUNTERS_REPORT 8       /*Wake ups of Task G between every counters report*/
+#define FRAME_SIZE      256     /*Bytes of the simulated sensor frame sent with every value*/
+
+#define LOG_MODE_DIRECT     0   /*ESP_LOGx formats and writes every line in the calling task*/
+#define LOG_MODE_DEFERRED   1   /*Tasks R and G only store a record, a low priority task prints them*/
+#define LOG_MODE            LOG_MODE_DEFERRED
+#define LOG_RING_LENGTH     64      /*Records that can wait to be printed, a power of two*/
+#define LOG_FLUSH_PERIOD    100     /*Miliseconds between prints of the pending records*/
+#define LOG_VALUES_EVERY    4       /*Sends and receives between logged ones, 1 logs every value*/
+
 #define STACK_SIZE 1024*2    /*Number of bytes the stack will hold*/
+#define LOG_STACK_SIZE 1024*3   /*printf() of the flush task*/
+#define STACK_REPORT_PERIOD 0   /*Miliseconds between stack usage reports, 0 disables them*/
+#define RUN_BENCHMARKS      0   /*Set to 1 to measure the queue latency, zero-copy messages and the ring at startup*/
+
+/*Task placement: WiFi and the timer daemon run on core 0, the LEDs I/O on the last core*/
+#define IO_CORE     (portNUM_PROCESSORS - 1)
+/*Consumer above the producer, so every value is taken as soon as it arrives*/
+#define LEDR_PRIORITY   2
+#define LEDG_PRIORITY   3
+#define LOG_PRIORITY    1       /*Prints only when the LEDs tasks sleep*/
+#define LOG_CORE        0
+
+#if LOG_MODE == LOG_MODE_DEFERRED
+#define QUEUE_LOG(level, format, ...)   DEFERRED_LOG_LEVEL(&QueueLog, level, format, ##__VA_ARGS__)
+#else
+#define QUEUE_LOG(level, format, ...)   ESP_LOG_LEVEL(level, TAG, format, ##__VA_ARGS__)
+#endif
 
 static const char *TAG = "Main";    /*Tag for the LOGS mns in terminal*/
 
 QueueHandle_t GlobalQueue = 0;
 
+/*MESSAGE_MODE_COPY: only uint32_t values fit in the channel, of 4 bytes on both sides*/
+MSG_CHANNEL_DEFINE(led_value, uint32_t, 4)
+led_value_channel_t ValueChannel;
+
+/*MESSAGE_MODE_VARIABLE: only the bytes used by every message are stored*/
+typedef struct {
+    uint32_t value;
+    uint8_t data[TELEMETRY_MAX - sizeof(uint32_t)];
+} telemetry_msg_t;
+
+msg_channel_var_t TelemetryChannel;
+
+/*Message sent in MESSAGE_MODE_POOL: a value and the sensor frame that produced it*/
+typedef struct {
+    uint32_t value;
+    uint16_t len;
+    uint8_t data[FRAME_SIZE];
+} sensor_frame_t;
+
+/*Counters that show how well Task G keeps up with Task R*/
+typedef struct {
+    uint32_t sent;
+    uint32_t sendFailures;      /*Values dropped by Task R*/
+    uint32_t backpressureWaits; /*Times Task R found the Queue full and waited for Task G*/
+    uint32_t wakeups;           /*Times Task G woke up with values to process*/
+    uint32_t received;
+    uint32_t maxBatch;          /*Most values processed in a single wake up*/
+} queue_counters_t;
+
+queue_counters_t queueCounters;
+
+deferred_log_t QueueLog;    /*Records of the sends and receives in LOG_MODE_DEFERRED*/
+static deferred_log_slot_t queueLogStorage[LOG_RING_LENGTH];
+
+spsc_ring_t ValueRing;  /*Task R is the only producer and Task G the only consumer*/
+static uint32_t valueRingStorage[RING_LENGTH];
+
+msg_pool_t FramePool;   /*A block per message that can wait in the Queue*/
+static uint8_t framePoolStorage[MSG_POOL_STORAGE_SIZE(sizeof(sensor_frame_t), QUEUE_LENGTH)] __attribute__((aligned(MSG_POOL_ALIGN)));
+
 /**********************
 * Function Prototypes
 **********************/
@@ -37,14 +130,27 @@ void vTask_LEDR(void *pvParameters);    /*Task from LED RED created in here*/
 void vTask_LEDG(void *pvParameters);    /*Task from LED GREEN created in here*/
 esp_err_t init_led(void);               /*Setting LEDS directions and inital level*/
 esp_err_t create_tasks(void);           /*Creating a Task for each LED*/         
+esp_err_t create_queue(void);           /*Creating the Queue (and the pool) between Task R and Task G*/
+esp_err_t send_value(uint32_t value, TickType_t timeout);       /*Sending a value to Task G*/
+esp_err_t receive_value(uint32_t *value, TickType_t timeout);   /*Receiving a value from Task R*/
+size_t receive_batch(uint32_t *values, size_t max, TickType_t timeout); /*Receiving every pending value*/
+void report_counters(void);             /*Items per wake up and send failures*/
+esp_err_t create_log(void);             /*Flush task of the deferred records*/
 
 /*******************************
 *   MAIN AND INIFINITE LOOP
 *******************************/
 void app_main(void)
 {
+#if RUN_BENCHMARKS
+    benchmark_queue_latency();
+    benchmark_msg_pool();
+    benchmark_spsc_ring();
+    benchmark_deferred_log();
+#endif
+    create_log();
     init_led();
-    GlobalQueue = xQueueCreate(20, sizeof(uint32_t));   /*Creating a Queue to coomunicate TaskR and TaskG*/
+    create_queue();     /*Creating a Queue to coomunicate TaskR and TaskG*/
     create_tasks();    
 }
 
@@ -53,41 +159,162 @@ void app_main(void)
 *********************/
 esp_err_t init_led(void)
 {
-    gpio_reset_pin( LEDR);
-    gpio_set_direction( LEDR, GPIO_MODE_OUTPUT);
+    /*Every LED as output and initialized in LOW level with a single configuration*/
+    static const board_pin_t ledPins[] = {
+        { .pin = LEDR, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+        { .pin = LEDG, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+    };
+
+    return board_init_pins(ledPins, sizeof(ledPins) / sizeof(ledPins[0]), NULL);
+}
+
+/*********************
+*   QUEUE SECTION
+*********************/
+esp_err_t create_queue(void)
+{
+#if MESSAGE_MODE == MESSAGE_MODE_POOL
+    esp_err_t err = msg_pool_init(&FramePool, framePoolStorage, sizeof(sensor_frame_t), QUEUE_LENGTH);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    GlobalQueue = msg_pool_queue_create(&FramePool);
+    return GlobalQueue ? ESP_OK : ESP_ERR_NO_MEM;
+#elif MESSAGE_MODE == MESSAGE_MODE_RING
+    return spsc_ring_init(&ValueRing, valueRingStorage, sizeof(uint32_t), RING_LENGTH);
+#elif MESSAGE_MODE == MESSAGE_MODE_VARIABLE
+    return msg_channel_var_create(&TelemetryChannel, TELEMETRY_BUFFER, sizeof(telemetry_msg_t));
+#else
+    return led_value_channel_create(&ValueChannel, QUEUE_LENGTH);
+#endif
+}
+
+/*ESP_ERR_TIMEOUT when the Queue (or the pool) stays full during 'timeout'*/
+esp_err_t send_value(uint32_t value, TickType_t timeout)
+{
+#if MESSAGE_MODE == MESSAGE_MODE_POOL
+    sensor_frame_t *frame = msg_pool_alloc(&FramePool, timeout);
+    if (frame == NULL)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    /*The frame is filled in place and handed over without being copied*/
+    frame->value = value;
+    frame->len = FRAME_SIZE;
+    memset(frame->data, (uint8_t)value, FRAME_SIZE);
+    esp_err_t err = msg_pool_send(GlobalQueue, frame, 0);   /*The Queue has room for every block*/
+    if (err != ESP_OK)
+    {
+        msg_pool_free(&FramePool, frame);
+    }
+    return err;
+#elif MESSAGE_MODE == MESSAGE_MODE_RING
+    return spsc_ring_send(&ValueRing, &value, timeout);
+#elif MESSAGE_MODE == MESSAGE_MODE_VARIABLE
+    static telemetry_msg_t msg;     /*Only used by Task R*/
+    size_t len = TELEMETRY_MIN + value * (TELEMETRY_MAX - TELEMETRY_MIN) / 7;
+
+    msg.value = value;
+    memset(msg.data, (uint8_t)value, len - sizeof(msg.value));
+    return msg_channel_var_send(&TelemetryChannel, &msg, len, timeout);
+#else
+    return led_value_send(&ValueChannel, &value, timeout);
+#endif
+}
+
+esp_err_t receive_value(uint32_t *value, TickType_t timeout)
+{
+#if MESSAGE_MODE == MESSAGE_MODE_POOL
+    sensor_frame_t *frame = msg_pool_receive(GlobalQueue, timeout);
+    if (frame == NULL)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    *value = frame->value;      /*Task G owns the frame until it is freed*/
+    return msg_pool_free(&FramePool, frame);
+#elif MESSAGE_MODE == MESSAGE_MODE_RING
+    return spsc_ring_receive(&ValueRing, value, timeout);
+#elif MESSAGE_MODE == MESSAGE_MODE_VARIABLE
+    static telemetry_msg_t msg;     /*Only used by Task G*/
+    size_t len = 0;
+
+    esp_err_t err = msg_channel_var_receive(&TelemetryChannel, &msg, sizeof(msg), &len, timeout);
+    if (err == ESP_OK)
+    {
+        *value = msg.value;
+    }
+    return err;
+#else
+    return led_value_receive(&ValueChannel, value, timeout);
+#endif
+}
+
+/*Waits up to 'timeout' for the first value, then takes the ones already
+  waiting without blocking. Returns the number of values received*/
+size_t receive_batch(uint32_t *values, size_t max, TickType_t timeout)
+{
+    size_t count = 0;
 
-    gpio_reset_pin( LEDG);
-    gpio_set_direction( LEDG, GPIO_MODE_OUTPUT);
+    if (max == 0 || receive_value(&values[count++], timeout) != ESP_OK)
+    {
+        return 0;
+    }
+    while (count < max && receive_value(&values[count], 0) == ESP_OK)
+    {
+        count++;
+    }
+    return count;
+}
 
-    /*Initialize each LED in LOW level*/
-    gpio_set_level(LEDR, 0);
-    gpio_set_level(LEDG, 0);
+void report_counters(void)
+{
+    uint32_t perWakeup = queueCounters.wakeups ? queueCounters.received * 10 / queueCounters.wakeups : 0;
+
+    ESP_LOGI(TAG, "Sent %lu, received %lu, %lu.%lu values per wake up (max %lu), %lu waits for room, %lu dropped",
+             (unsigned long)queueCounters.sent, (unsigned long)queueCounters.received,
+             (unsigned long)(perWakeup / 10), (unsigned long)(perWakeup % 10), (unsigned long)queueCounters.maxBatch,
+             (unsigned long)queueCounters.backpressureWaits, (unsigned long)queueCounters.sendFailures);
+}
 
+esp_err_t create_log(void)
+{
+#if LOG_MODE == LOG_MODE_DEFERRED
+    ESP_RETURN_ON_ERROR(deferred_log_init(&QueueLog, queueLogStorage, LOG_RING_LENGTH, DEFERRED_LOG_TEXT),
+                        TAG, "log init failed");
+    return deferred_log_start(&QueueLog, "deferred_log", LOG_STACK_SIZE, LOG_PRIORITY, LOG_CORE, LOG_FLUSH_PERIOD);
+#else
     return ESP_OK;
+#endif
 }
 
 /*********************
 *   TASKS SECTION
 *********************/
+/*Every task with its own static stack and TCB, nothing is taken from the heap*/
+static const task_registry_entry_t taskTable[] = {
+    TASK_REGISTRY_PINNED(vTask_LEDR, "vTask_LEDR", STACK_SIZE, NULL, LEDR_PRIORITY, IO_CORE),
+    TASK_REGISTRY_PINNED(vTask_LEDG, "vTask_LEDG", STACK_SIZE, NULL, LEDG_PRIORITY, IO_CORE),
+};
+
+#define TASKS       (sizeof(taskTable) / sizeof(taskTable[0]))
+#define TASK_LEDR   0       /*Index of Task R in taskTable*/
+
+static TaskHandle_t taskHandles[TASKS];
+
 esp_err_t create_tasks(void){
-    static uint8_t ucParameterToPass;
-    TaskHandle_t xHandle = NULL;
-
-    /*Creating Task for LED RED*/
-    xTaskCreate( vTask_LEDR, 
-                "vTask_LEDR", 
-                STACK_SIZE, 
-                &ucParameterToPass, 
-                1, &xHandle );
-
-    /*Creating Task for LED GREEN*/
-    xTaskCreate( vTask_LEDG, 
-                "vTask_LEDG", 
-                STACK_SIZE, 
-                &ucParameterToPass, 
-                1, &xHandle );
+    esp_err_t err = task_registry_start(taskTable, TASKS, taskHandles);
 
-    return ESP_OK;
+#if STACK_REPORT_PERIOD > 0
+    /*Diagnostic mode: report how much of every stack is really used*/
+    if (err == ESP_OK)
+    {
+        err = task_registry_monitor(taskTable, TASKS, taskHandles, STACK_REPORT_PERIOD);
+    }
+#endif
+    return err;
 }
 
 /*Actions to be executed once created Task LED Red*/
@@ -95,21 +322,45 @@ void vTask_LEDR(void *pvParameters)
 {
     while (1)
     {
-        /*Sending through the GlobalQueue the numbers from 0 to 7*/
+        /*Sending to Task G the numbers from 0 to 7*/
         for (size_t i = 0; i < 8; i++)
         {
             
+#if CONSUMER_MODE == CONSUMER_MODE_BATCH
+            /*Backpressure: when the Queue is full wait until Task G drains it.
+              Task G notifies after every batch, so a notification left from a
+              batch drained before this send is cleared first*/
+            ulTaskNotifyTake(pdTRUE, 0);
+            esp_err_t err = send_value(i, 0);
+            if (err != ESP_OK)
+            {
+                queueCounters.backpressureWaits++;      /*Once per value, whatever the retries*/
+            }
+            while (err != ESP_OK)
+            {
+                if (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BACKPRESSURE_TIMEOUT)))
+                {
+                    break;      /*Task G is stuck, drop the value*/
+                }
+                err = send_value(i, 0);
+            }
+#else
+            esp_err_t err = send_value(i, pdMS_TO_TICKS(100));     //Wait 100ms to send another value if the Queue is full
+#endif
+
             /*Check if a value could not be sent to the Queue*/
-            if (!xQueueSend(GlobalQueue, &i, pdMS_TO_TICKS(100)))           //Wait 100ms to send another value if the GlobalQueue is full
+            if (err != ESP_OK)
             {
+                queueCounters.sendFailures++;
                 ESP_LOGE(TAG, "Error sending %d to Queue", i);
             }
             else
             {
+                queueCounters.sent++;
                 /*Simulating task is taking 400ms to send the value to the Queue*/
                 vTaskDelay(pdMS_TO_TICKS(LEDR_DELAY/2));    
                 gpio_set_level( LEDR, 1);                   //LED Red in HIGH when starting sending a data to the Queue
-                ESP_LOGI(TAG, "Sending: %d to Queue", i);
+                LOG_EVERY_N(LOG_VALUES_EVERY, QUEUE_LOG, ESP_LOG_INFO, "Sending: %d to Queue", i);
                 vTaskDelay(pdMS_TO_TICKS(LEDR_DELAY/2));
                 gpio_set_level( LEDR, 0);                   //LED Red in LOW when finished to send a data to the Queue
             }
@@ -122,25 +373,68 @@ void vTask_LEDR(void *pvParameters)
 /*Actions to be executed once created Task LED Green*/
 void vTask_LEDG(void *pvParameters)
 {
-    int valueFromQueue = 0;
+#if CONSUMER_MODE == CONSUMER_MODE_BATCH
+    uint32_t values[QUEUE_LENGTH];
+
+    while (1)
+    {
+        /*Sleep until a value arrives, then take every value waiting in the Queue*/
+        size_t count = receive_batch(values, QUEUE_LENGTH, portMAX_DELAY);
+        if (count == 0)
+        {
+            continue;
+        }
+        xTaskNotifyGive(taskHandles[TASK_LEDR]);   /*Room available again for Task R*/
+
+        queueCounters.wakeups++;
+        queueCounters.received += count;
+        queueCounters.maxBatch = (count > queueCounters.maxBatch) ? count : queueCounters.maxBatch;
+
+        /*Simulating the whole batch takes 2s to be processed*/
+        vTaskDelay(pdMS_TO_TICKS(LEDG_DELAY/2));
+        gpio_set_level( LEDG, 1);
+        for (size_t i = 0; i < count; i++)
+        {
+            LOG_EVERY_N(LOG_VALUES_EVERY, QUEUE_LOG, ESP_LOG_WARN, "Receiving: %lu to Queue", (unsigned long)values[i]);
+        }
+        vTaskDelay(pdMS_TO_TICKS(LEDG_DELAY/2));
+        gpio_set_level( LEDG, 0);
+
+        if (queueCounters.wakeups % COUNTERS_REPORT == 0)
+        {
+            report_counters();
+        }
+    }
+#else
+    uint32_t valueFromQueue = 0;
 
     while (1)
     {
         /*Check if the value was received correctly*/
-        if (!xQueueReceive(GlobalQueue, &valueFromQueue, pdMS_TO_TICKS(100)))   //Wait 100ms if there's no elements in the Queue
+        if (receive_value(&valueFromQueue, pdMS_TO_TICKS(100)) != ESP_OK)      //Wait 100ms if there's no elements in the Queue
         {
             ESP_LOGE(TAG, "Error receiving data from Queue");
         }
         else
         {
+            queueCounters.wakeups++;
+            queueCounters.received++;
+            queueCounters.maxBatch = 1;
+
             /*Simulating receiving data takes 1s to be received*/
             vTaskDelay(pdMS_TO_TICKS(LEDG_DELAY/2));    
             gpio_set_level( LEDG, 1);          
-            ESP_LOGW(TAG, "Receiving: %d to Queue", valueFromQueue);         
+            LOG_EVERY_N(LOG_VALUES_EVERY, QUEUE_LOG, ESP_LOG_WARN, "Receiving: %lu to Queue", (unsigned long)valueFromQueue);         
             vTaskDelay(pdMS_TO_TICKS(LEDG_DELAY/2));
             gpio_set_level( LEDG, 0);                 
+
+            if (queueCounters.wakeups % COUNTERS_REPORT == 0)
+            {
+                report_counters();
+            }
         }
         /*Adding a small delay just to not make sure the watchdog will not be activated*/
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
-}
\ No newline at end of file
+#endif
+}
@@ -1,12 +1,23 @@
 /***************************************************************************
 *@brief FreeRTOS: BLINKING RGB LEDS USING TASKS
-This project will make blink RGB LEDS at different frecuency using Tasks. 
+This project will make blink RGB LEDS at different frecuency using a single
+Task: the periodic output engine toggles every LED on its own period and
+sleeps with xTaskDelayUntil until the next toggle, so the periods never drift.
+app_main becomes a supervisor that blocks (leaving the core to IDLE and the
+LEDs engine) until SUPERVISOR_PERIOD expires or its task is notified. Every
+LED toggle sets its heartbeat bit in an event group and the supervisor
+reports which LEDs are alive. The CPU used by every task is sampled by the
+task_stats timer and printed as text or sent as binary records.
 ***************************************************************************/
 #include <stdio.h>
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
 #include "esp_log.h"
+#include "board_init.h"
+#include "periodic_out.h"
+#include "task_stats.h"
 
 #define LEDR    33      /*LED Red connected to PIN 33 from MCU*/
 #define LEDG    25      /*LED Green connected to PIN 25 from MCU*/
@@ -16,19 +27,58 @@ This project will make blink RGB LEDS at different frecuency using Tasks.
 #define LEDG_DELAY  2000    /*Delay set to LED Green*/
 #define LEDB_DELAY  4000    /*Delay set to LED Blue*/
 
+#define MAX_OUTPUTS 8       /*Periodic outputs the engine can drive*/
+
 #define STACK_SIZE 1024*2    /*Number of bytes the stack will hold*/
 
+/*Task placement: WiFi and the timer daemon run on core 0, the LEDs I/O on the last core*/
+#define IO_CORE     (portNUM_PROCESSORS - 1)
+#define IO_PRIORITY 2       /*Above app_main, below the timer daemon*/
+
+#define SUPERVISOR_PERIOD   10000   /*Miliseconds between supervisor reports, longer than any LED period*/
+#define STATS_PERIOD        SUPERVISOR_PERIOD   /*Miliseconds between CPU usage samples*/
+#define STATS_OUTPUT_TEXT   0       /*CPU usage printed with the logs*/
+#define STATS_OUTPUT_BINARY 1       /*CPU usage sent as framed task_stats binary records*/
+#define STATS_OUTPUT        STATS_OUTPUT_TEXT
+
+/*Heartbeat bits set by the LEDs in every blink*/
+#define HEARTBEAT_R     (1 << 0)
+#define HEARTBEAT_G     (1 << 1)
+#define HEARTBEAT_B     (1 << 2)
+#define HEARTBEAT_ALL   (HEARTBEAT_R | HEARTBEAT_G | HEARTBEAT_B)
+
 static const char *TAG = "Main";    /*Tag for the LOGS mns in terminal*/
 
+EventGroupHandle_t HeartbeatEvents = 0;     /*Heartbeats of the LEDs*/
+
+task_stats_t cpuStats;                      /*CPU usage of every task*/
+
+periodic_out_t ledEngine;                   /*Single task that toggles every LED*/
+periodic_out_entry_t ledOutputs[MAX_OUTPUTS];
+
+/*State of every blinking LED*/
+typedef struct {
+    gpio_num_t pin;
+    uint8_t level;
+    EventBits_t heartbeat;
+    const char *name;
+} blink_led_t;
+
+blink_led_t blinkLeds[] = {
+    { LEDR, 0, HEARTBEAT_R, "LED Red" },
+    { LEDG, 0, HEARTBEAT_G, "LED Green" },
+    { LEDB, 0, HEARTBEAT_B, "LED Blue" },
+};
+
 /**********************
 * Function Prototypes
 **********************/
 void app_main(void);
-void vTask_LEDR(void *pvParameters);    /*Task from LED RED created in here*/
-void vTask_LEDG(void *pvParameters);    /*Task from LED GREEN created in here*/
-void vTask_LEDB(void *pvParameters);    /*Task from LED BLUE created in here*/
+void toggle_led(void *arg);             /*Periodic action of every LED*/
 esp_err_t init_led(void);               /*Setting LEDS directions and inital level*/
-esp_err_t create_tasks(void);           /*Creating a Task for each LED*/
+esp_err_t create_tasks(void);           /*Creating the Task that blinks every LED*/
+void supervisor_loop(void);             /*Health reports, never returns*/
+void publish_stats(const task_stats_t *stats, void *arg);  /*CPU used by every task since the last sample*/
 
 /*******************************
 *   MAIN AND INIFINITE LOOP
@@ -36,99 +86,120 @@ esp_err_t create_tasks(void);           /*Creating a Task for each LED*/
 void app_main(void)
 {
     init_led();
+    HeartbeatEvents = xEventGroupCreate();  /*Created before the task that sets the heartbeats*/
     create_tasks();
-    while (1)
+    if (task_stats_init(&cpuStats) == ESP_OK)
     {
-        /* code */
+        task_stats_start(&cpuStats, STATS_PERIOD, publish_stats, NULL);
     }
-    
+    supervisor_loop();
 }
 
 /*********************
-*   LEDS SECTION
+*   SUPERVISOR SECTION
 *********************/
-esp_err_t init_led(void)
+/*app_main blocks here without using CPU, so IDLE runs and the watchdog is fed.
+  Notifying the main task (xTaskNotifyGive) requests a report at any time*/
+void supervisor_loop(void)
 {
-    gpio_reset_pin( LEDR);
-    gpio_set_direction( LEDR, GPIO_MODE_OUTPUT);
+    const TickType_t period = pdMS_TO_TICKS(SUPERVISOR_PERIOD);
+    TickType_t judged = xTaskGetTickCount();    /*Last time the heartbeats were judged*/
+    uint32_t reportedLate = 0;                  /*Late wake ups already reported*/
 
-    gpio_reset_pin( LEDG);
-    gpio_set_direction( LEDG, GPIO_MODE_OUTPUT);
+    while (1)
+    {
+        /*An early report does not restart the period, only the time left is waited*/
+        TickType_t elapsed = xTaskGetTickCount() - judged;
+        ulTaskNotifyTake(pdTRUE, elapsed < period ? period - elapsed : 0);
+
+        /*Heartbeats are only judged after a full period, before it a slow LED
+          may not have blinked yet*/
+        if (xTaskGetTickCount() - judged >= period)
+        {
+            judged = xTaskGetTickCount();
+
+            /*Read and clear the heartbeats received during the period*/
+            EventBits_t alive = xEventGroupClearBits(HeartbeatEvents, HEARTBEAT_ALL);
+            for (size_t i = 0; i < sizeof(blinkLeds) / sizeof(blinkLeds[0]); i++)
+            {
+                if (!(alive & blinkLeds[i].heartbeat))
+                {
+                    ESP_LOGE(TAG, "%s missed its heartbeat", blinkLeds[i].name);
+                }
+            }
+        }
+        /*Only the late wake ups since the last report, the counter never resets*/
+        uint32_t late = ledEngine.late;
+        if (late != reportedLate)
+        {
+            ESP_LOGW(TAG, "LEDs engine woke up late %lu times (%lu in total)", (unsigned long)(late - reportedLate),
+                     (unsigned long)late);
+            reportedLate = late;
+        }
+    }
+}
 
-    gpio_reset_pin( LEDB);
-    gpio_set_direction( LEDB, GPIO_MODE_OUTPUT);
+/*Executed from the timer daemon with every CPU sample*/
+void publish_stats(const task_stats_t *stats, void *arg)
+{
+#if STATS_OUTPUT == STATS_OUTPUT_BINARY
+    static uint8_t frame[TASK_STATS_FRAME_MAX];
+    size_t len = 0;
 
-    /*Initialize each LED in LOW level*/
-    gpio_set_level(LEDR, 0);
-    gpio_set_level(LEDG, 0);
-    gpio_set_level(LEDB, 0);
+    /*Console UART shared with the logs: framed, tools/task_stats_decode.py finds the records*/
+    if (task_stats_encode_frame(stats, frame, sizeof(frame), &len) == ESP_OK)
+    {
+        fwrite(frame, 1, len, stdout);
+        fflush(stdout);
+    }
+#else
+    task_stats_log(stats);
+#endif
+}
 
-    return ESP_OK;
+/*********************
+*   LEDS SECTION
+*********************/
+esp_err_t init_led(void)
+{
+    /*Every LED as output and initialized in LOW level with a single configuration*/
+    static const board_pin_t ledPins[] = {
+        { .pin = LEDR, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+        { .pin = LEDG, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+        { .pin = LEDB, .mode = GPIO_MODE_OUTPUT, .level = 0 },
+    };
+
+    return board_init_pins(ledPins, sizeof(ledPins) / sizeof(ledPins[0]), NULL);
 }
 
 /*********************
 *   TASKS SECTION
 *********************/
 esp_err_t create_tasks(void){
-    static uint8_t ucParameterToPass;
-    TaskHandle_t xHandle = NULL;
-
-    /*Creating Task for LED RED*/
-    xTaskCreate( vTask_LEDR, 
-                "vTask_LEDR", 
-                STACK_SIZE, 
-                &ucParameterToPass, 
-                1, &xHandle );
-
-    /*Creating Task for LED GREEN*/
-    xTaskCreate( vTask_LEDG, 
-                "vTask_LEDG", 
-                STACK_SIZE, 
-                &ucParameterToPass, 
-                1, &xHandle );
-
-    /*Creating Task for LED BLUE*/
-    xTaskCreate( vTask_LEDB, 
-                "vTask_LEDB", 
-                STACK_SIZE, 
-                &ucParameterToPass, 
-                1, &xHandle );
-
-    return ESP_OK;
-}
+    periodic_out_init(&ledEngine, ledOutputs, MAX_OUTPUTS);
 
-/*Actions to be executed once created Task LED Red*/
-void vTask_LEDR(void *pvParameters)
-{
-    while (1)
-    {
-      gpio_set_level( LEDR, 0);
-      vTaskDelay(pdMS_TO_TICKS(LEDR_DELAY)); 
-      gpio_set_level( LEDR, 1);
-      vTaskDelay(pdMS_TO_TICKS(LEDR_DELAY));  
-    }    
-}
+    /*Every LED toggles once per delay, as the former task per LED did*/
+    periodic_out_add(&ledEngine, pdMS_TO_TICKS(LEDR_DELAY), pdMS_TO_TICKS(LEDR_DELAY), toggle_led, &blinkLeds[0]);
+    periodic_out_add(&ledEngine, pdMS_TO_TICKS(LEDG_DELAY), pdMS_TO_TICKS(LEDG_DELAY), toggle_led, &blinkLeds[1]);
+    periodic_out_add(&ledEngine, pdMS_TO_TICKS(LEDB_DELAY), pdMS_TO_TICKS(LEDB_DELAY), toggle_led, &blinkLeds[2]);
 
-/*Actions to be executed once created Task LED Green*/
-void vTask_LEDG(void *pvParameters)
-{
-    while (1)
+    esp_err_t ret = periodic_out_start(&ledEngine, "vTask_LEDS", STACK_SIZE, IO_PRIORITY, IO_CORE);
+    if (ret != ESP_OK)
     {
-      gpio_set_level( LEDG, 0);
-      vTaskDelay(pdMS_TO_TICKS(LEDG_DELAY)); 
-      gpio_set_level( LEDG, 1);
-      vTaskDelay(pdMS_TO_TICKS(LEDG_DELAY));        
-    }    
+        ESP_LOGE(TAG, "LEDs task was not created");
+    }
+    return ret;
 }
 
-/*Actions to be executed once created Task LED Green*/
-void vTask_LEDB(void *pvParameters)
+/*Executed by the LEDs engine every period of a LED*/
+void toggle_led(void *arg)
 {
-    while (1)
+    blink_led_t *led = (blink_led_t *)arg;
+
+    led->level = !led->level;
+    gpio_set_level(led->pin, led->level);
+    if (led->level)
     {
-      gpio_set_level( LEDB, 0);
-      vTaskDelay(pdMS_TO_TICKS(LEDB_DELAY)); 
-      gpio_set_level( LEDB, 1);
-      vTaskDelay(pdMS_TO_TICKS(LEDB_DELAY));        
-    }    
-}
\ No newline at end of file
+        xEventGroupSetBits(HeartbeatEvents, led->heartbeat);    /*LED alive for the supervisor*/
+    }
+}
@@ -0,0 +1,32 @@
+/***************************************************************************
+*@brief Latency histogram
+***************************************************************************/
+#include <string.h>
+#include "latency_hist.h"
+
+void latency_hist_reset(latency_hist_t *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min = UINT32_MAX;
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t permille)
+{
+    uint32_t target = (uint32_t)(((uint64_t)hist->count * permille + 999) / 1000);     /*Rounded up*/
+    uint32_t seen = 0;
+
+    if (hist->count == 0)
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < LATENCY_HIST_BINS; i++)
+    {
+        seen += hist->bins[i];
+        if (seen >= target)
+        {
+            uint32_t edge = (i + 1) * LATENCY_HIST_BIN_CYCLES - 1;
+            return (edge < hist->max) ? edge : hist->max;
+        }
+    }
+    return hist->max;   /*In the overflow*/
+}
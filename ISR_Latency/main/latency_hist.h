@@ -0,0 +1,41 @@
+/***************************************************************************
+*@brief Latency histogram
+Fixed width bins of LATENCY_HIST_BIN_CYCLES cycles, plus the exact minimum
+and maximum. Percentiles are given as the upper edge of their bin.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+
+#define LATENCY_HIST_BINS       512
+#define LATENCY_HIST_BIN_CYCLES 32      /*Bins cover up to 16384 cycles, ~68 us at 240 MHz*/
+
+typedef struct {
+    uint32_t bins[LATENCY_HIST_BINS];
+    uint32_t overflow;          /*Samples beyond the last bin*/
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+} latency_hist_t;
+
+void latency_hist_reset(latency_hist_t *hist);
+
+/*Cycles below which 'permille' of the samples are (500 = p50, 990 = p99)*/
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t permille);
+
+static inline void latency_hist_add(latency_hist_t *hist, uint32_t cycles)
+{
+    uint32_t bin = cycles / LATENCY_HIST_BIN_CYCLES;
+
+    if (bin < LATENCY_HIST_BINS)
+    {
+        hist->bins[bin]++;
+    }
+    else
+    {
+        hist->overflow++;
+    }
+    hist->count++;
+    hist->min = (cycles < hist->min) ? cycles : hist->min;
+    hist->max = (cycles > hist->max) ? cycles : hist->max;
+}
@@ -0,0 +1,122 @@
+/***************************************************************************
+*@brief Latency probe: wakes a task from an ISR and times the wake up
+***************************************************************************/
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "latency_probe.h"
+
+static const char *TAG = "latency_probe";
+
+static const char *primitiveNames[LATENCY_PROBE_PRIMITIVES] = { "semaphore", "notify", "queue" };
+
+esp_err_t latency_probe_init(latency_probe_t *probe, latency_probe_clock_t clock)
+{
+    ESP_RETURN_ON_FALSE(probe && clock, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    *probe = (latency_probe_t){ .clock = clock };
+    probe->semaphore = xSemaphoreCreateBinary();
+    probe->queue = xQueueCreate(1, sizeof(uint32_t));
+    if (!probe->semaphore || !probe->queue)
+    {
+        latency_probe_deinit(probe);
+        ESP_LOGE(TAG, "no memory for the primitives");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void latency_probe_deinit(latency_probe_t *probe)
+{
+    if (probe->semaphore)
+    {
+        vSemaphoreDelete(probe->semaphore);
+        probe->semaphore = NULL;
+    }
+    if (probe->queue)
+    {
+        vQueueDelete(probe->queue);
+        probe->queue = NULL;
+    }
+}
+
+esp_err_t latency_probe_arm(latency_probe_t *probe, latency_probe_primitive_t primitive, TaskHandle_t waiter)
+{
+    ESP_RETURN_ON_FALSE(probe && waiter && primitive < LATENCY_PROBE_PRIMITIVES, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+
+    probe->armed = false;
+    xSemaphoreTake(probe->semaphore, 0);    /*Nothing left from the previous measure*/
+    xQueueReset(probe->queue);
+    xTaskNotifyStateClear(waiter);
+    ulTaskNotifyValueClear(waiter, UINT32_MAX);
+    probe->primitive = primitive;
+    probe->waiter = waiter;
+    probe->armed = true;
+    return ESP_OK;
+}
+
+void latency_probe_disarm(latency_probe_t *probe)
+{
+    probe->armed = false;
+}
+
+bool IRAM_ATTR latency_probe_signal_from_isr(latency_probe_t *probe)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uint32_t stamp = probe->clock();
+
+    if (!probe->armed)
+    {
+        return false;
+    }
+    probe->stamp = stamp;
+    switch (probe->primitive)
+    {
+    case LATENCY_PROBE_SEMAPHORE:
+        xSemaphoreGiveFromISR(probe->semaphore, &xHigherPriorityTaskWoken);
+        break;
+    case LATENCY_PROBE_NOTIFY:
+        vTaskNotifyGiveFromISR(probe->waiter, &xHigherPriorityTaskWoken);
+        break;
+    default:
+        xQueueOverwriteFromISR(probe->queue, &stamp, &xHigherPriorityTaskWoken);   /*The stamp travels in it*/
+        break;
+    }
+    return xHigherPriorityTaskWoken == pdTRUE;
+}
+
+esp_err_t latency_probe_wait(latency_probe_t *probe, TickType_t timeout, uint32_t *latency)
+{
+    BaseType_t received = pdFALSE;
+    uint32_t stamp = 0;
+    uint32_t now = 0;
+
+    switch (probe->primitive)
+    {
+    case LATENCY_PROBE_SEMAPHORE:
+        received = xSemaphoreTake(probe->semaphore, timeout);
+        stamp = probe->stamp;   /*Before the clock: a newer stamp cannot exceed it*/
+        now = probe->clock();
+        break;
+    case LATENCY_PROBE_NOTIFY:
+        received = (ulTaskNotifyTake(pdTRUE, timeout) > 0) ? pdTRUE : pdFALSE;
+        stamp = probe->stamp;
+        now = probe->clock();
+        break;
+    default:
+        received = xQueueReceive(probe->queue, &stamp, timeout);
+        now = probe->clock();
+        break;
+    }
+    if (received != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT;     /*Not an error for the caller that polls*/
+    }
+    *latency = now - stamp;
+    return ESP_OK;
+}
+
+const char *latency_probe_name(latency_probe_primitive_t primitive)
+{
+    return (primitive < LATENCY_PROBE_PRIMITIVES) ? primitiveNames[primitive] : "unknown";
+}
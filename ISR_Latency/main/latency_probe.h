@@ -0,0 +1,56 @@
+/***************************************************************************
+*@brief Latency probe: wakes a task from an ISR and times the wake up
+The ISR takes a timestamp and signals the waiting task with one of the
+FreeRTOS primitives: xSemaphoreGiveFromISR, vTaskNotifyGiveFromISR or
+xQueueOverwriteFromISR (the stamp travels in a queue of one). The woken task
+takes the timestamp again and returns the difference. The clock is given at
+init (the cycle counter on the target, any counter on the host) and must be
+callable from the ISR.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+
+typedef enum {
+    LATENCY_PROBE_SEMAPHORE,
+    LATENCY_PROBE_NOTIFY,
+    LATENCY_PROBE_QUEUE,
+    LATENCY_PROBE_PRIMITIVES,
+} latency_probe_primitive_t;
+
+typedef uint32_t (*latency_probe_clock_t)(void);
+
+typedef struct {
+    latency_probe_clock_t clock;
+    SemaphoreHandle_t semaphore;
+    QueueHandle_t queue;
+    volatile latency_probe_primitive_t primitive;
+    volatile bool armed;                /*The ISR only signals while a task waits*/
+    volatile uint32_t stamp;            /*Timestamp of the last signal*/
+    TaskHandle_t volatile waiter;
+} latency_probe_t;
+
+esp_err_t latency_probe_init(latency_probe_t *probe, latency_probe_clock_t clock);
+
+void latency_probe_deinit(latency_probe_t *probe);
+
+/*Drops any signal left and lets the ISR wake 'waiter' with 'primitive'*/
+esp_err_t latency_probe_arm(latency_probe_t *probe, latency_probe_primitive_t primitive, TaskHandle_t waiter);
+
+/*The ISR stops signaling, the waiter does not get more wake ups*/
+void latency_probe_disarm(latency_probe_t *probe);
+
+/*From the ISR: stamps and signals the waiter, true if a context switch is needed*/
+bool latency_probe_signal_from_isr(latency_probe_t *probe);
+
+/*From the waiter: blocks up to 'timeout' for a signal, 'latency' receives the
+  clock counts since it was stamped*/
+esp_err_t latency_probe_wait(latency_probe_t *probe, TickType_t timeout, uint32_t *latency);
+
+const char *latency_probe_name(latency_probe_primitive_t primitive);
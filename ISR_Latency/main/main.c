@@ -0,0 +1,235 @@
+/***************************************************************************
+*@brief ISR to Task wake up latency
+A GPTimer alarm interrupts every ALARM_PERIOD_US. The callback takes the
+cycle count and wakes a waiting task with one of the FreeRTOS primitives:
+xSemaphoreGiveFromISR, vTaskNotifyGiveFromISR or xQueueOverwriteFromISR. The
+woken task takes the cycle count again, the difference is the latency. The
+signal and the wait live in latency_probe, which the host test drives from a
+thread standing for the timer.
+Every primitive is measured with the task on the same core as the
+interrupt and on the other core. The cycle counter of every core runs on
+its own, so the offset between both is calibrated at startup.
+Expected behavior:
+A CSV table with p50/p99/max of every primitive and core placement is
+printed to the monitor device, ready to be copied into a spreadsheet.
+***************************************************************************/
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gptimer.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "latency_hist.h"
+#include "latency_probe.h"
+
+#define ALARM_PERIOD_US     1000    /*Microseconds between interrupts, long enough for the task to wait again*/
+#define SAMPLES             10000   /*Wake ups measured for every primitive and placement*/
+#define CALIBRATION_ROUNDS  1000    /*Ping-pongs between cores to find the cycle counter offset*/
+
+#define WAITER_PRIORITY     (configMAX_PRIORITIES - 2)
+#define STACK_SIZE          1024*3  /*Number of bytes the stack will hold*/
+
+static const char *TAG = "Main";    /*Tag for the LOGS mns in terminal*/
+
+static latency_probe_t probe;               /*Shared by the alarm callback and the waiting task*/
+static TaskHandle_t mainTask;
+static BaseType_t isrCore;                  /*Core that runs the alarm callback*/
+static int32_t coreOffset[portNUM_PROCESSORS];  /*Cycle counter of every core minus the one of isrCore*/
+static latency_hist_t hist;
+
+/*Calibration ping-pong*/
+static volatile uint32_t calStamp;
+static volatile int calTurn;
+static int32_t calForward;                  /*Min of other - isrCore + transfer time*/
+
+/**********************
+* Function Prototypes
+**********************/
+void app_main(void);
+esp_err_t set_timer(gptimer_handle_t *timer);       /*GPTimer with the periodic alarm*/
+static uint32_t cycle_count(void);                  /*Clock of the probe*/
+void calibrate_cores(void);                         /*Offset between the cycle counters of both cores*/
+esp_err_t measure(gptimer_handle_t timer, latency_probe_primitive_t primitive, BaseType_t core);
+void print_csv_row(latency_probe_primitive_t primitive, BaseType_t core);
+
+/*******************************
+*   MAIN
+*******************************/
+void app_main(void)
+{
+    gptimer_handle_t timer = NULL;
+
+    mainTask = xTaskGetCurrentTaskHandle();
+    if (latency_probe_init(&probe, cycle_count) != ESP_OK || set_timer(&timer) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Benchmark could not start");
+        return;
+    }
+    isrCore = xPortGetCoreID();     /*The interrupt was allocated on this core*/
+    calibrate_cores();
+
+    printf("primitive,placement,samples,min_cycles,p50_cycles,p99_cycles,max_cycles,p50_us,p99_us,max_us\n");
+    for (latency_probe_primitive_t primitive = 0; primitive < LATENCY_PROBE_PRIMITIVES; primitive++)
+    {
+        for (BaseType_t core = 0; core < portNUM_PROCESSORS; core++)
+        {
+            if (measure(timer, primitive, core) == ESP_OK)
+            {
+                print_csv_row(primitive, core);
+            }
+        }
+    }
+    gptimer_disable(timer);
+    gptimer_del_timer(timer);
+}
+
+/*********************
+*   TIMER SECTION
+*********************/
+static uint32_t IRAM_ATTR cycle_count(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+
+static bool IRAM_ATTR alarm_callback(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *user_ctx)
+{
+    return latency_probe_signal_from_isr(&probe);   /*Switch to the woken task when the ISR returns*/
+}
+
+esp_err_t set_timer(gptimer_handle_t *timer)
+{
+    gptimer_config_t timerConfig = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,       /*1 tick = 1 us*/
+    };
+    gptimer_alarm_config_t alarmConfig = {
+        .alarm_count = ALARM_PERIOD_US,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    gptimer_event_callbacks_t callbacks = {
+        .on_alarm = alarm_callback,
+    };
+
+    ESP_RETURN_ON_ERROR(gptimer_new_timer(&timerConfig, timer), TAG, "timer was not created");
+    ESP_RETURN_ON_ERROR(gptimer_register_event_callbacks(*timer, &callbacks, NULL), TAG,
+                        "callback was not registered");    /*The interrupt is allocated on this core*/
+    ESP_RETURN_ON_ERROR(gptimer_set_alarm_action(*timer, &alarmConfig), TAG, "alarm was not set");
+    return gptimer_enable(*timer);
+}
+
+/*********************
+*   CORES SECTION
+*********************/
+/*Answers every ping of isrCore from the other core*/
+static void calibration_task(void *pvParameters)
+{
+    calForward = INT32_MAX;
+    for (int i = 0; i < CALIBRATION_ROUNDS; i++)
+    {
+        while (calTurn != 1)
+        {
+        }
+        int32_t forward = (int32_t)(esp_cpu_get_cycle_count() - calStamp);
+        calForward = (forward < calForward) ? forward : calForward;
+        calStamp = esp_cpu_get_cycle_count();
+        calTurn = 2;
+    }
+    xTaskNotifyGive(mainTask);
+    vTaskDelete(NULL);
+}
+
+/*forward = offset + transfer, backward = -offset + transfer, so the transfer
+  time cancels: offset = (forward - backward) / 2*/
+void calibrate_cores(void)
+{
+#if portNUM_PROCESSORS > 1
+    BaseType_t other = !isrCore;
+    int32_t backward = INT32_MAX;
+
+    calTurn = 0;
+    if (xTaskCreatePinnedToCore(calibration_task, "calibration", STACK_SIZE, NULL, WAITER_PRIORITY, NULL, other)
+        != pdPASS)
+    {
+        ESP_LOGW(TAG, "Cores not calibrated, cross core results include their offset");
+        return;
+    }
+    for (int i = 0; i < CALIBRATION_ROUNDS; i++)
+    {
+        calStamp = esp_cpu_get_cycle_count();
+        calTurn = 1;
+        while (calTurn != 2)
+        {
+        }
+        int32_t delta = (int32_t)(esp_cpu_get_cycle_count() - calStamp);
+        backward = (delta < backward) ? delta : backward;
+        calTurn = 0;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    coreOffset[other] = (calForward - backward) / 2;
+    ESP_LOGI(TAG, "Core %d counter is %ld cycles ahead of core %d", (int)other, (long)coreOffset[other], (int)isrCore);
+#endif
+}
+
+/*********************
+*   MEASURE SECTION
+*********************/
+static void waiter_task(void *pvParameters)
+{
+    int32_t offset = coreOffset[xPortGetCoreID()];
+    uint32_t latency = 0;
+
+    /*Armed by the waiter itself: the alarms before it waits do not signal*/
+    latency_probe_arm(&probe, (latency_probe_primitive_t)(uintptr_t)pvParameters, xTaskGetCurrentTaskHandle());
+    while (hist.count < SAMPLES)
+    {
+        if (latency_probe_wait(&probe, portMAX_DELAY, &latency) == ESP_OK)
+        {
+            latency_hist_add(&hist, latency - (uint32_t)offset);
+        }
+    }
+
+    /*The task is deleted by app_main once the interrupts stopped*/
+    latency_probe_disarm(&probe);
+    xTaskNotifyGive(mainTask);
+    vTaskSuspend(NULL);
+}
+
+esp_err_t measure(gptimer_handle_t timer, latency_probe_primitive_t primitive, BaseType_t core)
+{
+    TaskHandle_t waiter = NULL;
+
+    latency_hist_reset(&hist);
+    if (xTaskCreatePinnedToCore(waiter_task, "waiter", STACK_SIZE, (void *)(uintptr_t)primitive, WAITER_PRIORITY,
+                                &waiter, core) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Waiter task of %s was not created", latency_probe_name(primitive));
+        return ESP_ERR_NO_MEM;
+    }
+    gptimer_set_raw_count(timer, 0);
+    gptimer_start(timer);
+
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    gptimer_stop(timer);
+    vTaskDelete(waiter);
+    return ESP_OK;
+}
+
+void print_csv_row(latency_probe_primitive_t primitive, BaseType_t core)
+{
+    uint32_t cyclesPerUs = esp_rom_get_cpu_ticks_per_us();
+    uint32_t p50 = latency_hist_percentile(&hist, 500);
+    uint32_t p99 = latency_hist_percentile(&hist, 990);
+
+    printf("%s,%s,%lu,%lu,%lu,%lu,%lu,%lu.%02lu,%lu.%02lu,%lu.%02lu\n", latency_probe_name(primitive),
+           (core == isrCore) ? "same core" : "cross core", (unsigned long)hist.count,
+           (unsigned long)hist.min, (unsigned long)p50, (unsigned long)p99, (unsigned long)hist.max,
+           (unsigned long)(p50 / cyclesPerUs), (unsigned long)(p50 % cyclesPerUs * 100 / cyclesPerUs),
+           (unsigned long)(p99 / cyclesPerUs), (unsigned long)(p99 % cyclesPerUs * 100 / cyclesPerUs),
+           (unsigned long)(hist.max / cyclesPerUs), (unsigned long)(hist.max % cyclesPerUs * 100 / cyclesPerUs));
+}
@@ -0,0 +1,72 @@
+/***************************************************************************
+*@brief Board Init: configuration of every pin from one descriptor table
+***************************************************************************/
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "gpio_bank.h"
+#include "board_init.h"
+
+#define MAX_GROUPS  8   /*Different mode/pull combinations in one table*/
+
+static const char *TAG = "board_init";
+
+esp_err_t board_init_pins(const board_pin_t *pins, size_t count, int64_t *elapsed_us)
+{
+    int64_t start = esp_timer_get_time();
+    gpio_config_t groups[MAX_GROUPS] = {0};
+    uint8_t group_count = 0;
+    gpio_num_t outputs[GPIO_BANK_MAX_PINS];
+    uint32_t levels = 0;
+    uint8_t output_count = 0;
+    gpio_bank_t bank;
+
+    ESP_RETURN_ON_FALSE(pins || count == 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    /*Pins with the same settings are joined in one bitmask*/
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t g = 0;
+
+        while (g < group_count && !(groups[g].mode == pins[i].mode &&
+                                    groups[g].pull_up_en == pins[i].pull_up &&
+                                    groups[g].pull_down_en == pins[i].pull_down))
+        {
+            g++;
+        }
+        if (g == group_count)
+        {
+            ESP_RETURN_ON_FALSE(group_count < MAX_GROUPS, ESP_ERR_INVALID_ARG, TAG, "too many pin settings");
+            groups[g].mode = pins[i].mode;
+            groups[g].pull_up_en = pins[i].pull_up;
+            groups[g].pull_down_en = pins[i].pull_down;
+            groups[g].intr_type = GPIO_INTR_DISABLE;
+            group_count++;
+        }
+        groups[g].pin_bit_mask |= 1ULL << pins[i].pin;
+
+        if (pins[i].mode & GPIO_MODE_DEF_OUTPUT)
+        {
+            ESP_RETURN_ON_FALSE(output_count < GPIO_BANK_MAX_PINS, ESP_ERR_INVALID_ARG, TAG, "too many outputs");
+            levels |= (pins[i].level ? 1UL : 0UL) << output_count;
+            outputs[output_count++] = pins[i].pin;
+        }
+    }
+
+    /*Output levels are preloaded while the output drivers are still disabled*/
+    ESP_RETURN_ON_ERROR(gpio_bank_init(&bank, outputs, output_count), TAG, "invalid output pin");
+    gpio_bank_write(&bank, levels);
+
+    for (uint8_t g = 0; g < group_count; g++)
+    {
+        ESP_RETURN_ON_ERROR(gpio_config(&groups[g]), TAG, "gpio_config failed");
+    }
+
+    int64_t elapsed = esp_timer_get_time() - start;
+    ESP_LOGI(TAG, "%u pins initialized in %lld us", (unsigned)count, elapsed);
+    if (elapsed_us)
+    {
+        *elapsed_us = elapsed;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,32 @@
+/***************************************************************************
+*@brief Board Init: configuration of every pin from one descriptor table
+Pins sharing the same mode and pulls are configured with a single
+gpio_config() bitmask. The level of every output is written to the output
+registers before its driver is enabled, so the pins never glitch through
+an undefined level during the startup.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    gpio_num_t pin;
+    gpio_mode_t mode;
+    uint8_t level;              /*Initial level of outputs*/
+    gpio_pullup_t pull_up;
+    gpio_pulldown_t pull_down;
+} board_pin_t;
+
+/*'elapsed_us' (may be NULL) returns the time spent configuring the pins*/
+esp_err_t board_init_pins(const board_pin_t *pins, size_t count, int64_t *elapsed_us);
+
+#ifdef __cplusplus
+}
+#endif
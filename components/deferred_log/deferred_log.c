@@ -0,0 +1,179 @@
+/***************************************************************************
+*@brief Deferred Log: binary log records formatted away from the hot path
+***************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "stream_frame.h"
+#include "deferred_log.h"
+
+static const char *TAG = "deferred_log";
+
+/*Letter and color of every esp_log_level_t, as ESP_LOGx prints them*/
+static const char levelLetters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+static const char *const levelColors[] = { "", LOG_COLOR_E, LOG_COLOR_W, LOG_COLOR_I, LOG_COLOR_D, LOG_COLOR_V };
+
+/*Bounded queue of multiple producers: every slot sequence tells whether it is free for the
+  producer reserving position 'pos' (sequence == pos) or written for the flush task (pos + 1).
+  In IRAM, so ISRs can log while the flash cache is disabled*/
+bool IRAM_ATTR deferred_log_write(deferred_log_t *log, esp_log_level_t level, const char *format, uint32_t nargs,
+                                  uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+    uint32_t pos = atomic_load_explicit(&log->head, memory_order_relaxed);
+    deferred_log_slot_t *slot;
+
+    while (1)
+    {
+        slot = &log->slots[pos & log->mask];
+        int32_t diff = (int32_t)(atomic_load_explicit(&slot->sequence, memory_order_acquire) - pos);
+
+        if (diff == 0)
+        {
+            uint_fast32_t expected = pos;
+            if (atomic_compare_exchange_weak_explicit(&log->head, &expected, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+            pos = expected;
+        }
+        else if (diff < 0)
+        {
+            atomic_fetch_add_explicit(&log->dropped, 1, memory_order_relaxed);  /*Full, not flushed yet*/
+            return false;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&log->head, memory_order_relaxed);   /*Taken by another producer*/
+        }
+    }
+
+    slot->timestamp = (uint32_t)esp_timer_get_time();
+    slot->format = format;
+    slot->nargs = (uint8_t)nargs;
+    slot->level = (uint8_t)level;
+    slot->args[0] = arg0;
+    slot->args[1] = arg1;
+    slot->args[2] = arg2;
+    slot->args[3] = arg3;
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+static void print_record(const deferred_log_slot_t *slot)
+{
+    uint8_t level = (slot->level <= ESP_LOG_VERBOSE) ? slot->level : ESP_LOG_NONE;
+
+    printf("%s%c (%lu) ", levelColors[level], levelLetters[level], (unsigned long)(slot->timestamp / 1000));
+    printf(slot->format, slot->args[0], slot->args[1], slot->args[2], slot->args[3]);
+    printf(LOG_RESET_COLOR "\n");
+}
+
+static void write_record(uint32_t timestamp, esp_log_level_t level, const char *format, uint32_t nargs,
+                         const uint32_t *args)
+{
+    uint8_t record[10 + DEFERRED_LOG_MAX_ARGS * sizeof(uint32_t)];
+    uint8_t frame[STREAM_FRAME_MAX_SIZE(sizeof(record))];
+    uint32_t address = (uint32_t)(uintptr_t)format;
+    size_t length = 10 + nargs * sizeof(uint32_t);
+
+    record[0] = (uint8_t)nargs;
+    record[1] = (uint8_t)level;
+    memcpy(&record[2], &timestamp, sizeof(timestamp));     /*The targets are little endian*/
+    memcpy(&record[6], &address, sizeof(address));
+    memcpy(&record[10], args, nargs * sizeof(uint32_t));
+    fwrite(frame, 1, stream_frame_encode(DEFERRED_LOG_SYNC, record, length, frame), stdout);
+}
+
+void deferred_log_flush(deferred_log_t *log)
+{
+    uint32_t dropped = atomic_exchange_explicit(&log->dropped, 0, memory_order_relaxed);
+    uint32_t flushed = 0;
+
+    while (1)
+    {
+        deferred_log_slot_t *slot = &log->slots[log->tail & log->mask];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != log->tail + 1)
+        {
+            break;      /*Empty, or the next record is still being written*/
+        }
+
+        if (log->output == DEFERRED_LOG_BINARY)
+        {
+            write_record(slot->timestamp, (esp_log_level_t)slot->level, slot->format, slot->nargs, slot->args);
+        }
+        else
+        {
+            print_record(slot);
+        }
+        /*Free for the producer that reaches this slot one lap later*/
+        atomic_store_explicit(&slot->sequence, log->tail + log->mask + 1, memory_order_release);
+        log->tail++;
+        flushed++;
+    }
+
+    if (dropped)
+    {
+        if (log->output == DEFERRED_LOG_BINARY)
+        {
+            write_record((uint32_t)esp_timer_get_time(), ESP_LOG_WARN, NULL, 1, &dropped);
+        }
+        else
+        {
+            printf(LOG_COLOR_W "W (%lu) %lu log records dropped" LOG_RESET_COLOR "\n",
+                   (unsigned long)(esp_timer_get_time() / 1000), (unsigned long)dropped);
+        }
+    }
+    if (flushed || dropped)
+    {
+        fflush(stdout);
+    }
+}
+
+static void deferred_log_task(void *pvParameters)
+{
+    deferred_log_t *log = (deferred_log_t *)pvParameters;
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (1)
+    {
+        xTaskDelayUntil(&lastWake, log->period);
+        deferred_log_flush(log);
+    }
+}
+
+esp_err_t deferred_log_init(deferred_log_t *log, void *storage, uint32_t capacity, deferred_log_output_t output)
+{
+    ESP_RETURN_ON_FALSE(log && storage, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(capacity >= 2 && (capacity & (capacity - 1)) == 0, ESP_ERR_INVALID_ARG, TAG,
+                        "capacity must be a power of two");
+
+    log->slots = (deferred_log_slot_t *)storage;
+    log->mask = capacity - 1;
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        atomic_init(&log->slots[i].sequence, i);
+    }
+    atomic_init(&log->head, 0);
+    atomic_init(&log->dropped, 0);
+    log->tail = 0;
+    log->output = output;
+    log->period = 1;
+    log->task = NULL;
+    return ESP_OK;
+}
+
+esp_err_t deferred_log_start(deferred_log_t *log, const char *name, uint32_t stack, UBaseType_t priority,
+                             BaseType_t core, uint32_t period_ms)
+{
+    ESP_RETURN_ON_FALSE(log && log->slots, ESP_ERR_INVALID_ARG, TAG, "log not initialized");
+    ESP_RETURN_ON_FALSE(log->task == NULL, ESP_ERR_INVALID_STATE, TAG, "flush task already started");
+
+    log->period = pdMS_TO_TICKS(period_ms) ? pdMS_TO_TICKS(period_ms) : 1;
+    ESP_RETURN_ON_FALSE(xTaskCreatePinnedToCore(deferred_log_task, name, stack, log, priority, &log->task,
+                                                core) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG, "flush task was not created");
+    return ESP_OK;
+}
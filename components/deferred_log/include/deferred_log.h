@@ -0,0 +1,104 @@
+/***************************************************************************
+*@brief Deferred Log: binary log records formatted away from the hot path
+DEFERRED_LOG() only stores {timestamp, level, format pointer, up to 4
+arguments} into a lock-free ring, so the caller neither formats the string nor waits
+for the UART. A low priority flush task empties the ring and either prints
+the lines (DEFERRED_LOG_TEXT) or streams the binary records
+(DEFERRED_LOG_BINARY) for tools/deferred_log_decode.py, which reads the
+format strings back from the ELF of the application.
+The text lines keep the letter and color of their level, as ESP_LOGx.
+Any task or ISR can log, on any core (deferred_log_write() is in IRAM). Arguments are stored as 32 bits:
+integers, chars and pointers only, and %s strings must live forever (string
+literals, const tables). A full ring drops the record and counts it.
+
+Binary record, little endian, framed by stream_frame (sync 0x5AA5, escaped
+bytes and a CRC-16 that survive the console):
+  args u8 | level u8 | timestamp u32 (us) | format u32 (address in the ELF) |
+  argument u32 * args
+A record with format 0 reports in its argument the records dropped.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "stream_frame.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEFERRED_LOG_MAX_ARGS   4
+#define DEFERRED_LOG_SYNC       STREAM_FRAME_SYNC(0x5A)
+
+typedef enum {
+    DEFERRED_LOG_TEXT,          /*The flush task formats and prints every line*/
+    DEFERRED_LOG_BINARY,        /*The flush task writes the raw records*/
+} deferred_log_output_t;
+
+typedef struct {
+    atomic_uint_fast32_t sequence;  /*Tells producers and the flush task who owns the slot*/
+    uint32_t timestamp;
+    const char *format;
+    uint8_t nargs;
+    uint8_t level;                  /*esp_log_level_t*/
+    uint32_t args[DEFERRED_LOG_MAX_ARGS];
+} deferred_log_slot_t;
+
+typedef struct {
+    deferred_log_slot_t *slots;
+    uint32_t mask;                  /*capacity - 1*/
+    atomic_uint_fast32_t head;      /*Slots reserved by the producers*/
+    uint32_t tail;                  /*Slots flushed, only written by the flush task*/
+    atomic_uint_fast32_t dropped;
+    deferred_log_output_t output;
+    uint32_t period;                /*Ticks between flushes*/
+    TaskHandle_t task;
+} deferred_log_t;
+
+#define DEFERRED_LOG_STORAGE_SIZE(capacity)     ((capacity) * sizeof(deferred_log_slot_t))
+
+/*'storage' holds DEFERRED_LOG_STORAGE_SIZE(capacity) bytes, the capacity must be a power of two*/
+esp_err_t deferred_log_init(deferred_log_t *log, void *storage, uint32_t capacity, deferred_log_output_t output);
+
+/*The flush task wakes every 'period_ms' and prints or streams whatever was logged*/
+esp_err_t deferred_log_start(deferred_log_t *log, const char *name, uint32_t stack, UBaseType_t priority,
+                             BaseType_t core, uint32_t period_ms);
+
+/*Empties the ring from the calling task, what the flush task does every period*/
+void deferred_log_flush(deferred_log_t *log);
+
+/*Never blocks, false when the ring was full*/
+bool deferred_log_write(deferred_log_t *log, esp_log_level_t level, const char *format, uint32_t nargs,
+                        uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+
+#define DEFERRED_LOG_ARG(x)     ((uint32_t)(uintptr_t)(x))
+
+#define DEFERRED_LOG_0(log, level, format)              deferred_log_write(log, level, format, 0, 0, 0, 0, 0)
+#define DEFERRED_LOG_1(log, level, format, a)           deferred_log_write(log, level, format, 1, DEFERRED_LOG_ARG(a), \
+                                                                           0, 0, 0)
+#define DEFERRED_LOG_2(log, level, format, a, b)        deferred_log_write(log, level, format, 2, DEFERRED_LOG_ARG(a), \
+                                                                           DEFERRED_LOG_ARG(b), 0, 0)
+#define DEFERRED_LOG_3(log, level, format, a, b, c)     deferred_log_write(log, level, format, 3, DEFERRED_LOG_ARG(a), \
+                                                                           DEFERRED_LOG_ARG(b), DEFERRED_LOG_ARG(c), 0)
+#define DEFERRED_LOG_4(log, level, format, a, b, c, d)  deferred_log_write(log, level, format, 4, DEFERRED_LOG_ARG(a), \
+                                                                           DEFERRED_LOG_ARG(b), DEFERRED_LOG_ARG(c), \
+                                                                           DEFERRED_LOG_ARG(d))
+#define DEFERRED_LOG_SELECT(_0, _1, _2, _3, _4, name, ...)  name
+
+/*DEFERRED_LOG_LEVEL(&log, ESP_LOG_WARN, "Sending: %lu", value), from 0 to 4 arguments and no newline, as
+  ESP_LOG_LEVEL*/
+#define DEFERRED_LOG_LEVEL(log, level, format, ...) \
+    DEFERRED_LOG_SELECT(_0, ##__VA_ARGS__, DEFERRED_LOG_4, DEFERRED_LOG_3, DEFERRED_LOG_2, DEFERRED_LOG_1, \
+                        DEFERRED_LOG_0)(log, level, format, ##__VA_ARGS__)
+
+/*DEFERRED_LOG(&log, "Sending: %lu", value) is an ESP_LOG_INFO line*/
+#define DEFERRED_LOG(log, format, ...)  DEFERRED_LOG_LEVEL(log, ESP_LOG_INFO, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,116 @@
+/***************************************************************************
+*@brief Event Dispatch: handlers woken by combinations of event bits
+***************************************************************************/
+#include "esp_check.h"
+#include "event_dispatch.h"
+
+static const char *TAG = "event_dispatch";
+
+static bool condition_met(const event_dispatch_entry_t *entry, EventBits_t bits)
+{
+    if (entry->cond == EVENT_DISPATCH_ALL)
+    {
+        return (bits & entry->mask) == entry->mask;
+    }
+    return (bits & entry->mask) != 0;
+}
+
+static void event_dispatch_task(void *pvParameters)
+{
+    event_dispatch_t *dispatcher = (event_dispatch_t *)pvParameters;
+    uint32_t pending = 0;
+
+    while (1)
+    {
+        /*Sleeps until bits are set or cleared, whatever the time it takes*/
+        xTaskNotifyWait(0, UINT32_MAX, &pending, portMAX_DELAY);
+        dispatcher->wakeups++;
+
+        EventBits_t bits = pending ? xEventGroupSetBits(dispatcher->group, pending)
+                                   : xEventGroupGetBits(dispatcher->group);
+        bits |= pending;    /*SetBits returns them already cleared if a task waiting on the group consumed them*/
+
+        for (uint8_t i = 0; i < dispatcher->count; i++)
+        {
+            event_dispatch_entry_t *entry = &dispatcher->entries[i];
+            bool met = condition_met(entry, bits);
+
+            if (met && !entry->active)
+            {
+                entry->handler(bits & entry->mask, entry->arg);
+                dispatcher->dispatched++;
+                if (entry->consume)
+                {
+                    bits = xEventGroupClearBits(dispatcher->group, entry->mask) & ~entry->mask;
+                    met = false;
+                }
+            }
+            entry->active = met;
+        }
+    }
+}
+
+esp_err_t event_dispatch_init(event_dispatch_t *dispatcher, event_dispatch_entry_t *storage, uint8_t capacity)
+{
+    ESP_RETURN_ON_FALSE(dispatcher && storage && capacity > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    dispatcher->group = xEventGroupCreateStatic(&dispatcher->groupStorage);
+    dispatcher->entries = storage;
+    dispatcher->count = 0;
+    dispatcher->capacity = capacity;
+    dispatcher->task = NULL;
+    dispatcher->wakeups = 0;
+    dispatcher->dispatched = 0;
+    ESP_RETURN_ON_FALSE(dispatcher->group, ESP_ERR_INVALID_STATE, TAG, "event group was not created");
+    return ESP_OK;
+}
+
+esp_err_t event_dispatch_register(event_dispatch_t *dispatcher, EventBits_t mask, event_dispatch_cond_t cond,
+                                  bool consume, event_dispatch_handler_t handler, void *arg)
+{
+    ESP_RETURN_ON_FALSE(dispatcher && handler && mask && !(mask & ~EVENT_DISPATCH_BITS), ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+    ESP_RETURN_ON_FALSE(dispatcher->task == NULL, ESP_ERR_INVALID_STATE, TAG, "dispatcher already started");
+    ESP_RETURN_ON_FALSE(dispatcher->count < dispatcher->capacity, ESP_ERR_NO_MEM, TAG, "no room for more handlers");
+
+    dispatcher->entries[dispatcher->count++] = (event_dispatch_entry_t) {
+        .mask = mask,
+        .cond = cond,
+        .consume = consume,
+        .active = false,
+        .handler = handler,
+        .arg = arg,
+    };
+    return ESP_OK;
+}
+
+esp_err_t event_dispatch_start(event_dispatch_t *dispatcher, const char *name, uint32_t stack,
+                               UBaseType_t priority, BaseType_t core)
+{
+    ESP_RETURN_ON_FALSE(dispatcher && dispatcher->count > 0, ESP_ERR_INVALID_ARG, TAG, "no handlers to dispatch");
+    ESP_RETURN_ON_FALSE(dispatcher->task == NULL, ESP_ERR_INVALID_STATE, TAG, "dispatcher already started");
+
+    TaskHandle_t task = NULL;
+    ESP_RETURN_ON_FALSE(xTaskCreatePinnedToCore(event_dispatch_task, name, stack, dispatcher, priority,
+                                                &task, core) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG, "dispatcher task was not created");
+    dispatcher->task = task;
+    return ESP_OK;
+}
+
+esp_err_t event_dispatch_stop(event_dispatch_t *dispatcher)
+{
+    ESP_RETURN_ON_FALSE(dispatcher && dispatcher->task, ESP_ERR_INVALID_STATE, TAG, "dispatcher not started");
+
+    /*Setters see the dispatcher stopped before its task is gone*/
+    TaskHandle_t task = dispatcher->task;
+    dispatcher->task = NULL;
+    vTaskDelete(task);
+    return ESP_OK;
+}
+
+esp_err_t event_dispatch_clear(event_dispatch_t *dispatcher, EventBits_t bits)
+{
+    xEventGroupClearBits(dispatcher->group, bits);
+    return event_dispatch_set(dispatcher, 0);       /*Wakes the dispatcher without setting anything*/
+}
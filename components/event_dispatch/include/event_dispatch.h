@@ -0,0 +1,104 @@
+/***************************************************************************
+*@brief Event Dispatch: handlers woken by combinations of event bits
+Every handler registers a mask and a condition: ALL of its bits or ANY of
+them. A single dispatcher task sleeps until some bits are set and then runs
+every handler whose condition has just become true, so nothing polls with
+timeouts. With 'consume' the bits of the handler are cleared when it runs,
+otherwise it runs again only after its condition was false once.
+Bits are set through the dispatcher (from tasks or ISRs) and kept in an
+event group, which other tasks may also wait on with xEventGroupWaitBits().
+The engine does not allocate memory: the caller provides the handlers table.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_DISPATCH_BITS     0x00FFFFFF  /*Bits usable in an event group*/
+
+typedef enum {
+    EVENT_DISPATCH_ALL,         /*Every bit of the mask is set*/
+    EVENT_DISPATCH_ANY,         /*At least one bit of the mask is set*/
+} event_dispatch_cond_t;
+
+/*Executed by the dispatcher task, 'bits' are the event bits that fired it*/
+typedef void (*event_dispatch_handler_t)(EventBits_t bits, void *arg);
+
+typedef struct {
+    EventBits_t mask;
+    event_dispatch_cond_t cond;
+    bool consume;               /*Clear the bits of the mask after running*/
+    bool active;                /*Condition true in the last evaluation*/
+    event_dispatch_handler_t handler;
+    void *arg;
+} event_dispatch_entry_t;
+
+typedef struct {
+    EventGroupHandle_t group;
+    StaticEventGroup_t groupStorage;
+    event_dispatch_entry_t *entries;
+    uint8_t count;
+    uint8_t capacity;
+    TaskHandle_t task;
+    uint32_t wakeups;           /*Times the dispatcher task woke up*/
+    uint32_t dispatched;        /*Handlers executed*/
+} event_dispatch_t;
+
+esp_err_t event_dispatch_init(event_dispatch_t *dispatcher, event_dispatch_entry_t *storage, uint8_t capacity);
+
+/*Handlers must be registered before starting the dispatcher*/
+esp_err_t event_dispatch_register(event_dispatch_t *dispatcher, EventBits_t mask, event_dispatch_cond_t cond,
+                                  bool consume, event_dispatch_handler_t handler, void *arg);
+
+esp_err_t event_dispatch_start(event_dispatch_t *dispatcher, const char *name, uint32_t stack,
+                               UBaseType_t priority, BaseType_t core);
+
+/*Deletes the dispatcher task, the event group keeps its bits*/
+esp_err_t event_dispatch_stop(event_dispatch_t *dispatcher);
+
+/*The bits reach the event group through the dispatcher task, in order.
+  Nothing is set (ESP_ERR_INVALID_STATE) while the dispatcher is not running*/
+static inline esp_err_t event_dispatch_set(event_dispatch_t *dispatcher, EventBits_t bits)
+{
+    TaskHandle_t task = dispatcher->task;
+
+    if (task == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotify(task, bits & EVENT_DISPATCH_BITS, eSetBits);
+    return ESP_OK;
+}
+
+static inline esp_err_t event_dispatch_set_from_isr(event_dispatch_t *dispatcher, EventBits_t bits,
+                                                    BaseType_t *xHigherPriorityTaskWoken)
+{
+    TaskHandle_t task = dispatcher->task;
+
+    if (task == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotifyFromISR(task, bits & EVENT_DISPATCH_BITS, eSetBits, xHigherPriorityTaskWoken);
+    return ESP_OK;
+}
+
+/*Clears the bits and lets the dispatcher see the conditions turning false*/
+esp_err_t event_dispatch_clear(event_dispatch_t *dispatcher, EventBits_t bits);
+
+static inline EventBits_t event_dispatch_get(const event_dispatch_t *dispatcher)
+{
+    return xEventGroupGetBits(dispatcher->group);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+/***************************************************************************
+*@brief Fair Lock: FIFO handoff mutex built on task notifications
+***************************************************************************/
+#include <string.h>
+#include "esp_check.h"
+#include "fair_lock.h"
+
+static const char *TAG = "fair_lock";
+
+/*Called inside the critical section*/
+static bool leave_queue(fair_lock_t *lock, TaskHandle_t task)
+{
+    for (uint8_t i = 0; i < lock->count; i++)
+    {
+        if (lock->waiters[i] == task)
+        {
+            memmove(&lock->waiters[i], &lock->waiters[i + 1], (lock->count - i - 1) * sizeof(TaskHandle_t));
+            lock->count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t fair_lock_init(fair_lock_t *lock)
+{
+    ESP_RETURN_ON_FALSE(lock, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    memset(lock, 0, sizeof(*lock));
+    portMUX_INITIALIZE(&lock->mux);
+    return ESP_OK;
+}
+
+/*Called inside the critical section*/
+static bool take_if_free(fair_lock_t *lock, TaskHandle_t self)
+{
+    if (lock->owner == NULL)
+    {
+        lock->owner = self;
+        return true;
+    }
+    return false;
+}
+
+BaseType_t fair_lock_take(fair_lock_t *lock, TickType_t timeout)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    TimeOut_t start;
+
+    /*Free and nobody queued: taken without blocking*/
+    portENTER_CRITICAL(&lock->mux);
+    bool owned = take_if_free(lock, self);
+    portEXIT_CRITICAL(&lock->mux);
+    if (owned || timeout == 0)
+    {
+        return owned ? pdTRUE : pdFALSE;
+    }
+
+    /*A handoff received right after an earlier timeout leaves its notification
+      behind, it is cleared before this task can be handed the lock again*/
+    ulTaskNotifyTakeIndexed(FAIR_LOCK_NOTIFY_INDEX, pdTRUE, 0);
+
+    portENTER_CRITICAL(&lock->mux);
+    owned = take_if_free(lock, self);
+    bool queued = !owned && lock->count < FAIR_LOCK_MAX_WAITERS;
+    if (queued)
+    {
+        lock->waiters[lock->count++] = self;
+    }
+    portEXIT_CRITICAL(&lock->mux);
+    if (!queued)
+    {
+        return owned ? pdTRUE : pdFALSE;
+    }
+
+    /*The giver makes this task the owner before notifying it, so a wake up only
+      means "check again": the task keeps waiting for the time left until it is
+      the owner*/
+    vTaskSetTimeOutState(&start);
+    while (1)
+    {
+        ulTaskNotifyTakeIndexed(FAIR_LOCK_NOTIFY_INDEX, pdTRUE, timeout);
+        bool expired = (xTaskCheckForTimeOut(&start, &timeout) == pdTRUE);
+
+        portENTER_CRITICAL(&lock->mux);
+        owned = (lock->owner == self);
+        if (!owned && expired)
+        {
+            leave_queue(lock, self);
+        }
+        portEXIT_CRITICAL(&lock->mux);
+
+        if (owned || expired)
+        {
+            return owned ? pdTRUE : pdFALSE;
+        }
+    }
+}
+
+BaseType_t fair_lock_give(fair_lock_t *lock)
+{
+    TaskHandle_t next = NULL;
+
+    portENTER_CRITICAL(&lock->mux);
+    if (lock->owner != xTaskGetCurrentTaskHandle())
+    {
+        portEXIT_CRITICAL(&lock->mux);
+        return pdFALSE;
+    }
+    if (lock->count > 0)
+    {
+        next = lock->waiters[0];
+        leave_queue(lock, next);
+        lock->handoffs++;
+    }
+    lock->owner = next;
+    portEXIT_CRITICAL(&lock->mux);
+
+    if (next)
+    {
+        xTaskNotifyGiveIndexed(next, FAIR_LOCK_NOTIFY_INDEX);
+    }
+    return pdTRUE;
+}
@@ -0,0 +1,51 @@
+/***************************************************************************
+*@brief Fair Lock: FIFO handoff mutex built on task notifications
+The tasks that find the lock held wait in a FIFO and, on every give, the
+lock is handed straight to the oldest waiter: the task that gives cannot
+take it back before them. So a task waits at most for the holds of the
+tasks queued ahead of it, whatever the periods and priorities of
+the others, while a plain mutex gives it to whoever asks first once free.
+There is no priority inheritance: a lower priority holder keeps its own
+priority. While waiting, the task must not expect other notifications on
+FAIR_LOCK_NOTIFY_INDEX (CONFIG_FAIR_LOCK_NOTIFY_INDEX): a notification only
+makes the waiter check whether it was made the owner.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FAIR_LOCK_NOTIFY_INDEX  CONFIG_FAIR_LOCK_NOTIFY_INDEX
+#define FAIR_LOCK_MAX_WAITERS   CONFIG_FAIR_LOCK_MAX_WAITERS    /*Tasks that can wait at the same time*/
+
+#if FAIR_LOCK_NOTIFY_INDEX >= configTASK_NOTIFICATION_ARRAY_ENTRIES
+#error "CONFIG_FAIR_LOCK_NOTIFY_INDEX must be lower than CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES"
+#endif
+
+typedef struct {
+    portMUX_TYPE mux;
+    TaskHandle_t owner;
+    TaskHandle_t waiters[FAIR_LOCK_MAX_WAITERS];    /*Oldest first*/
+    uint8_t count;
+    uint32_t handoffs;      /*Gives that passed the lock to a waiter*/
+} fair_lock_t;
+
+esp_err_t fair_lock_init(fair_lock_t *lock);
+
+/*pdTRUE once the lock is owned, pdFALSE after 'timeout' or with FAIR_LOCK_MAX_WAITERS already waiting*/
+BaseType_t fair_lock_take(fair_lock_t *lock, TickType_t timeout);
+
+/*Only the owner gives, the lock goes to the oldest waiter if any*/
+BaseType_t fair_lock_give(fair_lock_t *lock);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,45 @@
+/***************************************************************************
+*@brief GPIO Bank: batched output of a group of pins
+***************************************************************************/
+#include "esp_check.h"
+#include "gpio_bank.h"
+
+static const char *TAG = "gpio_bank";
+
+esp_err_t gpio_bank_init(gpio_bank_t *bank, const gpio_num_t *pins, uint8_t count)
+{
+    ESP_RETURN_ON_FALSE(bank && pins && count <= GPIO_BANK_MAX_PINS, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        ESP_RETURN_ON_FALSE(pins[i] >= 0 && ((1ULL << pins[i]) & SOC_GPIO_VALID_OUTPUT_GPIO_MASK),
+                            ESP_ERR_INVALID_ARG, TAG, "GPIO %d can not be an output", pins[i]);
+        bank->pins[i] = pins[i];
+    }
+    bank->count = count;
+    return ESP_OK;
+}
+
+void gpio_bank_prepare(const gpio_bank_t *bank, uint32_t levels, gpio_bank_state_t *state)
+{
+    for (uint8_t w = 0; w < GPIO_BANK_WORDS; w++)
+    {
+        state->set[w] = 0;
+        state->clear[w] = 0;
+    }
+
+    for (uint8_t i = 0; i < bank->count; i++)
+    {
+        uint8_t word = bank->pins[i] / 32;
+        uint32_t bit = 1UL << (bank->pins[i] % 32);
+
+        if (levels & (1UL << i))
+        {
+            state->set[word] |= bit;
+        }
+        else
+        {
+            state->clear[word] |= bit;
+        }
+    }
+}
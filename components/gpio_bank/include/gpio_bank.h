@@ -0,0 +1,70 @@
+/***************************************************************************
+*@brief GPIO Bank: batched output of a group of pins
+A bank is a group of output pins. Every combination of levels that will be
+used is prepared once into set/clear masks of the GPIO output registers, so
+updating all the pins of the bank is one write to OUT_W1TS and one write to
+OUT_W1TC (plus OUT1_W1TS/W1TC for pins 32 and above) with no read-modify-
+write and no argument checks.
+The pins must already be configured as outputs.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "hal/gpio_types.h"
+#include "soc/soc_caps.h"
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GPIO_BANK_MAX_PINS  32      /*Pins of a bank, one bit per pin in 'levels'*/
+
+/*The output registers are split in 32 pins words: OUT (0-31) and OUT1 (32-)*/
+#if SOC_GPIO_PIN_COUNT > 32
+#define GPIO_BANK_WORDS     2
+#else
+#define GPIO_BANK_WORDS     1
+#endif
+
+typedef struct {
+    gpio_num_t pins[GPIO_BANK_MAX_PINS];
+    uint8_t count;
+} gpio_bank_t;
+
+/*Masks ready to be written to the output registers*/
+typedef struct {
+    uint32_t set[GPIO_BANK_WORDS];
+    uint32_t clear[GPIO_BANK_WORDS];
+} gpio_bank_state_t;
+
+esp_err_t gpio_bank_init(gpio_bank_t *bank, const gpio_num_t *pins, uint8_t count);
+
+/*Bit i of 'levels' is the level of the pin i of the bank*/
+void gpio_bank_prepare(const gpio_bank_t *bank, uint32_t levels, gpio_bank_state_t *state);
+
+/*Updates every pin of the bank, set and clear happen in consecutive writes*/
+static inline void gpio_bank_apply(const gpio_bank_state_t *state)
+{
+    REG_WRITE(GPIO_OUT_W1TS_REG, state->set[0]);
+    REG_WRITE(GPIO_OUT_W1TC_REG, state->clear[0]);
+#if GPIO_BANK_WORDS > 1
+    REG_WRITE(GPIO_OUT1_W1TS_REG, state->set[1]);
+    REG_WRITE(GPIO_OUT1_W1TC_REG, state->clear[1]);
+#endif
+}
+
+/*Prepare and apply in one call, for levels that were not prepared before*/
+static inline void gpio_bank_write(const gpio_bank_t *bank, uint32_t levels)
+{
+    gpio_bank_state_t state;
+
+    gpio_bank_prepare(bank, levels, &state);
+    gpio_bank_apply(&state);
+}
+
+#ifdef __cplusplus
+}
+#endif
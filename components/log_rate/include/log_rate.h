@@ -0,0 +1,92 @@
+/***************************************************************************
+*@brief Log Rate: rate limited and sampled logs for periodic code
+Every macro keeps its own static state, one per call site, and wraps any
+log macro called as log(tag, format, ...): ESP_LOGI, ESP_LOGW, the
+DEFERRED_LOG of deferred_log... When a line is emitted after some were
+suppressed, " (+N suppressed)" is appended to it.
+  LOG_EVERY_N(n, log, tag, format, ...)       the 1st call and then 1 of every n
+                                              (every call for n below 1)
+  LOG_EVERY_MS(ms, log, tag, format, ...)     at most one line every ms
+  LOG_ON_CHANGE(value, log, tag, format, ...) only when 'value' differs from
+                                              the previous call
+A suppressed call costs a compare and a counter increment (plus reading the
+clock for LOG_EVERY_MS). The state is not shared between call sites, but one
+call site used from several tasks can miscount the suppressed lines.
+The clock is LOG_RATE_NOW_MS(), define it before including this header to
+use another one (a fake clock in tests, xTaskGetTickCount()...).
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef LOG_RATE_NOW_MS
+#include "esp_timer.h"
+#define LOG_RATE_NOW_MS()   ((uint32_t)(esp_timer_get_time() / 1000))
+#endif
+
+/*Emits the line with the count of the suppressed ones, if any, and restarts the count*/
+#define LOG_RATE_EMIT(suppressed, log, tag, format, ...)                                     \
+    do {                                                                                     \
+        if (suppressed)                                                                      \
+        {                                                                                    \
+            log(tag, format " (+%lu suppressed)", ##__VA_ARGS__, (unsigned long)(suppressed)); \
+        }                                                                                    \
+        else                                                                                 \
+        {                                                                                    \
+            log(tag, format, ##__VA_ARGS__);                                                 \
+        }                                                                                    \
+        (suppressed) = 0;                                                                    \
+    } while (0)
+
+#define LOG_EVERY_N(n, log, tag, format, ...)                                                \
+    do {                                                                                     \
+        static uint32_t logRateLeft = 0;        /*Calls to suppress before the next line*/   \
+        static uint32_t logRateSuppressed = 0;                                               \
+        if (logRateLeft == 0)                                                                \
+        {                                                                                    \
+            LOG_RATE_EMIT(logRateSuppressed, log, tag, format, ##__VA_ARGS__);               \
+            logRateLeft = ((n) > 1) ? (uint32_t)(n) - 1 : 0;  /*n below 1 logs every call*/  \
+        }                                                                                    \
+        else                                                                                 \
+        {                                                                                    \
+            logRateLeft--;                                                                   \
+            logRateSuppressed++;                                                             \
+        }                                                                                    \
+    } while (0)
+
+#define LOG_EVERY_MS(ms, log, tag, format, ...)                                              \
+    do {                                                                                     \
+        static bool logRateStarted = false;                                                  \
+        static uint32_t logRateLast = 0;        /*Time of the last line*/                    \
+        static uint32_t logRateSuppressed = 0;                                               \
+        uint32_t logRateNow = LOG_RATE_NOW_MS();                                             \
+        if (!logRateStarted || logRateNow - logRateLast >= (uint32_t)(ms))                   \
+        {                                                                                    \
+            LOG_RATE_EMIT(logRateSuppressed, log, tag, format, ##__VA_ARGS__);               \
+            logRateStarted = true;                                                           \
+            logRateLast = logRateNow;                                                        \
+        }                                                                                    \
+        else                                                                                 \
+        {                                                                                    \
+            logRateSuppressed++;                                                             \
+        }                                                                                    \
+    } while (0)
+
+#define LOG_ON_CHANGE(value, log, tag, format, ...)                                          \
+    do {                                                                                     \
+        static bool logRateStarted = false;                                                  \
+        static __typeof__(value) logRateLast;   /*Value of the previous call*/               \
+        static uint32_t logRateSuppressed = 0;                                               \
+        __typeof__(value) logRateValue = (value);                                            \
+        if (!logRateStarted || logRateValue != logRateLast)                                  \
+        {                                                                                    \
+            LOG_RATE_EMIT(logRateSuppressed, log, tag, format, ##__VA_ARGS__);               \
+            logRateStarted = true;                                                           \
+            logRateLast = logRateValue;                                                      \
+        }                                                                                    \
+        else                                                                                 \
+        {                                                                                    \
+            logRateSuppressed++;                                                             \
+        }                                                                                    \
+    } while (0)
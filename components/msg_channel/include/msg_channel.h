@@ -0,0 +1,66 @@
+/***************************************************************************
+*@brief Message Channel: typed queues and variable length messages
+MSG_CHANNEL_DEFINE(name, type, size) generates a channel that only accepts
+'type': name_channel_t, name_channel_create(), name_send() and
+name_receive(). 'size' is the size both sides agreed on, a _Static_assert
+stops the build if 'type' ever changes it, so an item can not be silently
+truncated or overrun.
+msg_channel_var_t carries variable length messages on a MessageBuffer,
+every message takes only its bytes plus a length word (sizeof(size_t)),
+instead of a slot sized for the largest message.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/message_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*Fixed size messages of 'type', copied into and out of a Queue*/
+#define MSG_CHANNEL_DEFINE(name, type, size)                                                    \
+    _Static_assert(sizeof(type) == (size), "size of " #type " changed for channel " #name);     \
+    typedef struct {                                                                            \
+        QueueHandle_t queue;                                                                    \
+    } name##_channel_t;                                                                         \
+    static inline esp_err_t name##_channel_create(name##_channel_t *channel, UBaseType_t length) \
+    {                                                                                           \
+        channel->queue = xQueueCreate(length, sizeof(type));                                    \
+        return channel->queue ? ESP_OK : ESP_ERR_NO_MEM;                                        \
+    }                                                                                           \
+    static inline esp_err_t name##_send(name##_channel_t *channel, const type *msg, TickType_t timeout) \
+    {                                                                                           \
+        return (xQueueSend(channel->queue, msg, timeout) == pdPASS) ? ESP_OK : ESP_ERR_TIMEOUT; \
+    }                                                                                           \
+    static inline esp_err_t name##_receive(name##_channel_t *channel, type *msg, TickType_t timeout) \
+    {                                                                                           \
+        return (xQueueReceive(channel->queue, msg, timeout) == pdPASS) ? ESP_OK : ESP_ERR_TIMEOUT; \
+    }
+
+/*Bytes a MessageBuffer takes to store a message of 'len' bytes*/
+#define MSG_CHANNEL_VAR_COST(len)   ((len) + sizeof(size_t))
+
+typedef struct {
+    MessageBufferHandle_t buffer;
+    size_t max_len;             /*Largest message accepted*/
+} msg_channel_var_t;
+
+/*'bytes' is the whole buffer, shared by all the messages waiting in it*/
+esp_err_t msg_channel_var_create(msg_channel_var_t *channel, size_t bytes, size_t max_len);
+
+/*ESP_ERR_INVALID_SIZE when 'len' is above max_len, ESP_ERR_TIMEOUT when there
+  was no room for the message during 'timeout'*/
+esp_err_t msg_channel_var_send(msg_channel_var_t *channel, const void *msg, size_t len, TickType_t timeout);
+
+/*'size' must hold max_len bytes, 'len' receives the length of the message*/
+esp_err_t msg_channel_var_receive(msg_channel_var_t *channel, void *msg, size_t size, size_t *len,
+                                  TickType_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,39 @@
+/***************************************************************************
+*@brief Message Channel: typed queues and variable length messages
+***************************************************************************/
+#include "esp_check.h"
+#include "esp_log.h"
+#include "msg_channel.h"
+
+static const char *TAG = "msg_channel";
+
+esp_err_t msg_channel_var_create(msg_channel_var_t *channel, size_t bytes, size_t max_len)
+{
+    ESP_RETURN_ON_FALSE(channel && max_len > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(bytes >= MSG_CHANNEL_VAR_COST(max_len), ESP_ERR_INVALID_SIZE, TAG,
+                        "%u bytes can not hold a message of %u bytes", (unsigned)bytes, (unsigned)max_len);
+
+    channel->buffer = xMessageBufferCreate(bytes);
+    channel->max_len = max_len;
+    ESP_RETURN_ON_FALSE(channel->buffer, ESP_ERR_NO_MEM, TAG, "message buffer was not created");
+    return ESP_OK;
+}
+
+esp_err_t msg_channel_var_send(msg_channel_var_t *channel, const void *msg, size_t len, TickType_t timeout)
+{
+    if (len == 0 || len > channel->max_len)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    /*A message is written whole or not at all*/
+    return (xMessageBufferSend(channel->buffer, msg, len, timeout) == len) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t msg_channel_var_receive(msg_channel_var_t *channel, void *msg, size_t size, size_t *len,
+                                  TickType_t timeout)
+{
+    ESP_RETURN_ON_FALSE(size >= channel->max_len, ESP_ERR_INVALID_SIZE, TAG, "buffer smaller than max_len");
+
+    *len = xMessageBufferReceive(channel->buffer, msg, size, timeout);
+    return (*len > 0) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
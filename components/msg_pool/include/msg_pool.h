@@ -0,0 +1,82 @@
+/***************************************************************************
+*@brief Message Pool: zero-copy messages between tasks
+A pool of fixed size blocks and queues that carry only pointers to them.
+The owner of a block is whoever holds the pointer:
+  producer: msg_pool_alloc() -> fill -> msg_pool_send()
+  consumer: msg_pool_receive() -> use -> msg_pool_free()
+Handing a message over costs the same for 4 bytes or 2 KB, since the payload
+is never copied. When the pool is empty msg_pool_alloc() blocks, which is the
+backpressure of the producer.
+The blocks live in storage given by the caller (usually a static array).
+A bitmap marks the blocks that are allocated, so freeing a block twice (or
+one that was never allocated) is rejected whatever the state of the pool.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MSG_POOL_ALIGN      _Alignof(max_align_t)   /*Blocks hold any type, as malloc() ones*/
+#define MSG_POOL_BLOCK_SIZE(size)           (((size) + MSG_POOL_ALIGN - 1) & ~(MSG_POOL_ALIGN - 1))
+#define MSG_POOL_STORAGE_SIZE(size, count)  (MSG_POOL_BLOCK_SIZE(size) * (count))
+
+#ifndef MSG_POOL_MAX_BLOCKS
+#define MSG_POOL_MAX_BLOCKS 64      /*Blocks followed by the ownership bitmap*/
+#endif
+#define MSG_POOL_MAP_WORDS  ((MSG_POOL_MAX_BLOCKS + 31) / 32)
+
+typedef struct {
+    uint8_t *blocks;
+    size_t block_size;          /*Rounded up to MSG_POOL_ALIGN*/
+    uint16_t block_count;
+    QueueHandle_t free;         /*Pointers of the free blocks*/
+    atomic_uint allocated[MSG_POOL_MAP_WORDS];  /*Bit set while the block is owned by a task*/
+} msg_pool_t;
+
+/*'storage' holds MSG_POOL_STORAGE_SIZE(block_size, block_count) bytes aligned to
+  MSG_POOL_ALIGN, 'block_count' is at most MSG_POOL_MAX_BLOCKS*/
+esp_err_t msg_pool_init(msg_pool_t *pool, void *storage, size_t block_size, uint16_t block_count);
+
+/*Queue of block pointers, a message can wait in it for every block of the pool*/
+QueueHandle_t msg_pool_queue_create(const msg_pool_t *pool);
+
+/*Takes a free block, NULL if none was freed before 'timeout'*/
+void *msg_pool_alloc(msg_pool_t *pool, TickType_t timeout);
+
+/*Returns a block to the pool, only the owner of the block may free it.
+  ESP_ERR_INVALID_STATE if the block is not allocated (freed twice)*/
+esp_err_t msg_pool_free(msg_pool_t *pool, void *block);
+
+esp_err_t msg_pool_free_from_isr(msg_pool_t *pool, void *block, BaseType_t *xHigherPriorityTaskWoken);
+
+/*Blocks available right now*/
+static inline UBaseType_t msg_pool_available(const msg_pool_t *pool)
+{
+    return uxQueueMessagesWaiting(pool->free);
+}
+
+/*Hands the block over to the receiver, the sender keeps it if this fails*/
+static inline esp_err_t msg_pool_send(QueueHandle_t queue, void *block, TickType_t timeout)
+{
+    return (xQueueSend(queue, &block, timeout) == pdPASS) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+/*Takes the ownership of the next block, NULL if none arrived before 'timeout'*/
+static inline void *msg_pool_receive(QueueHandle_t queue, TickType_t timeout)
+{
+    void *block = NULL;
+
+    return (xQueueReceive(queue, &block, timeout) == pdPASS) ? block : NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,105 @@
+/***************************************************************************
+*@brief Message Pool: zero-copy messages between tasks
+***************************************************************************/
+#include <stdbool.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "msg_pool.h"
+
+static const char *TAG = "msg_pool";
+
+/*A block of this pool, not just any pointer*/
+static bool is_block(const msg_pool_t *pool, const void *block)
+{
+    const uint8_t *p = (const uint8_t *)block;
+
+    return p >= pool->blocks && p < pool->blocks + pool->block_size * pool->block_count &&
+           (size_t)(p - pool->blocks) % pool->block_size == 0;
+}
+
+/*Marks a block as allocated (true) or free, returns the previous state*/
+static bool mark_block(msg_pool_t *pool, const void *block, bool allocated)
+{
+    size_t index = (size_t)((const uint8_t *)block - pool->blocks) / pool->block_size;
+    unsigned bit = 1u << (index % 32);
+    unsigned previous;
+
+    if (allocated)
+    {
+        previous = atomic_fetch_or_explicit(&pool->allocated[index / 32], bit, memory_order_relaxed);
+    }
+    else
+    {
+        previous = atomic_fetch_and_explicit(&pool->allocated[index / 32], ~bit, memory_order_relaxed);
+    }
+    return (previous & bit) != 0;
+}
+
+esp_err_t msg_pool_init(msg_pool_t *pool, void *storage, size_t block_size, uint16_t block_count)
+{
+    ESP_RETURN_ON_FALSE(pool && storage && block_size > 0 && block_count > 0, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+    ESP_RETURN_ON_FALSE(block_count <= MSG_POOL_MAX_BLOCKS, ESP_ERR_INVALID_SIZE, TAG,
+                        "more than %d blocks", MSG_POOL_MAX_BLOCKS);
+    ESP_RETURN_ON_FALSE(((uintptr_t)storage % MSG_POOL_ALIGN) == 0, ESP_ERR_INVALID_ARG, TAG,
+                        "storage must be aligned to %d", (int)MSG_POOL_ALIGN);
+
+    pool->blocks = (uint8_t *)storage;
+    pool->block_size = MSG_POOL_BLOCK_SIZE(block_size);
+    pool->block_count = block_count;
+    for (size_t i = 0; i < MSG_POOL_MAP_WORDS; i++)
+    {
+        atomic_init(&pool->allocated[i], 0);
+    }
+    pool->free = xQueueCreate(block_count, sizeof(void *));
+    ESP_RETURN_ON_FALSE(pool->free, ESP_ERR_NO_MEM, TAG, "free list was not created");
+
+    for (uint16_t i = 0; i < block_count; i++)
+    {
+        void *block = pool->blocks + (size_t)i * pool->block_size;
+        xQueueSend(pool->free, &block, 0);
+    }
+    return ESP_OK;
+}
+
+QueueHandle_t msg_pool_queue_create(const msg_pool_t *pool)
+{
+    return xQueueCreate(pool->block_count, sizeof(void *));
+}
+
+void *msg_pool_alloc(msg_pool_t *pool, TickType_t timeout)
+{
+    void *block = NULL;
+
+    if (xQueueReceive(pool->free, &block, timeout) != pdPASS)
+    {
+        return NULL;
+    }
+    mark_block(pool, block, true);
+    return block;
+}
+
+esp_err_t msg_pool_free(msg_pool_t *pool, void *block)
+{
+    ESP_RETURN_ON_FALSE(is_block(pool, block), ESP_ERR_INVALID_ARG, TAG, "%p is not a block of the pool", block);
+    ESP_RETURN_ON_FALSE(mark_block(pool, block, false), ESP_ERR_INVALID_STATE, TAG,
+                        "block %p is not allocated (freed twice?)", block);
+
+    /*Never blocks: the free list has room for every block*/
+    xQueueSend(pool->free, &block, 0);
+    return ESP_OK;
+}
+
+esp_err_t msg_pool_free_from_isr(msg_pool_t *pool, void *block, BaseType_t *xHigherPriorityTaskWoken)
+{
+    if (!is_block(pool, block))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!mark_block(pool, block, false))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xQueueSendFromISR(pool->free, &block, xHigherPriorityTaskWoken);
+    return ESP_OK;
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+*@brief Mutex Prof: drop-in mutex wrapper with contention statistics
+Every profiled mutex records how long the tasks waited to take it and how
+long they held it (log2 histograms in microseconds), the takes that timed
+out, the current holder and the times a waiting task had to lend its
+priority to a lower priority holder. mutex_prof_dump() and
+mutex_prof_dump_all() print them on demand.
+Enabled with CONFIG_MUTEX_PROF_ENABLE, otherwise mutex_prof_take() and
+mutex_prof_give() are plain xSemaphoreTake() and xSemaphoreGive() calls.
+The mutex is created static inside mutex_prof_t, nothing is allocated.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mutex_prof mutex_prof_t;
+
+struct mutex_prof {
+    SemaphoreHandle_t handle;
+    StaticSemaphore_t storage;
+#if CONFIG_MUTEX_PROF_ENABLE
+    const char *name;
+    portMUX_TYPE lock;          /*Guards the statistics of waiters that did not get the mutex*/
+    TaskHandle_t holder;
+    int64_t taken_at;           /*esp_timer time of the last take*/
+    uint32_t takes;
+    uint32_t timeouts;
+    uint32_t contended;         /*Takes that found the mutex held*/
+    uint32_t inheritances;      /*Contended takes from a task above the holder*/
+    uint32_t wait_max;          /*Microseconds*/
+    uint32_t hold_max;
+    uint32_t wait_hist[CONFIG_MUTEX_PROF_BINS];
+    uint32_t hold_hist[CONFIG_MUTEX_PROF_BINS];
+    mutex_prof_t *next;         /*Every profiled mutex, for mutex_prof_dump_all()*/
+#endif
+};
+
+/*'name' must outlive the mutex, it is only kept as a pointer*/
+esp_err_t mutex_prof_init(mutex_prof_t *mutex, const char *name);
+
+#if CONFIG_MUTEX_PROF_ENABLE
+
+BaseType_t mutex_prof_take(mutex_prof_t *mutex, TickType_t timeout);
+BaseType_t mutex_prof_give(mutex_prof_t *mutex);
+void mutex_prof_reset(mutex_prof_t *mutex);
+void mutex_prof_dump(const mutex_prof_t *mutex);
+void mutex_prof_dump_all(void);
+
+#else
+
+#define mutex_prof_take(mutex, timeout)     xSemaphoreTake((mutex)->handle, (timeout))
+#define mutex_prof_give(mutex)              xSemaphoreGive((mutex)->handle)
+#define mutex_prof_reset(mutex)             ((void)(mutex))
+#define mutex_prof_dump(mutex)              ((void)(mutex))
+#define mutex_prof_dump_all()               ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,157 @@
+/***************************************************************************
+*@brief Mutex Prof: drop-in mutex wrapper with contention statistics
+***************************************************************************/
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mutex_prof.h"
+
+static const char *TAG = "mutex_prof";
+
+#if CONFIG_MUTEX_PROF_ENABLE
+
+static mutex_prof_t *profiled = NULL;     /*Head of the list of profiled mutexes*/
+static portMUX_TYPE profiledLock = portMUX_INITIALIZER_UNLOCKED;
+
+/*Bin 0 below 1 us, bin N from 2^(N-1) to 2^N us, the last one everything above*/
+static uint32_t hist_bin(uint32_t us)
+{
+    uint32_t bin = (us == 0) ? 0 : 32 - __builtin_clz(us);
+
+    return (bin < CONFIG_MUTEX_PROF_BINS) ? bin : CONFIG_MUTEX_PROF_BINS - 1;
+}
+
+static uint32_t elapsed_us(int64_t since)
+{
+    int64_t elapsed = esp_timer_get_time() - since;
+
+    return (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed;
+}
+
+BaseType_t mutex_prof_take(mutex_prof_t *mutex, TickType_t timeout)
+{
+    int64_t started = esp_timer_get_time();
+
+    if (xSemaphoreTake(mutex->handle, 0) != pdTRUE)
+    {
+        /*Held: a holder below this task runs with its priority until it gives*/
+        TaskHandle_t holder = xSemaphoreGetMutexHolder(mutex->handle);
+        bool inherits = holder && uxTaskPriorityGet(holder) < uxTaskPriorityGet(NULL);
+
+        portENTER_CRITICAL(&mutex->lock);
+        mutex->contended++;
+        mutex->inheritances += inherits;
+        portEXIT_CRITICAL(&mutex->lock);
+
+        if (timeout == 0 || xSemaphoreTake(mutex->handle, timeout) != pdTRUE)
+        {
+            portENTER_CRITICAL(&mutex->lock);
+            mutex->timeouts++;
+            portEXIT_CRITICAL(&mutex->lock);
+            return pdFALSE;
+        }
+    }
+
+    /*From here on the statistics of takes and holds are guarded by the mutex itself*/
+    uint32_t wait = elapsed_us(started);
+    mutex->holder = xTaskGetCurrentTaskHandle();
+    mutex->taken_at = esp_timer_get_time();
+    mutex->takes++;
+    mutex->wait_max = (wait > mutex->wait_max) ? wait : mutex->wait_max;
+    mutex->wait_hist[hist_bin(wait)]++;
+    return pdTRUE;
+}
+
+BaseType_t mutex_prof_give(mutex_prof_t *mutex)
+{
+    if (mutex->holder == xTaskGetCurrentTaskHandle())
+    {
+        uint32_t hold = elapsed_us(mutex->taken_at);
+
+        mutex->hold_max = (hold > mutex->hold_max) ? hold : mutex->hold_max;
+        mutex->hold_hist[hist_bin(hold)]++;
+        mutex->holder = NULL;
+    }
+    return xSemaphoreGive(mutex->handle);
+}
+
+void mutex_prof_reset(mutex_prof_t *mutex)
+{
+    portENTER_CRITICAL(&mutex->lock);
+    mutex->takes = 0;
+    mutex->timeouts = 0;
+    mutex->contended = 0;
+    mutex->inheritances = 0;
+    mutex->wait_max = 0;
+    mutex->hold_max = 0;
+    memset(mutex->wait_hist, 0, sizeof(mutex->wait_hist));
+    memset(mutex->hold_hist, 0, sizeof(mutex->hold_hist));
+    portEXIT_CRITICAL(&mutex->lock);
+}
+
+/*Only the bins with counts, as "<upper bound us>:count"*/
+static void log_hist(const char *name, const char *kind, const uint32_t *hist)
+{
+    char line[CONFIG_MUTEX_PROF_BINS * 16];
+    int used = 0;
+
+    for (uint32_t bin = 0; bin < CONFIG_MUTEX_PROF_BINS - 1 && used < (int)sizeof(line); bin++)
+    {
+        if (hist[bin])
+        {
+            used += snprintf(line + used, sizeof(line) - used, " <%lu:%lu", 1UL << bin, (unsigned long)hist[bin]);
+        }
+    }
+    /*The last bin has no upper bound*/
+    if (hist[CONFIG_MUTEX_PROF_BINS - 1] && used < (int)sizeof(line))
+    {
+        used += snprintf(line + used, sizeof(line) - used, " >=%lu:%lu", 1UL << (CONFIG_MUTEX_PROF_BINS - 2),
+                         (unsigned long)hist[CONFIG_MUTEX_PROF_BINS - 1]);
+    }
+    ESP_LOGI(TAG, "%s %s us:%s", name, kind, used ? line : " -");
+}
+
+void mutex_prof_dump(const mutex_prof_t *mutex)
+{
+    TaskHandle_t holder = mutex->holder;
+
+    ESP_LOGI(TAG, "%s: %lu takes, %lu contended, %lu timeouts, %lu inheritances, wait max %lu us, "
+             "hold max %lu us, holder %s", mutex->name, (unsigned long)mutex->takes,
+             (unsigned long)mutex->contended, (unsigned long)mutex->timeouts, (unsigned long)mutex->inheritances,
+             (unsigned long)mutex->wait_max, (unsigned long)mutex->hold_max,
+             holder ? pcTaskGetName(holder) : "-");
+    log_hist(mutex->name, "wait", mutex->wait_hist);
+    log_hist(mutex->name, "hold", mutex->hold_hist);
+}
+
+void mutex_prof_dump_all(void)
+{
+    for (const mutex_prof_t *mutex = profiled; mutex; mutex = mutex->next)
+    {
+        mutex_prof_dump(mutex);
+    }
+}
+
+#endif
+
+esp_err_t mutex_prof_init(mutex_prof_t *mutex, const char *name)
+{
+    ESP_RETURN_ON_FALSE(mutex, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    memset(mutex, 0, sizeof(*mutex));
+    mutex->handle = xSemaphoreCreateMutexStatic(&mutex->storage);
+    ESP_RETURN_ON_FALSE(mutex->handle, ESP_ERR_INVALID_STATE, TAG, "mutex was not created");
+#if CONFIG_MUTEX_PROF_ENABLE
+    mutex->name = name ? name : "mutex";
+    portMUX_INITIALIZE(&mutex->lock);
+
+    portENTER_CRITICAL(&profiledLock);
+    mutex->next = profiled;
+    profiled = mutex;
+    portEXIT_CRITICAL(&profiledLock);
+#endif
+    return ESP_OK;
+}
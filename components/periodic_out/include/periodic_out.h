@@ -0,0 +1,53 @@
+/***************************************************************************
+*@brief Periodic Out: one task driving many periodic outputs
+Every output has a period and an action (toggle a LED, sample a sensor...).
+The next deadline of every output is kept in a min-heap and a single task
+sleeps with xTaskDelayUntil() until the earliest one. Deadlines advance by
+exactly one period from the previous deadline, so the execution time of the
+actions never accumulates as drift.
+The engine does not allocate memory: the caller provides the heap storage.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*Action executed by the engine task every period of an output*/
+typedef void (*periodic_out_action_t)(void *arg);
+
+typedef struct {
+    TickType_t deadline;            /*Tick of the next execution*/
+    TickType_t period;
+    periodic_out_action_t action;
+    void *arg;
+} periodic_out_entry_t;
+
+typedef struct {
+    periodic_out_entry_t *heap;     /*Outputs ordered as a min-heap of deadlines*/
+    uint16_t count;
+    uint16_t capacity;
+    TickType_t start;               /*Tick when the engine started*/
+    TaskHandle_t task;
+    uint32_t late;                  /*Wake ups that happened after the deadline*/
+} periodic_out_t;
+
+esp_err_t periodic_out_init(periodic_out_t *engine, periodic_out_entry_t *storage, uint16_t capacity);
+
+/*Outputs must be added before starting the engine. The first execution
+  happens 'phase' ticks after the start*/
+esp_err_t periodic_out_add(periodic_out_t *engine, TickType_t period, TickType_t phase,
+                           periodic_out_action_t action, void *arg);
+
+/*The engine task is pinned to 'core' (tskNO_AFFINITY to let it run on any core)*/
+esp_err_t periodic_out_start(periodic_out_t *engine, const char *name, uint32_t stack, UBaseType_t priority,
+                             BaseType_t core);
+
+#ifdef __cplusplus
+}
+#endif
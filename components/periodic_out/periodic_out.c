@@ -0,0 +1,143 @@
+/***************************************************************************
+*@brief Periodic Out: one task driving many periodic outputs
+***************************************************************************/
+#include <stdbool.h>
+#include "esp_check.h"
+#include "periodic_out.h"
+
+static const char *TAG = "periodic_out";
+
+/*Tick comparison that keeps working when the tick count wraps around*/
+static inline bool before(TickType_t a, TickType_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+/*********************
+*   MIN-HEAP
+*********************/
+static void swap(periodic_out_entry_t *a, periodic_out_entry_t *b)
+{
+    periodic_out_entry_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static void sift_up(periodic_out_t *engine, uint16_t i)
+{
+    while (i > 0)
+    {
+        uint16_t parent = (i - 1) / 2;
+        if (!before(engine->heap[i].deadline, engine->heap[parent].deadline))
+        {
+            break;
+        }
+        swap(&engine->heap[i], &engine->heap[parent]);
+        i = parent;
+    }
+}
+
+static void sift_down(periodic_out_t *engine, uint16_t i)
+{
+    while (1)
+    {
+        uint16_t left = 2 * i + 1;
+        uint16_t right = left + 1;
+        uint16_t first = i;
+
+        if (left < engine->count && before(engine->heap[left].deadline, engine->heap[first].deadline))
+        {
+            first = left;
+        }
+        if (right < engine->count && before(engine->heap[right].deadline, engine->heap[first].deadline))
+        {
+            first = right;
+        }
+        if (first == i)
+        {
+            break;
+        }
+        swap(&engine->heap[i], &engine->heap[first]);
+        i = first;
+    }
+}
+
+/*********************
+*   ENGINE TASK
+*********************/
+static void periodic_out_task(void *pvParameters)
+{
+    periodic_out_t *engine = (periodic_out_t *)pvParameters;
+    TickType_t now = engine->start;
+
+    while (1)
+    {
+        /*Sleep until the earliest deadline, 'now' becomes that deadline*/
+        TickType_t wait = engine->heap[0].deadline - now;
+        if (before(now, engine->heap[0].deadline) && xTaskDelayUntil(&now, wait) == pdFALSE)
+        {
+            engine->late++;
+        }
+
+        /*Every output whose deadline was reached runs before sleeping again*/
+        while (!before(now, engine->heap[0].deadline))
+        {
+            periodic_out_entry_t *top = &engine->heap[0];
+            top->action(top->arg);
+            top->deadline += top->period;
+            sift_down(engine, 0);
+        }
+    }
+}
+
+/*********************
+*   PUBLIC API
+*********************/
+esp_err_t periodic_out_init(periodic_out_t *engine, periodic_out_entry_t *storage, uint16_t capacity)
+{
+    ESP_RETURN_ON_FALSE(engine && storage && capacity > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    engine->heap = storage;
+    engine->count = 0;
+    engine->capacity = capacity;
+    engine->start = 0;
+    engine->task = NULL;
+    engine->late = 0;
+    return ESP_OK;
+}
+
+esp_err_t periodic_out_add(periodic_out_t *engine, TickType_t period, TickType_t phase,
+                           periodic_out_action_t action, void *arg)
+{
+    ESP_RETURN_ON_FALSE(engine && action && period > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(engine->task == NULL, ESP_ERR_INVALID_STATE, TAG, "engine already started");
+    ESP_RETURN_ON_FALSE(engine->count < engine->capacity, ESP_ERR_NO_MEM, TAG, "no room for more outputs");
+
+    /*Deadlines are relative to the start until the engine starts*/
+    periodic_out_entry_t *entry = &engine->heap[engine->count];
+    entry->deadline = phase;
+    entry->period = period;
+    entry->action = action;
+    entry->arg = arg;
+    sift_up(engine, engine->count++);
+    return ESP_OK;
+}
+
+esp_err_t periodic_out_start(periodic_out_t *engine, const char *name, uint32_t stack, UBaseType_t priority,
+                             BaseType_t core)
+{
+    ESP_RETURN_ON_FALSE(engine && engine->count > 0, ESP_ERR_INVALID_ARG, TAG, "no outputs to drive");
+    ESP_RETURN_ON_FALSE(engine->task == NULL, ESP_ERR_INVALID_STATE, TAG, "engine already started");
+
+    /*Relative deadlines become absolute ticks, the heap order does not change*/
+    engine->start = xTaskGetTickCount();
+    for (uint16_t i = 0; i < engine->count; i++)
+    {
+        engine->heap[i].deadline += engine->start;
+    }
+
+    ESP_RETURN_ON_FALSE(xTaskCreatePinnedToCore(periodic_out_task, name, stack, engine, priority,
+                                                &engine->task, core) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG, "engine task was not created");
+    return ESP_OK;
+}
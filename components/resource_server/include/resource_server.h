@@ -0,0 +1,89 @@
+/***************************************************************************
+*@brief Resource Server: a task owning a resource, fed by a request queue
+Instead of every client taking a mutex and holding it while the resource
+works, a single server task owns the resource and executes the requests the
+clients post to its queue. Posting does not wait for the resource: the
+client goes on and learns the result through a completion callback (run by
+the server task) and/or a notification on RESOURCE_SERVER_NOTIFY_INDEX
+(CONFIG_RESOURCE_SERVER_NOTIFY_INDEX).
+The server drains up to RESOURCE_SERVER_BATCH pending requests at once and
+coalesces the ones with the same operation and argument: the resource works
+once and every request of the group is completed with that result.
+The server does not allocate memory: the caller provides the queue storage.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESOURCE_SERVER_NOTIFY_INDEX    CONFIG_RESOURCE_SERVER_NOTIFY_INDEX
+#define RESOURCE_SERVER_BATCH           8   /*Requests drained and coalesced at once*/
+
+#if RESOURCE_SERVER_NOTIFY_INDEX >= configTASK_NOTIFICATION_ARRAY_ENTRIES
+#error "CONFIG_RESOURCE_SERVER_NOTIFY_INDEX must be lower than CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES"
+#endif
+
+/*Executed by the server task, the only one touching the resource*/
+typedef esp_err_t (*resource_server_handler_t)(uint32_t op, uint32_t arg, void *resource);
+/*Completion callback, also executed by the server task*/
+typedef void (*resource_server_done_t)(esp_err_t result, void *ctx);
+
+typedef struct {
+    uint32_t op;
+    uint32_t arg;
+    resource_server_done_t done;    /*NULL for no callback*/
+    void *ctx;
+    TaskHandle_t client;            /*Notified with the result, NULL for no notification*/
+} resource_request_t;
+
+#define RESOURCE_SERVER_STORAGE_SIZE(length)    ((length) * sizeof(resource_request_t))
+
+typedef struct {
+    QueueHandle_t requests;
+    StaticQueue_t queueStorage;
+    resource_server_handler_t handler;
+    void *resource;
+    TaskHandle_t task;
+    uint32_t served;        /*Requests completed*/
+    uint32_t executed;      /*Times the handler ran, served minus the coalesced ones*/
+    atomic_uint rejected;   /*Posts that found the queue full, counted by every client*/
+} resource_server_t;
+
+/*'storage' holds RESOURCE_SERVER_STORAGE_SIZE(length) bytes*/
+esp_err_t resource_server_init(resource_server_t *server, uint8_t *storage, uint32_t length,
+                               resource_server_handler_t handler, void *resource);
+
+esp_err_t resource_server_start(resource_server_t *server, const char *name, uint32_t stack,
+                                UBaseType_t priority, BaseType_t core);
+
+/*Deletes the server task, requests still queued are not completed*/
+esp_err_t resource_server_stop(resource_server_t *server);
+
+/*Waits up to 'timeout' only for room in the queue, never for the resource*/
+esp_err_t resource_server_post(resource_server_t *server, const resource_request_t *request, TickType_t timeout);
+
+/*Client side of the notification: true and the result once its request was completed*/
+static inline bool resource_server_wait(esp_err_t *result, TickType_t timeout)
+{
+    uint32_t value = 0;
+    BaseType_t completed = xTaskNotifyWaitIndexed(RESOURCE_SERVER_NOTIFY_INDEX, 0, UINT32_MAX, &value, timeout);
+
+    if (completed && result)
+    {
+        *result = (esp_err_t)value;
+    }
+    return completed == pdTRUE;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,110 @@
+/***************************************************************************
+*@brief Resource Server: a task owning a resource, fed by a request queue
+***************************************************************************/
+#include <stdbool.h>
+#include "esp_check.h"
+#include "resource_server.h"
+
+static const char *TAG = "resource_server";
+
+static void complete(const resource_request_t *request, esp_err_t result)
+{
+    if (request->done)
+    {
+        request->done(result, request->ctx);
+    }
+    if (request->client)
+    {
+        xTaskNotifyIndexed(request->client, RESOURCE_SERVER_NOTIFY_INDEX, (uint32_t)result, eSetValueWithOverwrite);
+    }
+}
+
+static void resource_server_task(void *pvParameters)
+{
+    resource_server_t *server = (resource_server_t *)pvParameters;
+    resource_request_t batch[RESOURCE_SERVER_BATCH];
+    bool merged[RESOURCE_SERVER_BATCH];
+
+    while (1)
+    {
+        /*Sleeps until a request arrives, then takes whatever else is already pending*/
+        uint32_t count = 0;
+        xQueueReceive(server->requests, &batch[count++], portMAX_DELAY);
+        while (count < RESOURCE_SERVER_BATCH && xQueueReceive(server->requests, &batch[count], 0))
+        {
+            count++;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            merged[i] = false;
+        }
+        /*In order of arrival, every later twin is completed with the first one*/
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (merged[i])
+            {
+                continue;
+            }
+            esp_err_t result = server->handler(batch[i].op, batch[i].arg, server->resource);
+            server->executed++;
+
+            for (uint32_t j = i; j < count; j++)
+            {
+                if (j == i || (!merged[j] && batch[j].op == batch[i].op && batch[j].arg == batch[i].arg))
+                {
+                    merged[j] = true;
+                    complete(&batch[j], result);
+                    server->served++;
+                }
+            }
+        }
+    }
+}
+
+esp_err_t resource_server_init(resource_server_t *server, uint8_t *storage, uint32_t length,
+                               resource_server_handler_t handler, void *resource)
+{
+    ESP_RETURN_ON_FALSE(server && storage && length > 0 && handler, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    server->requests = xQueueCreateStatic(length, sizeof(resource_request_t), storage, &server->queueStorage);
+    server->handler = handler;
+    server->resource = resource;
+    server->task = NULL;
+    server->served = 0;
+    server->executed = 0;
+    atomic_init(&server->rejected, 0);
+    ESP_RETURN_ON_FALSE(server->requests, ESP_ERR_INVALID_STATE, TAG, "request queue was not created");
+    return ESP_OK;
+}
+
+esp_err_t resource_server_start(resource_server_t *server, const char *name, uint32_t stack,
+                                UBaseType_t priority, BaseType_t core)
+{
+    ESP_RETURN_ON_FALSE(server && server->requests, ESP_ERR_INVALID_ARG, TAG, "server not initialized");
+    ESP_RETURN_ON_FALSE(server->task == NULL, ESP_ERR_INVALID_STATE, TAG, "server already started");
+
+    ESP_RETURN_ON_FALSE(xTaskCreatePinnedToCore(resource_server_task, name, stack, server, priority,
+                                                &server->task, core) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG, "server task was not created");
+    return ESP_OK;
+}
+
+esp_err_t resource_server_stop(resource_server_t *server)
+{
+    ESP_RETURN_ON_FALSE(server && server->task, ESP_ERR_INVALID_STATE, TAG, "server not started");
+
+    vTaskDelete(server->task);
+    server->task = NULL;
+    return ESP_OK;
+}
+
+esp_err_t resource_server_post(resource_server_t *server, const resource_request_t *request, TickType_t timeout)
+{
+    if (xQueueSend(server->requests, request, timeout) != pdTRUE)
+    {
+        atomic_fetch_add_explicit(&server->rejected, 1, memory_order_relaxed);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+*@brief SPSC Ring: lock-free queue for one producer and one consumer task
+The producer only writes 'head' and the consumer only writes 'tail', so
+pushing and popping never enter a critical section. C11 atomics order the
+item copy before the index update, which keeps it safe with the producer and
+the consumer on different cores.
+The blocking calls sleep on a task notification only while the ring is full
+(producer) or empty (consumer), the other side notifies them after moving
+its index. While blocked, the task must not expect other notifications on
+SPSC_RING_NOTIFY_INDEX, which is set for the whole project with
+CONFIG_SPSC_RING_NOTIFY_INDEX.
+The capacity must be a power of two.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPSC_RING_NOTIFY_INDEX  CONFIG_SPSC_RING_NOTIFY_INDEX
+
+#if SPSC_RING_NOTIFY_INDEX >= configTASK_NOTIFICATION_ARRAY_ENTRIES
+#error "CONFIG_SPSC_RING_NOTIFY_INDEX must be lower than CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES"
+#endif
+
+typedef struct {
+    uint8_t *items;
+    size_t item_size;
+    uint32_t mask;                          /*capacity - 1*/
+    atomic_uint_fast32_t head;              /*Items pushed, written by the producer*/
+    atomic_uint_fast32_t tail;              /*Items popped, written by the consumer*/
+    _Atomic(TaskHandle_t) producer_waiting; /*Producer sleeping on a full ring*/
+    _Atomic(TaskHandle_t) consumer_waiting; /*Consumer sleeping on an empty ring*/
+} spsc_ring_t;
+
+/*'storage' holds capacity * item_size bytes*/
+esp_err_t spsc_ring_init(spsc_ring_t *ring, void *storage, size_t item_size, uint32_t capacity);
+
+/*Non blocking, false when the ring is full or empty*/
+bool spsc_ring_push(spsc_ring_t *ring, const void *item);
+bool spsc_ring_pop(spsc_ring_t *ring, void *item);
+
+/*Block up to 'timeout' for room or for an item, ESP_ERR_TIMEOUT otherwise*/
+esp_err_t spsc_ring_send(spsc_ring_t *ring, const void *item, TickType_t timeout);
+esp_err_t spsc_ring_receive(spsc_ring_t *ring, void *item, TickType_t timeout);
+
+static inline uint32_t spsc_ring_count(spsc_ring_t *ring)
+{
+    return (uint32_t)(atomic_load_explicit(&ring->head, memory_order_acquire) -
+                      atomic_load_explicit(&ring->tail, memory_order_acquire));
+}
+
+static inline uint32_t spsc_ring_capacity(const spsc_ring_t *ring)
+{
+    return ring->mask + 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,119 @@
+/***************************************************************************
+*@brief SPSC Ring: lock-free queue for one producer and one consumer task
+***************************************************************************/
+#include <string.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "spsc_ring.h"
+
+static const char *TAG = "spsc_ring";
+
+esp_err_t spsc_ring_init(spsc_ring_t *ring, void *storage, size_t item_size, uint32_t capacity)
+{
+    ESP_RETURN_ON_FALSE(ring && storage && item_size > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(capacity > 0 && (capacity & (capacity - 1)) == 0, ESP_ERR_INVALID_ARG, TAG,
+                        "capacity %lu is not a power of two", (unsigned long)capacity);
+
+    ring->items = (uint8_t *)storage;
+    ring->item_size = item_size;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->producer_waiting, NULL);
+    atomic_init(&ring->consumer_waiting, NULL);
+    return ESP_OK;
+}
+
+/*Wakes the task sleeping on the other side of the ring, if any*/
+static void wake(_Atomic(TaskHandle_t) *waiting)
+{
+    /*The plain load keeps the common case (nobody waiting) free of read-modify-write*/
+    TaskHandle_t task = atomic_load(waiting) ? atomic_exchange(waiting, NULL) : NULL;
+
+    if (task)
+    {
+        xTaskNotifyGiveIndexed(task, SPSC_RING_NOTIFY_INDEX);
+    }
+}
+
+bool spsc_ring_push(spsc_ring_t *ring, const void *item)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail > ring->mask)
+    {
+        return false;
+    }
+    memcpy(ring->items + (head & ring->mask) * ring->item_size, item, ring->item_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);    /*Item visible before the index*/
+
+    /*The index store must be ordered before the waiter is read, pairs with the fence in wait_for()*/
+    atomic_thread_fence(memory_order_seq_cst);
+    wake(&ring->consumer_waiting);
+    return true;
+}
+
+bool spsc_ring_pop(spsc_ring_t *ring, void *item)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail)
+    {
+        return false;
+    }
+    memcpy(item, ring->items + (tail & ring->mask) * ring->item_size, ring->item_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);    /*Slot released after the copy*/
+
+    atomic_thread_fence(memory_order_seq_cst);
+    wake(&ring->producer_waiting);
+    return true;
+}
+
+/*Sleeps until 'ready' succeeds or the timeout expires. The task registers
+  itself before checking again, so a wake up can not be lost in between: the
+  fences make either this check see the new index or the other side see the
+  waiter (store-load ordering, which release/acquire alone does not give)*/
+static esp_err_t wait_for(spsc_ring_t *ring, _Atomic(TaskHandle_t) *waiting,
+                          bool (*ready)(spsc_ring_t *, void *), void *item, TickType_t timeout)
+{
+    TimeOut_t start;
+
+    vTaskSetTimeOutState(&start);
+    while (1)
+    {
+        if (ready(ring, item))
+        {
+            return ESP_OK;
+        }
+        atomic_store(waiting, xTaskGetCurrentTaskHandle());
+        atomic_thread_fence(memory_order_seq_cst);
+        if (ready(ring, item))
+        {
+            atomic_store(waiting, NULL);
+            return ESP_OK;
+        }
+        if (xTaskCheckForTimeOut(&start, &timeout) == pdTRUE)
+        {
+            atomic_store(waiting, NULL);
+            return ESP_ERR_TIMEOUT;
+        }
+        ulTaskNotifyTakeIndexed(SPSC_RING_NOTIFY_INDEX, pdTRUE, timeout);
+    }
+}
+
+static bool push_ready(spsc_ring_t *ring, void *item)
+{
+    return spsc_ring_push(ring, item);
+}
+
+esp_err_t spsc_ring_send(spsc_ring_t *ring, const void *item, TickType_t timeout)
+{
+    return wait_for(ring, &ring->producer_waiting, push_ready, (void *)item, timeout);
+}
+
+esp_err_t spsc_ring_receive(spsc_ring_t *ring, void *item, TickType_t timeout)
+{
+    return wait_for(ring, &ring->consumer_waiting, spsc_ring_pop, item, timeout);
+}
@@ -0,0 +1,39 @@
+/***************************************************************************
+*@brief Stream Frame: binary records that survive the console UART
+The binary streams of the components (deferred_log, task_stats) share the
+console with the ESP_LOGx text, so every record is framed:
+  sync u16 | record bytes | crc u16
+The sync is 0xA5 followed by a byte that tells the stream apart. The crc is
+CRC-16/CCITT-FALSE of the record. After the sync, every byte that the
+console could translate or that could look like a sync (0x0A, 0x0D, 0xA5)
+and the escape itself (0x7D) is sent as 0x7D followed by the byte XOR 0x20,
+so a CRLF conversion of stdout cannot corrupt a record and a decoder can
+find the next record after any garbage.
+tools/stream_frame.py is the host side.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STREAM_FRAME_SYNC_BYTE  0xA5
+#define STREAM_FRAME_ESCAPE     0x7D    /*Followed by the escaped byte XOR 0x20*/
+#define STREAM_FRAME_SYNC(id)   ((uint16_t)(STREAM_FRAME_SYNC_BYTE | ((id) << 8)))  /*Little endian u16*/
+
+/*Bytes of the frame of a 'length' bytes record, when every byte is escaped*/
+#define STREAM_FRAME_MAX_SIZE(length)   (2 + 2 * ((length) + 2))
+
+/*CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF*/
+uint16_t stream_frame_crc(const uint8_t *data, size_t length);
+
+/*Writes the frame of 'record' into 'frame' (STREAM_FRAME_MAX_SIZE(length)
+  bytes) and returns the bytes written*/
+size_t stream_frame_encode(uint16_t sync, const uint8_t *record, size_t length, uint8_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,53 @@
+/***************************************************************************
+*@brief Stream Frame: binary records that survive the console UART
+***************************************************************************/
+#include <stdbool.h>
+#include "stream_frame.h"
+
+uint16_t stream_frame_crc(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static bool must_escape(uint8_t byte)
+{
+    return byte == '\n' || byte == '\r' || byte == STREAM_FRAME_SYNC_BYTE || byte == STREAM_FRAME_ESCAPE;
+}
+
+static size_t put_escaped(uint8_t *frame, uint8_t byte)
+{
+    if (must_escape(byte))
+    {
+        frame[0] = STREAM_FRAME_ESCAPE;
+        frame[1] = byte ^ 0x20;
+        return 2;
+    }
+    frame[0] = byte;
+    return 1;
+}
+
+size_t stream_frame_encode(uint16_t sync, const uint8_t *record, size_t length, uint8_t *frame)
+{
+    uint16_t crc = stream_frame_crc(record, length);
+    size_t out = 0;
+
+    frame[out++] = sync & 0xFF;
+    frame[out++] = sync >> 8;
+    for (size_t i = 0; i < length; i++)
+    {
+        out += put_escaped(&frame[out], record[i]);
+    }
+    out += put_escaped(&frame[out], crc & 0xFF);
+    out += put_escaped(&frame[out], crc >> 8);
+    return out;
+}
@@ -0,0 +1,63 @@
+/***************************************************************************
+*@brief Task Registry: static tasks created from a single table
+Every line of the table declares a task together with its stack and TCB,
+which are placed in .bss, so creating the tasks never allocates heap and
+can not fail for lack of memory at run time.
+Every task may be pinned to a core, so latency critical tasks can be kept away
+from the core running WiFi and the timer daemon.
+The diagnostic monitor samples the stack high water mark of every task and
+prints the stack size recommended for it.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    TaskFunction_t function;
+    const char *name;
+    uint32_t stack_size;        /*Stack depth as given to xTaskCreateStatic (bytes in ESP-IDF)*/
+    void *param;
+    UBaseType_t priority;
+    BaseType_t core;            /*Core the task is pinned to or tskNO_AFFINITY*/
+    StackType_t *stack;         /*Static stack of 'stack_size' elements*/
+    StaticTask_t *tcb;          /*Static task control block*/
+} task_registry_entry_t;
+
+/*Line of a table, the compound literals give every task its own static stack and TCB*/
+#define TASK_REGISTRY_PINNED(_function, _name, _stack_size, _param, _priority, _core) \
+    {                                                                       \
+        .function = (_function),                                            \
+        .name = (_name),                                                    \
+        .stack_size = (_stack_size),                                        \
+        .param = (_param),                                                  \
+        .priority = (_priority),                                            \
+        .core = (_core),                                                    \
+        .stack = (StackType_t[(_stack_size)]){0},                           \
+        .tcb = &(StaticTask_t){},                                           \
+    }
+
+/*Line of a task that may run on any core*/
+#define TASK_REGISTRY_ENTRY(_function, _name, _stack_size, _param, _priority) \
+    TASK_REGISTRY_PINNED(_function, _name, _stack_size, _param, _priority, tskNO_AFFINITY)
+
+/*Creates every task of the table, 'handles' (may be NULL) receives one handle per line*/
+esp_err_t task_registry_start(const task_registry_entry_t *table, size_t count, TaskHandle_t *handles);
+
+/*Prints the stack used by every task and the minimal size recommended for it*/
+void task_registry_report(const task_registry_entry_t *table, size_t count, const TaskHandle_t *handles);
+
+/*Diagnostic mode: prints the report every 'period_ms' from a software timer*/
+esp_err_t task_registry_monitor(const task_registry_entry_t *table, size_t count, const TaskHandle_t *handles,
+                                uint32_t period_ms);
+
+#ifdef __cplusplus
+}
+#endif
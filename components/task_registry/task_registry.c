@@ -0,0 +1,86 @@
+/***************************************************************************
+*@brief Task Registry: static tasks created from a single table
+***************************************************************************/
+#include "freertos/timers.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "task_registry.h"
+
+#define STACK_MARGIN    256     /*Bytes added to the measured usage for ISRs and untested paths*/
+#define STACK_ALIGN     16
+
+static const char *TAG = "task_registry";
+
+/*Arguments of the monitor timer*/
+typedef struct {
+    const task_registry_entry_t *table;
+    size_t count;
+    const TaskHandle_t *handles;
+} monitor_t;
+
+static monitor_t monitor;
+
+esp_err_t task_registry_start(const task_registry_entry_t *table, size_t count, TaskHandle_t *handles)
+{
+    ESP_RETURN_ON_FALSE(table || count == 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    for (size_t i = 0; i < count; i++)
+    {
+        TaskHandle_t handle = xTaskCreateStaticPinnedToCore(table[i].function, table[i].name, table[i].stack_size,
+                                                            table[i].param, table[i].priority, table[i].stack,
+                                                            table[i].tcb, table[i].core);
+        ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG, "%s was not created", table[i].name);
+        if (handles)
+        {
+            handles[i] = handle;
+        }
+    }
+    return ESP_OK;
+}
+
+void task_registry_report(const task_registry_entry_t *table, size_t count, const TaskHandle_t *handles)
+{
+    uint32_t total = 0;
+    uint32_t recommended_total = 0;
+
+    ESP_LOGI(TAG, "%-16s %4s %4s %8s %8s %12s", "Task", "Core", "Prio", "Stack", "Used", "Recommended");
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t size = table[i].stack_size * sizeof(StackType_t);
+        uint32_t used = size - uxTaskGetStackHighWaterMark(handles[i]) * sizeof(StackType_t);
+        uint32_t recommended = used + used / 4 + STACK_MARGIN;
+
+        recommended = (recommended + STACK_ALIGN - 1) & ~(STACK_ALIGN - 1);
+        if (recommended > size)
+        {
+            recommended = size;     /*Never recommend more than what already works*/
+        }
+        total += size;
+        recommended_total += recommended;
+        ESP_LOGI(TAG, "%-16s %4s %4u %8lu %8lu %12lu", table[i].name,
+                 table[i].core == tskNO_AFFINITY ? "any" : (table[i].core ? "1" : "0"), (unsigned)table[i].priority,
+                 (unsigned long)size, (unsigned long)used, (unsigned long)recommended);
+    }
+    ESP_LOGI(TAG, "Stacks: %lu bytes, %lu bytes could be reclaimed",
+             (unsigned long)total, (unsigned long)(total - recommended_total));
+}
+
+static void monitor_callback(TimerHandle_t xTimer)
+{
+    task_registry_report(monitor.table, monitor.count, monitor.handles);
+}
+
+esp_err_t task_registry_monitor(const task_registry_entry_t *table, size_t count, const TaskHandle_t *handles,
+                                uint32_t period_ms)
+{
+    ESP_RETURN_ON_FALSE(table && handles && period_ms > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    monitor.table = table;
+    monitor.count = count;
+    monitor.handles = handles;
+
+    TimerHandle_t timer = xTimerCreate("task_registry", pdMS_TO_TICKS(period_ms), pdTRUE, NULL, monitor_callback);
+    ESP_RETURN_ON_FALSE(timer, ESP_ERR_NO_MEM, TAG, "monitor timer was not created");
+    ESP_RETURN_ON_FALSE(xTimerStart(timer, 0) == pdPASS, ESP_FAIL, TAG, "monitor timer was not started");
+    return ESP_OK;
+}
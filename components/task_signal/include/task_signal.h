@@ -0,0 +1,87 @@
+/***************************************************************************
+*@brief Task Signal: wake up a task with a notification or a semaphore
+TASK_SIGNAL_NOTIFY: one waiter known in advance is woken with a direct to
+task notification, no kernel object is needed and give/wake is faster.
+While waiting, the task must not expect other notifications.
+TASK_SIGNAL_SEMAPHORE: a binary semaphore, for many givers to one waiter
+whose task is not known, or several waiters.
+Both keep the binary semaphore meaning: gives while nobody waits are
+remembered once.
+***************************************************************************/
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TASK_SIGNAL_NOTIFY,
+    TASK_SIGNAL_SEMAPHORE,
+} task_signal_kind_t;
+
+typedef struct {
+    task_signal_kind_t kind;
+    TaskHandle_t waiter;            /*TASK_SIGNAL_NOTIFY: the task woken by every give*/
+    SemaphoreHandle_t semaphore;    /*TASK_SIGNAL_SEMAPHORE*/
+    StaticSemaphore_t storage;
+} task_signal_t;
+
+/*'waiter' may be NULL and set later with task_signal_set_waiter()*/
+esp_err_t task_signal_init_notify(task_signal_t *signal, TaskHandle_t waiter);
+esp_err_t task_signal_init_semaphore(task_signal_t *signal);
+
+static inline void task_signal_set_waiter(task_signal_t *signal, TaskHandle_t waiter)
+{
+    signal->waiter = waiter;
+}
+
+/*ESP_ERR_INVALID_STATE when the waiter of a notification is not known yet*/
+static inline esp_err_t task_signal_give(task_signal_t *signal)
+{
+    if (signal->kind == TASK_SIGNAL_SEMAPHORE)
+    {
+        xSemaphoreGive(signal->semaphore);
+        return ESP_OK;
+    }
+    if (signal->waiter == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotifyGive(signal->waiter);
+    return ESP_OK;
+}
+
+static inline esp_err_t task_signal_give_from_isr(task_signal_t *signal, BaseType_t *xHigherPriorityTaskWoken)
+{
+    if (signal->kind == TASK_SIGNAL_SEMAPHORE)
+    {
+        xSemaphoreGiveFromISR(signal->semaphore, xHigherPriorityTaskWoken);
+        return ESP_OK;
+    }
+    if (signal->waiter == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    vTaskNotifyGiveFromISR(signal->waiter, xHigherPriorityTaskWoken);
+    return ESP_OK;
+}
+
+/*True when the signal was given before 'timeout'*/
+static inline bool task_signal_wait(task_signal_t *signal, TickType_t timeout)
+{
+    if (signal->kind == TASK_SIGNAL_SEMAPHORE)
+    {
+        return xSemaphoreTake(signal->semaphore, timeout) == pdTRUE;
+    }
+    return ulTaskNotifyTake(pdTRUE, timeout) > 0;     /*Clearing on take keeps the binary meaning*/
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,29 @@
+/***************************************************************************
+*@brief Task Signal: wake up a task with a notification or a semaphore
+***************************************************************************/
+#include "esp_check.h"
+#include "esp_log.h"
+#include "task_signal.h"
+
+static const char *TAG = "task_signal";
+
+esp_err_t task_signal_init_notify(task_signal_t *signal, TaskHandle_t waiter)
+{
+    ESP_RETURN_ON_FALSE(signal, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    signal->kind = TASK_SIGNAL_NOTIFY;
+    signal->waiter = waiter;
+    signal->semaphore = NULL;
+    return ESP_OK;
+}
+
+esp_err_t task_signal_init_semaphore(task_signal_t *signal)
+{
+    ESP_RETURN_ON_FALSE(signal, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    signal->kind = TASK_SIGNAL_SEMAPHORE;
+    signal->waiter = NULL;
+    signal->semaphore = xSemaphoreCreateBinaryStatic(&signal->storage);
+    ESP_RETURN_ON_FALSE(signal->semaphore, ESP_ERR_INVALID_STATE, TAG, "semaphore was not created");
+    return ESP_OK;
+}
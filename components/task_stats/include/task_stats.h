@@ -0,0 +1,121 @@
+/***************************************************************************
+*@brief Task Stats: CPU usage and context switches of every task
+A software timer samples uxTaskGetSystemState() and computes, for every task,
+the CPU used since the previous sample (per mille of one core), the context
+switches per second and the free stack. The results are published as text
+or as a compact binary record to any sink (UART, console, file...).
+Requires CONFIG_FREERTOS_USE_TRACE_FACILITY and
+CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS. Only FreeRTOS APIs are used, so it
+also runs on the linux target (FreeRTOS POSIX port).
+
+Context switches are counted by task_stats_switched_in(), which must be
+called from traceTASK_SWITCHED_IN() in FreeRTOSConfig.h. Ports that do not
+let the application define the trace hooks (ESP-IDF) report 0 switches and
+leave TASK_STATS_FLAG_SWITCHES cleared; the text report prints them as n/a.
+With more than TASK_STATS_MAX_TASKS tasks, the first ones are kept and
+TASK_STATS_FLAG_TRUNCATED is set. The overhead of a record is the cost of
+its own sample; publishing it is charged to the timer daemon task.
+
+Binary record, little endian:
+  header  magic u16 'TS' | version u8 | tasks u8 | flags u8 | reserved u8 |
+          overhead u16 (per mille) | sequence u32 | window u32 (run time counts)
+  task    number u16 | cpu u16 (per mille) | switches u16 (per second) |
+          stack free u16 | name char[8]
+task_stats_encode_frame() wraps the record in a stream_frame (sync 0x53A5,
+escaped bytes and a CRC-16), the form to send over the console UART;
+tools/task_stats_decode.py prints the frames found in a capture.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "stream_frame.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TASK_STATS_MAX_TASKS
+#define TASK_STATS_MAX_TASKS        24      /*Tasks followed, bounds the cost of every sample*/
+#endif
+
+#define TASK_STATS_NAME_LEN         8
+#define TASK_STATS_MAGIC            0x5354  /*'TS'*/
+#define TASK_STATS_VERSION          1
+#define TASK_STATS_HEADER_SIZE      16
+#define TASK_STATS_TASK_SIZE        (8 + TASK_STATS_NAME_LEN)
+#define TASK_STATS_RECORD_MAX       (TASK_STATS_HEADER_SIZE + TASK_STATS_MAX_TASKS * TASK_STATS_TASK_SIZE)
+#define TASK_STATS_FRAME_MAX        STREAM_FRAME_MAX_SIZE(TASK_STATS_RECORD_MAX)
+#define TASK_STATS_SYNC             STREAM_FRAME_SYNC(0x53)
+
+#define TASK_STATS_FLAG_SWITCHES    (1 << 0)    /*Context switches were counted*/
+#define TASK_STATS_FLAG_TRUNCATED   (1 << 1)    /*More tasks than TASK_STATS_MAX_TASKS, the rest were left out*/
+
+typedef struct {
+    TaskHandle_t handle;
+    const char *name;
+    uint16_t number;                /*uxTaskNumber, stable while the task lives*/
+    uint16_t cpu;                   /*Per mille of one core since the previous sample*/
+    uint16_t switches;              /*Context switches per second*/
+    uint16_t stack_free;            /*Stack high water mark*/
+    uint32_t runtime;               /*Run time counter when sampled*/
+    uint32_t switch_count;          /*Switch counter when sampled*/
+} task_stats_task_t;
+
+typedef struct task_stats task_stats_t;
+
+/*Executed from the timer daemon after every sample*/
+typedef void (*task_stats_callback_t)(const task_stats_t *stats, void *arg);
+
+struct task_stats {
+    TaskStatus_t status[TASK_STATS_MAX_TASKS];
+    task_stats_task_t tasks[2][TASK_STATS_MAX_TASKS];  /*Current and previous sample*/
+    uint8_t current;
+    uint8_t count;
+    uint8_t flags;
+    uint32_t sequence;              /*Samples taken*/
+    uint32_t total;                 /*Run time counter of the last sample*/
+    uint32_t window;                /*Run time counts between the last two samples*/
+    TickType_t tick;
+    uint32_t overhead;              /*Run time counts spent taking the last sample*/
+    uint32_t overhead_max;
+    uint16_t overhead_permille;     /*Overhead of the last sample over its window*/
+    TimerHandle_t timer;
+    task_stats_callback_t on_sample;
+    void *arg;
+};
+
+esp_err_t task_stats_init(task_stats_t *stats);
+
+/*Takes a sample now, the first one only sets the reference*/
+esp_err_t task_stats_sample(task_stats_t *stats);
+
+/*Samples every 'period_ms' from a software timer and calls 'on_sample' (may be NULL)*/
+esp_err_t task_stats_start(task_stats_t *stats, uint32_t period_ms, task_stats_callback_t on_sample, void *arg);
+
+esp_err_t task_stats_stop(task_stats_t *stats);
+
+/*Binary record of the last sample, 'len' receives the bytes written*/
+esp_err_t task_stats_encode(const task_stats_t *stats, uint8_t *buffer, size_t size, size_t *len);
+
+/*Framed record of the last sample (TASK_STATS_FRAME_MAX bytes at most), for byte streams shared with text*/
+esp_err_t task_stats_encode_frame(const task_stats_t *stats, uint8_t *buffer, size_t size, size_t *len);
+
+/*Text report of the last sample*/
+void task_stats_log(const task_stats_t *stats);
+
+/*Context switch hook, for traceTASK_SWITCHED_IN()*/
+void task_stats_switched_in(void);
+
+static inline const task_stats_task_t *task_stats_tasks(const task_stats_t *stats)
+{
+    return stats->tasks[stats->current];
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,280 @@
+/***************************************************************************
+*@brief Task Stats: CPU usage and context switches of every task
+***************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "esp_check.h"
+#include "esp_log.h"
+#include "task_stats.h"
+
+#define SPARE_TASKS     4       /*Room for tasks created while the state is being read*/
+
+static const char *TAG = "task_stats";
+
+/*Switches of every task counted by the trace hook, claimed on first switch*/
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t count;
+} switch_slot_t;
+
+static switch_slot_t switchSlots[TASK_STATS_MAX_TASKS];
+static volatile bool switchesCounted = false;
+
+void task_stats_switched_in(void)
+{
+    TaskHandle_t handle = xTaskGetCurrentTaskHandle();
+
+    /*Runs inside the scheduler, so it only walks a fixed table*/
+    for (size_t i = 0; i < TASK_STATS_MAX_TASKS; i++)
+    {
+        if (switchSlots[i].handle == handle || switchSlots[i].handle == NULL)
+        {
+            switchSlots[i].handle = handle;
+            switchSlots[i].count++;
+            switchesCounted = true;
+            return;
+        }
+    }
+}
+
+static uint32_t switch_count(TaskHandle_t handle)
+{
+    for (size_t i = 0; i < TASK_STATS_MAX_TASKS && switchSlots[i].handle; i++)
+    {
+        if (switchSlots[i].handle == handle)
+        {
+            return switchSlots[i].count;
+        }
+    }
+    return 0;
+}
+
+static uint16_t saturate16(uint64_t value)
+{
+    return (value > UINT16_MAX) ? UINT16_MAX : (uint16_t)value;
+}
+
+esp_err_t task_stats_init(task_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+#if configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+    memset(stats, 0, sizeof(*stats));
+    return ESP_OK;
+#else
+    ESP_LOGE(TAG, "run time stats and trace facility must be enabled");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t task_stats_sample(task_stats_t *stats)
+{
+#if configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+    uint32_t start = (uint32_t)portGET_RUN_TIME_COUNTER_VALUE();
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = 0;
+    uint8_t truncated = 0;
+
+    /*uxTaskGetSystemState() returns nothing when the tasks do not fit, so with
+      more tasks than TASK_STATS_MAX_TASKS all of them are read into a temporary
+      array and only the first TASK_STATS_MAX_TASKS are kept*/
+    UBaseType_t tasks = uxTaskGetNumberOfTasks();
+    if (tasks <= TASK_STATS_MAX_TASKS)
+    {
+        count = uxTaskGetSystemState(stats->status, TASK_STATS_MAX_TASKS, &total);
+    }
+    if (count == 0)
+    {
+        UBaseType_t capacity = tasks + SPARE_TASKS;
+        TaskStatus_t *all = malloc(capacity * sizeof(TaskStatus_t));
+        ESP_RETURN_ON_FALSE(all, ESP_ERR_NO_MEM, TAG, "no memory for %u tasks", (unsigned)capacity);
+
+        count = uxTaskGetSystemState(all, capacity, &total);
+        if (count > TASK_STATS_MAX_TASKS)
+        {
+            count = TASK_STATS_MAX_TASKS;
+            truncated = TASK_STATS_FLAG_TRUNCATED;
+        }
+        memcpy(stats->status, all, count * sizeof(TaskStatus_t));
+        free(all);
+        ESP_RETURN_ON_FALSE(count > 0, ESP_ERR_INVALID_SIZE, TAG, "task state could not be read");
+    }
+
+    const task_stats_task_t *previous = stats->tasks[stats->current];
+    task_stats_task_t *next = stats->tasks[!stats->current];
+    TickType_t now = xTaskGetTickCount();
+    uint32_t window = (uint32_t)total - stats->total;
+    TickType_t ticks = now - stats->tick;
+    bool first = (stats->sequence == 0);
+
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        const TaskStatus_t *status = &stats->status[i];
+        task_stats_task_t *task = &next[i];
+        uint32_t runtime;
+        uint32_t switches;
+
+        task->handle = status->xHandle;
+        task->name = status->pcTaskName;
+        task->number = (uint16_t)status->xTaskNumber;
+        task->stack_free = saturate16(status->usStackHighWaterMark);
+        task->runtime = (uint32_t)status->ulRunTimeCounter;
+        task->switch_count = switch_count(status->xHandle);
+
+        /*Tasks created during the window count from zero*/
+        runtime = task->runtime;
+        switches = task->switch_count;
+        for (uint8_t j = 0; j < stats->count; j++)
+        {
+            if (previous[j].handle == task->handle)
+            {
+                runtime -= previous[j].runtime;
+                switches -= previous[j].switch_count;
+                break;
+            }
+        }
+
+        task->cpu = (first || window == 0) ? 0 : saturate16((uint64_t)runtime * 1000 / window);
+        task->switches = (first || ticks == 0) ? 0 : saturate16((uint64_t)switches * configTICK_RATE_HZ / ticks);
+    }
+
+    stats->current = !stats->current;
+    stats->count = (uint8_t)count;
+    stats->flags = (switchesCounted ? TASK_STATS_FLAG_SWITCHES : 0) | truncated;
+    stats->window = first ? 0 : window;
+    stats->total = (uint32_t)total;
+    stats->tick = now;
+    stats->sequence++;
+
+    /*Cost of this sample, published with it*/
+    stats->overhead = (uint32_t)portGET_RUN_TIME_COUNTER_VALUE() - start;
+    stats->overhead_max = (stats->overhead > stats->overhead_max) ? stats->overhead : stats->overhead_max;
+    stats->overhead_permille = stats->window ? saturate16((uint64_t)stats->overhead * 1000 / stats->window) : 0;
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/*********************
+*   TIMER SECTION
+*********************/
+static void sample_callback(TimerHandle_t xTimer)
+{
+    task_stats_t *stats = (task_stats_t *)pvTimerGetTimerID(xTimer);
+
+    /*Publishing is not part of the overhead, it is charged to the timer daemon*/
+    if (task_stats_sample(stats) == ESP_OK && stats->on_sample)
+    {
+        stats->on_sample(stats, stats->arg);
+    }
+}
+
+esp_err_t task_stats_start(task_stats_t *stats, uint32_t period_ms, task_stats_callback_t on_sample, void *arg)
+{
+    ESP_RETURN_ON_FALSE(stats && period_ms > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(stats->timer == NULL, ESP_ERR_INVALID_STATE, TAG, "already started");
+
+    stats->on_sample = on_sample;
+    stats->arg = arg;
+    ESP_RETURN_ON_ERROR(task_stats_sample(stats), TAG, "first sample failed");
+
+    stats->timer = xTimerCreate("task_stats", pdMS_TO_TICKS(period_ms), pdTRUE, stats, sample_callback);
+    ESP_RETURN_ON_FALSE(stats->timer, ESP_ERR_NO_MEM, TAG, "sample timer was not created");
+    ESP_RETURN_ON_FALSE(xTimerStart(stats->timer, 0) == pdPASS, ESP_FAIL, TAG, "sample timer was not started");
+    return ESP_OK;
+}
+
+esp_err_t task_stats_stop(task_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(stats && stats->timer, ESP_ERR_INVALID_STATE, TAG, "not started");
+
+    xTimerDelete(stats->timer, portMAX_DELAY);
+    stats->timer = NULL;
+    return ESP_OK;
+}
+
+/*********************
+*   OUTPUT SECTION
+*********************/
+static uint8_t *put16(uint8_t *p, uint16_t value)
+{
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t value)
+{
+    return put16(put16(p, value & 0xFFFF), value >> 16);
+}
+
+esp_err_t task_stats_encode(const task_stats_t *stats, uint8_t *buffer, size_t size, size_t *len)
+{
+    ESP_RETURN_ON_FALSE(stats && buffer && len, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    size_t needed = TASK_STATS_HEADER_SIZE + (size_t)stats->count * TASK_STATS_TASK_SIZE;
+    ESP_RETURN_ON_FALSE(size >= needed, ESP_ERR_INVALID_SIZE, TAG, "record needs %u bytes", (unsigned)needed);
+
+    const task_stats_task_t *tasks = task_stats_tasks(stats);
+    uint8_t *p = buffer;
+
+    p = put16(p, TASK_STATS_MAGIC);
+    *p++ = TASK_STATS_VERSION;
+    *p++ = stats->count;
+    *p++ = stats->flags;
+    *p++ = 0;
+    p = put16(p, stats->overhead_permille);
+    p = put32(p, stats->sequence);
+    p = put32(p, stats->window);
+
+    for (uint8_t i = 0; i < stats->count; i++)
+    {
+        p = put16(p, tasks[i].number);
+        p = put16(p, tasks[i].cpu);
+        p = put16(p, tasks[i].switches);
+        p = put16(p, tasks[i].stack_free);
+        strncpy((char *)p, tasks[i].name, TASK_STATS_NAME_LEN);     /*Padded with zeros, not terminated*/
+        p += TASK_STATS_NAME_LEN;
+    }
+    *len = p - buffer;
+    return ESP_OK;
+}
+
+esp_err_t task_stats_encode_frame(const task_stats_t *stats, uint8_t *buffer, size_t size, size_t *len)
+{
+    uint8_t record[TASK_STATS_RECORD_MAX];
+    size_t length = 0;
+
+    ESP_RETURN_ON_ERROR(task_stats_encode(stats, record, sizeof(record), &length), TAG, "encode failed");
+    ESP_RETURN_ON_FALSE(size >= STREAM_FRAME_MAX_SIZE(length), ESP_ERR_INVALID_SIZE, TAG, "frame needs %u bytes",
+                        (unsigned)STREAM_FRAME_MAX_SIZE(length));
+    *len = stream_frame_encode(TASK_STATS_SYNC, record, length, buffer);
+    return ESP_OK;
+}
+
+void task_stats_log(const task_stats_t *stats)
+{
+    const task_stats_task_t *tasks = task_stats_tasks(stats);
+
+    /*100 % is one core fully used*/
+    ESP_LOGI(TAG, "Sample %lu, overhead %u.%u %% (max %lu counts), switches %s", (unsigned long)stats->sequence,
+             stats->overhead_permille / 10, stats->overhead_permille % 10, (unsigned long)stats->overhead_max,
+             (stats->flags & TASK_STATS_FLAG_SWITCHES) ? "counted" : "n/a (no traceTASK_SWITCHED_IN hook)");
+    if (stats->flags & TASK_STATS_FLAG_TRUNCATED)
+    {
+        ESP_LOGW(TAG, "More than %d tasks, only the first ones are reported", TASK_STATS_MAX_TASKS);
+    }
+    for (uint8_t i = 0; i < stats->count; i++)
+    {
+        if (stats->flags & TASK_STATS_FLAG_SWITCHES)
+        {
+            ESP_LOGI(TAG, "  %-16s %3u.%u %%  %5u sw/s  stack free %u", tasks[i].name,
+                     tasks[i].cpu / 10, tasks[i].cpu % 10, tasks[i].switches, tasks[i].stack_free);
+        }
+        else
+        {
+            ESP_LOGI(TAG, "  %-16s %3u.%u %%  stack free %u", tasks[i].name,
+                     tasks[i].cpu / 10, tasks[i].cpu % 10, tasks[i].stack_free);
+        }
+    }
+}
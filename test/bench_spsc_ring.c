@@ -0,0 +1,124 @@
+/***************************************************************************
+*@brief Host benchmark of spsc_ring against a Queue
+A producer task streams ITEMS values to the main task through the ring and
+through a Queue of the same length, with the non blocking calls (yielding
+while full or empty) and with the blocking ones. Every value must arrive in
+order, then the items per second and the nanoseconds per item are printed.
+The Queue of the shim is a pthread mutex and condition variable, not the
+kernel queue of the target, so the ratio only holds on the host:
+benchmark_spsc_ring() of FreeRTOS_Queues measures the target.
+***************************************************************************/
+#include <stdio.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "spsc_ring.h"
+#include "test_check.h"
+
+#define ITEMS           200000
+#define LENGTH          32
+
+typedef enum {
+    CHANNEL_RING,
+    CHANNEL_QUEUE,
+} channel_kind_t;
+
+typedef struct {
+    const char *name;
+    channel_kind_t kind;
+    bool blocking;
+} channel_t;
+
+static const channel_t channels[] = {
+    { "ring non blocking",  CHANNEL_RING,  false },
+    { "ring blocking",      CHANNEL_RING,  true },
+    { "queue non blocking", CHANNEL_QUEUE, false },
+    { "queue blocking",     CHANNEL_QUEUE, true },
+};
+
+static spsc_ring_t ring;
+static uint32_t storage[LENGTH];
+static QueueHandle_t queue;
+
+static bool channel_send(const channel_t *channel, const uint32_t *value)
+{
+    if (channel->kind == CHANNEL_RING)
+    {
+        return channel->blocking ? spsc_ring_send(&ring, value, portMAX_DELAY) == ESP_OK
+                                 : spsc_ring_push(&ring, value);
+    }
+    return xQueueSend(queue, value, channel->blocking ? portMAX_DELAY : 0) == pdTRUE;
+}
+
+static bool channel_receive(const channel_t *channel, uint32_t *value)
+{
+    if (channel->kind == CHANNEL_RING)
+    {
+        return channel->blocking ? spsc_ring_receive(&ring, value, portMAX_DELAY) == ESP_OK
+                                 : spsc_ring_pop(&ring, value);
+    }
+    return xQueueReceive(queue, value, channel->blocking ? portMAX_DELAY : 0) == pdTRUE;
+}
+
+static void producer_task(void *arg)
+{
+    const channel_t *channel = (const channel_t *)arg;
+
+    for (uint32_t i = 0; i < ITEMS; i++)
+    {
+        while (!channel_send(channel, &i))
+        {
+            taskYIELD();        /*Full, only the non blocking calls return*/
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+/*Returns the microseconds taken to receive ITEMS values in order, 0 on error*/
+static int64_t stream(const channel_t *channel)
+{
+    uint32_t value = 0;
+    uint32_t disordered = 0;
+
+    int64_t start = esp_timer_get_time();
+    if (xTaskCreate(producer_task, "producer", 1024*2, (void *)channel, 2, NULL) != pdPASS)
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < ITEMS; i++)
+    {
+        while (!channel_receive(channel, &value))
+        {
+            taskYIELD();        /*Empty, only the non blocking calls return*/
+        }
+        disordered += (value != i);
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    TEST_CHECK_EQUAL(disordered, 0);
+    return (disordered == 0) ? elapsed : 0;
+}
+
+int main(void)
+{
+    queue = xQueueCreate(LENGTH, sizeof(uint32_t));
+    TEST_CHECK(queue != NULL);
+    printf("%-20s %12s %10s\n", "channel", "items/s", "ns/item");
+
+    for (size_t i = 0; i < sizeof(channels) / sizeof(channels[0]); i++)
+    {
+        TEST_CHECK_EQUAL(spsc_ring_init(&ring, storage, sizeof(storage[0]), LENGTH), ESP_OK);
+        xQueueReset(queue);
+
+        int64_t elapsed = stream(&channels[i]);
+        TEST_CHECK(elapsed > 0);
+        if (elapsed > 0)
+        {
+            printf("%-20s %12.0f %10.1f\n", channels[i].name, ITEMS * 1e6 / elapsed, elapsed * 1e3 / ITEMS);
+        }
+    }
+    vQueueDelete(queue);
+    return TEST_RESULT();
+}
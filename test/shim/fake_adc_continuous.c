@@ -0,0 +1,205 @@
+/***************************************************************************
+*@brief Host shim: fake continuous ADC driver
+***************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "soc/soc_caps.h"
+#include "fake_adc_continuous.h"
+
+struct adc_continuous_ctx_t {
+    uint8_t *store;                         /*Ring buffer of whole frames*/
+    uint32_t frame_size;
+    uint32_t frames;                        /*Frames that fit in the ring buffer*/
+    uint32_t written;
+    uint32_t read;
+    uint32_t unstored;                      /*Frames notified after 'written', not readable yet*/
+    bool late_store;
+    bool started;
+    adc_continuous_config_t config;
+    adc_digi_pattern_config_t pattern[SOC_ADC_PATT_LEN_MAX];
+    adc_continuous_evt_cbs_t cbs;
+    void *user_data;
+};
+
+static adc_continuous_handle_t lastHandle = NULL;
+
+adc_continuous_handle_t fake_adc_continuous_last(void)
+{
+    return lastHandle;
+}
+
+esp_err_t adc_continuous_new_handle(const adc_continuous_handle_cfg_t *config, adc_continuous_handle_t *ret_handle)
+{
+    if (config == NULL || ret_handle == NULL || config->conv_frame_size == 0 ||
+        config->max_store_buf_size < config->conv_frame_size)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    adc_continuous_handle_t handle = calloc(1, sizeof(*handle));
+    if (handle == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    handle->frame_size = config->conv_frame_size;
+    handle->frames = config->max_store_buf_size / config->conv_frame_size;
+    handle->store = malloc(handle->frames * handle->frame_size);
+    if (handle->store == NULL)
+    {
+        free(handle);
+        return ESP_ERR_NO_MEM;
+    }
+    lastHandle = handle;
+    *ret_handle = handle;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_config(adc_continuous_handle_t handle, const adc_continuous_config_t *config)
+{
+    if (handle == NULL || config == NULL || config->pattern_num > SOC_ADC_PATT_LEN_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->config = *config;
+    memcpy(handle->pattern, config->adc_pattern, config->pattern_num * sizeof(adc_digi_pattern_config_t));
+    handle->config.adc_pattern = handle->pattern;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_register_event_callbacks(adc_continuous_handle_t handle, const adc_continuous_evt_cbs_t *cbs,
+                                                  void *user_data)
+{
+    if (handle == NULL || cbs == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->cbs = *cbs;
+    handle->user_data = user_data;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_start(adc_continuous_handle_t handle)
+{
+    if (handle == NULL || handle->started)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->started = true;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_stop(adc_continuous_handle_t handle)
+{
+    if (handle == NULL || !handle->started)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->started = false;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t handle, uint8_t *buf, uint32_t length_max,
+                              uint32_t *out_length, uint32_t timeout_ms)
+{
+    esp_err_t ret = ESP_ERR_TIMEOUT;
+    TickType_t start = xTaskGetTickCount();
+
+    /*Polls every tick until a frame is stored or the timeout expires*/
+    while (1)
+    {
+        vPortEnterCritical();
+        if (handle->read != handle->written)
+        {
+            uint32_t length = (length_max < handle->frame_size) ? length_max : handle->frame_size;
+            memcpy(buf, &handle->store[(handle->read % handle->frames) * handle->frame_size], length);
+            handle->read++;
+            *out_length = length;
+            ret = ESP_OK;
+        }
+        else
+        {
+            /*The late frames land right after this poll*/
+            handle->written += handle->unstored;
+            handle->unstored = 0;
+        }
+        vPortExitCritical();
+        if (ret == ESP_OK || xTaskGetTickCount() - start >= pdMS_TO_TICKS(timeout_ms))
+        {
+            return ret;
+        }
+        vTaskDelay(1);
+    }
+}
+
+esp_err_t adc_continuous_deinit(adc_continuous_handle_t handle)
+{
+    if (lastHandle == handle)
+    {
+        lastHandle = NULL;
+    }
+    free(handle->store);
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t fake_adc_continuous_complete(adc_continuous_handle_t handle, const uint8_t *frame)
+{
+    adc_continuous_evt_data_t event = { .size = handle->frame_size };
+    bool full = false;
+
+    if (!handle->started)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    vPortEnterCritical();
+    full = (handle->written + handle->unstored - handle->read == handle->frames);
+    if (!full)
+    {
+        event.conv_frame_buffer = &handle->store[((handle->written + handle->unstored) % handle->frames) * handle->frame_size];
+        memcpy(event.conv_frame_buffer, frame, handle->frame_size);
+        if (handle->late_store)
+        {
+            handle->unstored++;
+        }
+        else
+        {
+            handle->written++;
+        }
+    }
+    vPortExitCritical();
+
+    if (full)
+    {
+        if (handle->cbs.on_pool_ovf)
+        {
+            handle->cbs.on_pool_ovf(handle, &event, handle->user_data);
+        }
+        return ESP_ERR_NO_MEM;
+    }
+    if (handle->cbs.on_conv_done)
+    {
+        handle->cbs.on_conv_done(handle, &event, handle->user_data);
+    }
+    return ESP_OK;
+}
+
+void fake_adc_continuous_set_late_store(adc_continuous_handle_t handle, bool late)
+{
+    vPortEnterCritical();
+    handle->late_store = late;
+    handle->written += handle->unstored;
+    handle->unstored = 0;
+    vPortExitCritical();
+}
+
+const adc_continuous_config_t *fake_adc_continuous_config(adc_continuous_handle_t handle)
+{
+    return &handle->config;
+}
+
+uint32_t fake_adc_continuous_frame_size(adc_continuous_handle_t handle)
+{
+    return handle->frame_size;
+}
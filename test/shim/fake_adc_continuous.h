@@ -0,0 +1,26 @@
+/***************************************************************************
+*@brief Host shim: controls of the fake continuous ADC driver
+The test plays the DMA: every fake_adc_continuous_complete() stores one
+frame in the driver ring buffer and calls on_conv_done, or calls on_pool_ovf
+and drops the frame when the ring buffer is full, as the driver does. With a
+late store on_conv_done runs first, and the frame lands in the ring buffer
+right after the next read found it empty.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include "esp_adc/adc_continuous.h"
+
+/*Last handle created, the components keep theirs private*/
+adc_continuous_handle_t fake_adc_continuous_last(void);
+
+/*A frame of conv_frame_size bytes was completed by the DMA. ESP_ERR_INVALID_STATE
+  when the driver is not started, ESP_ERR_NO_MEM when the frame was dropped*/
+esp_err_t fake_adc_continuous_complete(adc_continuous_handle_t handle, const uint8_t *frame);
+
+/*on_conv_done is called before the frame is stored when 'late' is true*/
+void fake_adc_continuous_set_late_store(adc_continuous_handle_t handle, bool late);
+
+/*Configuration received by adc_continuous_config()*/
+const adc_continuous_config_t *fake_adc_continuous_config(adc_continuous_handle_t handle);
+uint32_t fake_adc_continuous_frame_size(adc_continuous_handle_t handle);
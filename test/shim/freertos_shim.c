@@ -0,0 +1,843 @@
+/***************************************************************************
+*@brief Host shim: FreeRTOS tasks, notifications, queues and timers on pthreads
+***************************************************************************/
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+
+struct tskTaskControlBlock {
+    pthread_t thread;
+    TaskFunction_t function;
+    void *arg;
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t priority;
+    UBaseType_t number;
+    uint32_t stack;
+
+    /*Notifications, guarded by 'lock'*/
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint32_t value[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+    bool received[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+
+    struct tskTaskControlBlock *next;   /*Every task alive*/
+};
+
+static pthread_mutex_t kernelLock;      /*Critical sections, recursive*/
+static pthread_mutex_t tasksLock = PTHREAD_MUTEX_INITIALIZER;
+static TaskHandle_t tasks = NULL;
+static UBaseType_t taskNumber = 0;
+static struct timespec epoch;           /*Tick 0 and esp_timer 0*/
+static __thread TaskHandle_t currentTask = NULL;
+
+__attribute__((constructor)) static void shim_start(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&kernelLock, &attr);
+    clock_gettime(CLOCK_MONOTONIC, &epoch);
+}
+
+/*********************
+*   TIME
+*********************/
+static int64_t elapsed_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - epoch.tv_sec) * 1000000 + (now.tv_nsec - epoch.tv_nsec) / 1000;
+}
+
+/*Absolute CLOCK_MONOTONIC time of the start of a tick*/
+static struct timespec tick_time(TickType_t tick)
+{
+    uint64_t ns = (uint64_t)epoch.tv_nsec + (uint64_t)tick * (1000000000ULL / configTICK_RATE_HZ);
+    struct timespec at = { .tv_sec = epoch.tv_sec + (time_t)(ns / 1000000000ULL), .tv_nsec = (long)(ns % 1000000000ULL) };
+
+    return at;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return elapsed_us();
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(elapsed_us() / 1000);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(elapsed_us() / (1000000 / configTICK_RATE_HZ));
+}
+
+static void sleep_until(TickType_t tick)
+{
+    struct timespec at = tick_time(tick);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, NULL) != 0)
+    {
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0)
+    {
+        sched_yield();
+        return;
+    }
+    sleep_until(xTaskGetTickCount() + ticks);
+}
+
+/*Same rules as FreeRTOS, including the wrap around of the tick count*/
+BaseType_t xTaskDelayUntil(TickType_t *previous, TickType_t increment)
+{
+    TickType_t now = xTaskGetTickCount();
+    TickType_t wake = *previous + increment;
+    BaseType_t delay = pdFALSE;
+
+    if (now < *previous)
+    {
+        delay = (wake < *previous && wake > now) ? pdTRUE : pdFALSE;
+    }
+    else
+    {
+        delay = (wake < *previous || wake > now) ? pdTRUE : pdFALSE;
+    }
+    *previous = wake;
+    if (delay)
+    {
+        sleep_until(wake);
+    }
+    return delay;
+}
+
+void vTaskSetTimeOutState(TimeOut_t *timeout)
+{
+    timeout->xTimeOnEntering = xTaskGetTickCount();
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *ticks)
+{
+    TickType_t now = xTaskGetTickCount();
+    TickType_t elapsed = now - timeout->xTimeOnEntering;
+
+    if (*ticks == portMAX_DELAY)
+    {
+        return pdFALSE;
+    }
+    if (elapsed < *ticks)
+    {
+        *ticks -= elapsed;
+        timeout->xTimeOnEntering = now;
+        return pdFALSE;
+    }
+    *ticks = 0;
+    return pdTRUE;
+}
+
+/*********************
+*   CRITICAL SECTIONS
+*********************/
+void vPortEnterCritical(void)
+{
+    pthread_mutex_lock(&kernelLock);
+}
+
+void vPortExitCritical(void)
+{
+    pthread_mutex_unlock(&kernelLock);
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return 0;
+}
+
+/*********************
+*   TASKS
+*********************/
+static TaskHandle_t new_task(const char *name, TaskFunction_t function, void *arg, UBaseType_t priority,
+                             uint32_t stack)
+{
+    TaskHandle_t task = calloc(1, sizeof(*task));
+
+    if (task == NULL)
+    {
+        return NULL;
+    }
+    strncpy(task->name, name ? name : "", configMAX_TASK_NAME_LEN - 1);
+    task->function = function;
+    task->arg = arg;
+    task->priority = priority;
+    task->stack = stack;
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&task->changed, &attr);
+
+    pthread_mutex_lock(&tasksLock);
+    task->number = ++taskNumber;
+    task->next = tasks;
+    tasks = task;
+    pthread_mutex_unlock(&tasksLock);
+    return task;
+}
+
+static void forget_task(TaskHandle_t task)
+{
+    pthread_mutex_lock(&tasksLock);
+    for (TaskHandle_t *p = &tasks; *p; p = &(*p)->next)
+    {
+        if (*p == task)
+        {
+            *p = task->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&tasksLock);
+}
+
+/*Threads that were not created by xTaskCreate (main) become tasks on first use*/
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (currentTask == NULL)
+    {
+        currentTask = new_task("main", NULL, NULL, 1, 0);
+        currentTask->thread = pthread_self();
+    }
+    return currentTask;
+}
+
+static void *task_thread(void *arg)
+{
+    TaskHandle_t task = (TaskHandle_t)arg;
+
+    currentTask = task;
+    task->function(task->arg);
+    vTaskDelete(NULL);      /*FreeRTOS tasks must not return, the shim tolerates it*/
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    TaskHandle_t task = new_task(name, function, arg, priority, stack);
+
+    if (task == NULL)
+    {
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+    /*As in FreeRTOS, the handle is stored before the task can run*/
+    if (handle)
+    {
+        *handle = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_thread, task) != 0)
+    {
+        forget_task(task);
+        free(task);
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+/*The control block is not freed: a task may still be notified after its deletion*/
+void vTaskDelete(TaskHandle_t task)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    task = task ? task : self;
+    forget_task(task);
+    if (task == self)
+    {
+        pthread_exit(NULL);
+    }
+    pthread_cancel(task->thread);
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    return (task ? task : xTaskGetCurrentTaskHandle())->priority;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority)
+{
+    (task ? task : xTaskGetCurrentTaskHandle())->priority = priority;
+}
+
+char *pcTaskGetName(TaskHandle_t task)
+{
+    return (task ? task : xTaskGetCurrentTaskHandle())->name;
+}
+
+/*********************
+*   NOTIFICATIONS
+*********************/
+BaseType_t xTaskGenericNotify(TaskHandle_t task, UBaseType_t index, uint32_t value, eNotifyAction action,
+                              uint32_t *previous)
+{
+    BaseType_t ret = pdPASS;
+
+    configASSERT(task && index < configTASK_NOTIFICATION_ARRAY_ENTRIES);
+    pthread_mutex_lock(&task->lock);
+    if (previous)
+    {
+        *previous = task->value[index];
+    }
+    switch (action)
+    {
+    case eSetBits:
+        task->value[index] |= value;
+        break;
+    case eIncrement:
+        task->value[index]++;
+        break;
+    case eSetValueWithOverwrite:
+        task->value[index] = value;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (task->received[index])
+        {
+            ret = pdFAIL;
+        }
+        else
+        {
+            task->value[index] = value;
+        }
+        break;
+    default:
+        break;
+    }
+    task->received[index] = true;
+    pthread_cond_broadcast(&task->changed);
+    pthread_mutex_unlock(&task->lock);
+    return ret;
+}
+
+static void unlock_on_cancel(void *arg)
+{
+    pthread_mutex_unlock((pthread_mutex_t *)arg);
+}
+
+/*Waits with the lock of a task or a queue taken until 'ready' is true or the ticks elapse*/
+#define WAIT_WHILE(task, ready, ticks)                                                       \
+    do {                                                                                     \
+        struct timespec waitEnd = tick_time(xTaskGetTickCount() + (ticks));                  \
+        pthread_cleanup_push(unlock_on_cancel, &(task)->lock);                               \
+        while (!(ready) && (ticks) != 0)                                                     \
+        {                                                                                    \
+            if ((ticks) == portMAX_DELAY)                                                    \
+            {                                                                                \
+                pthread_cond_wait(&(task)->changed, &(task)->lock);                          \
+            }                                                                                \
+            else if (pthread_cond_timedwait(&(task)->changed, &(task)->lock, &waitEnd) != 0) \
+            {                                                                                \
+                break;                                                                       \
+            }                                                                                \
+        }                                                                                    \
+        pthread_cleanup_pop(0);                                                              \
+    } while (0)
+
+uint32_t ulTaskGenericNotifyTake(UBaseType_t index, BaseType_t clear, TickType_t ticks)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t value = 0;
+
+    configASSERT(index < configTASK_NOTIFICATION_ARRAY_ENTRIES);
+    pthread_mutex_lock(&self->lock);
+    WAIT_WHILE(self, self->value[index] != 0, ticks);
+    value = self->value[index];
+    if (value != 0)
+    {
+        self->value[index] = clear ? 0 : value - 1;
+    }
+    self->received[index] = false;
+    pthread_mutex_unlock(&self->lock);
+    return value;
+}
+
+BaseType_t xTaskGenericNotifyWait(UBaseType_t index, uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *value,
+                                  TickType_t ticks)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    BaseType_t received = pdFALSE;
+
+    configASSERT(index < configTASK_NOTIFICATION_ARRAY_ENTRIES);
+    pthread_mutex_lock(&self->lock);
+    if (!self->received[index])
+    {
+        self->value[index] &= ~clearOnEntry;
+    }
+    WAIT_WHILE(self, self->received[index], ticks);
+    if (value)
+    {
+        *value = self->value[index];
+    }
+    if (self->received[index])
+    {
+        self->value[index] &= ~clearOnExit;
+        received = pdTRUE;
+    }
+    self->received[index] = false;
+    pthread_mutex_unlock(&self->lock);
+    return received;
+}
+
+BaseType_t xTaskGenericNotifyStateClear(TaskHandle_t task, UBaseType_t index)
+{
+    BaseType_t was = pdFALSE;
+
+    task = task ? task : xTaskGetCurrentTaskHandle();
+    pthread_mutex_lock(&task->lock);
+    was = task->received[index] ? pdTRUE : pdFALSE;
+    task->received[index] = false;
+    pthread_mutex_unlock(&task->lock);
+    return was;
+}
+
+uint32_t ulTaskGenericNotifyValueClear(TaskHandle_t task, UBaseType_t index, uint32_t bits)
+{
+    uint32_t value = 0;
+
+    task = task ? task : xTaskGetCurrentTaskHandle();
+    pthread_mutex_lock(&task->lock);
+    value = task->value[index];
+    task->value[index] &= ~bits;
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+/*********************
+*   QUEUES
+*********************/
+struct QueueDefinition {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;         /*An item was added or removed*/
+    uint8_t *items;                 /*NULL for semaphores*/
+    UBaseType_t itemSize;
+    UBaseType_t length;
+    UBaseType_t first;              /*Index of the oldest item*/
+    UBaseType_t count;
+    bool mutex;
+    TaskHandle_t holder;            /*Task that took the mutex*/
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+
+    if (queue == NULL || length == 0)
+    {
+        free(queue);
+        return NULL;
+    }
+    if (itemSize > 0 && (queue->items = malloc(length * itemSize)) == NULL)
+    {
+        free(queue);
+        return NULL;
+    }
+    queue->itemSize = itemSize;
+    queue->length = length;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&queue->changed, &attr);
+    return queue;
+}
+
+QueueHandle_t xQueueCreateCountingSemaphore(UBaseType_t max, UBaseType_t initial)
+{
+    QueueHandle_t semaphore = xQueueCreate(max, 0);
+
+    if (semaphore)
+    {
+        semaphore->count = initial;
+    }
+    return semaphore;
+}
+
+/*Created given, as in FreeRTOS*/
+QueueHandle_t xQueueCreateMutex(void)
+{
+    QueueHandle_t mutex = xQueueCreateCountingSemaphore(1, 1);
+
+    if (mutex)
+    {
+        mutex->mutex = true;
+    }
+    return mutex;
+}
+
+TaskHandle_t xQueueGetMutexHolder(QueueHandle_t mutex)
+{
+    pthread_mutex_lock(&mutex->lock);
+    TaskHandle_t holder = mutex->holder;
+    pthread_mutex_unlock(&mutex->lock);
+    return holder;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->changed);
+    free(queue->items);
+    free(queue);
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void *item, TickType_t ticks, BaseType_t position)
+{
+    BaseType_t sent = pdFAIL;
+
+    pthread_mutex_lock(&queue->lock);
+    if (position != queueOVERWRITE)
+    {
+        WAIT_WHILE(queue, queue->count < queue->length, ticks);
+    }
+    if (queue->count < queue->length || position == queueOVERWRITE)
+    {
+        UBaseType_t slot = 0;
+
+        if (position == queueOVERWRITE && queue->count == queue->length)
+        {
+            slot = (queue->first + queue->count - 1) % queue->length;   /*Queue of one: its only item*/
+        }
+        else if (position == queueSEND_TO_FRONT)
+        {
+            queue->first = (queue->first + queue->length - 1) % queue->length;
+            slot = queue->first;
+            queue->count++;
+        }
+        else
+        {
+            slot = (queue->first + queue->count) % queue->length;
+            queue->count++;
+        }
+        if (queue->items)
+        {
+            memcpy(queue->items + slot * queue->itemSize, item, queue->itemSize);
+        }
+        queue->holder = NULL;
+        sent = pdPASS;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return sent;
+}
+
+static BaseType_t queue_read(QueueHandle_t queue, void *item, TickType_t ticks, bool remove)
+{
+    BaseType_t received = pdFALSE;
+
+    pthread_mutex_lock(&queue->lock);
+    WAIT_WHILE(queue, queue->count > 0, ticks);
+    if (queue->count > 0)
+    {
+        if (queue->items && item)
+        {
+            memcpy(item, queue->items + queue->first * queue->itemSize, queue->itemSize);
+        }
+        if (remove)
+        {
+            queue->first = (queue->first + 1) % queue->length;
+            queue->count--;
+            queue->holder = queue->mutex ? xTaskGetCurrentTaskHandle() : NULL;
+            pthread_cond_broadcast(&queue->changed);
+        }
+        received = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return received;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    return queue_read(queue, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    return queue_read(queue, item, ticks, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t spaces = queue->length - queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return spaces;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->first = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+/*********************
+*   TIMERS
+*********************/
+struct tmrTimerControl {
+    TickType_t period;
+    bool autoReload;
+    void *id;
+    TimerCallbackFunction_t callback;
+    bool active;
+    TickType_t expiry;
+    struct tmrTimerControl *next;   /*Every timer not deleted*/
+};
+
+static pthread_mutex_t timersLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timersChanged;
+static TimerHandle_t timers = NULL;
+static TaskHandle_t timerDaemon = NULL;
+
+static TimerHandle_t earliest_timer(void)
+{
+    TimerHandle_t first = NULL;
+
+    for (TimerHandle_t t = timers; t; t = t->next)
+    {
+        if (t->active && (first == NULL || (int32_t)(t->expiry - first->expiry) < 0))
+        {
+            first = t;
+        }
+    }
+    return first;
+}
+
+/*Calls the callbacks of the expired timers, one at a time and without the lock*/
+static void timer_daemon(void *arg)
+{
+    pthread_mutex_lock(&timersLock);
+    pthread_cleanup_push(unlock_on_cancel, &timersLock);
+    while (1)
+    {
+        TimerHandle_t timer = earliest_timer();
+        if (timer == NULL)
+        {
+            pthread_cond_wait(&timersChanged, &timersLock);
+            continue;
+        }
+        if ((int32_t)(timer->expiry - xTaskGetTickCount()) > 0)
+        {
+            struct timespec at = tick_time(timer->expiry);
+            pthread_cond_timedwait(&timersChanged, &timersLock, &at);
+            continue;
+        }
+
+        /*Auto reload timers keep their period from the expiry, not from now*/
+        timer->active = timer->autoReload;
+        timer->expiry += timer->period;
+        pthread_mutex_unlock(&timersLock);
+        timer->callback(timer);
+        pthread_mutex_lock(&timersLock);
+    }
+    pthread_cleanup_pop(1);
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t autoReload, void *id,
+                           TimerCallbackFunction_t callback)
+{
+    TimerHandle_t timer = calloc(1, sizeof(*timer));
+
+    if (timer == NULL || period == 0)
+    {
+        free(timer);
+        return NULL;
+    }
+    timer->period = period;
+    timer->autoReload = autoReload != pdFALSE;
+    timer->id = id;
+    timer->callback = callback;
+
+    pthread_mutex_lock(&timersLock);
+    if (timerDaemon == NULL)
+    {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&timersChanged, &attr);
+        xTaskCreate(timer_daemon, "Tmr Svc", 1024*2, NULL, configMAX_PRIORITIES - 1, &timerDaemon);
+    }
+    timer->next = timers;
+    timers = timer;
+    pthread_mutex_unlock(&timersLock);
+    return timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks)
+{
+    pthread_mutex_lock(&timersLock);
+    timer->active = true;
+    timer->expiry = xTaskGetTickCount() + timer->period;
+    pthread_cond_broadcast(&timersChanged);
+    pthread_mutex_unlock(&timersLock);
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks)
+{
+    pthread_mutex_lock(&timersLock);
+    timer->active = false;
+    pthread_cond_broadcast(&timersChanged);
+    pthread_mutex_unlock(&timersLock);
+    return pdPASS;
+}
+
+/*The timer is not freed: its callback may still be running in the daemon*/
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks)
+{
+    pthread_mutex_lock(&timersLock);
+    for (TimerHandle_t *p = &timers; *p; p = &(*p)->next)
+    {
+        if (*p == timer)
+        {
+            *p = timer->next;
+            break;
+        }
+    }
+    timer->active = false;
+    pthread_cond_broadcast(&timersChanged);
+    pthread_mutex_unlock(&timersLock);
+    return pdPASS;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer)
+{
+    return timer->id;
+}
+
+/*********************
+*   RUN TIME STATS
+*********************/
+uint32_t shim_run_time_counter(void)
+{
+    return (uint32_t)elapsed_us();
+}
+
+/*CPU time of the thread of a task, in run time counts (us)*/
+static uint32_t task_run_time(TaskHandle_t task)
+{
+    clockid_t clock;
+    struct timespec used;
+
+    if (pthread_getcpuclockid(task->thread, &clock) != 0 || clock_gettime(clock, &used) != 0)
+    {
+        return 0;
+    }
+    return (uint32_t)((int64_t)used.tv_sec * 1000000 + used.tv_nsec / 1000);
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    UBaseType_t count = 0;
+
+    xTaskGetCurrentTaskHandle();
+    pthread_mutex_lock(&tasksLock);
+    for (TaskHandle_t t = tasks; t; t = t->next)
+    {
+        count++;
+    }
+    pthread_mutex_unlock(&tasksLock);
+    return count;
+}
+
+/*As in FreeRTOS, nothing is written when the tasks do not fit*/
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size, configRUN_TIME_COUNTER_TYPE *total)
+{
+    UBaseType_t count = 0;
+
+    xTaskGetCurrentTaskHandle();
+    pthread_mutex_lock(&tasksLock);
+    for (TaskHandle_t t = tasks; t; t = t->next)
+    {
+        count++;
+    }
+    if (count > size)
+    {
+        pthread_mutex_unlock(&tasksLock);
+        return 0;
+    }
+    count = 0;
+    for (TaskHandle_t t = tasks; t; t = t->next, count++)
+    {
+        status[count] = (TaskStatus_t) {
+            .xHandle = t,
+            .pcTaskName = t->name,
+            .xTaskNumber = t->number,
+            .eCurrentState = (t == currentTask) ? eRunning : eReady,
+            .uxCurrentPriority = t->priority,
+            .uxBasePriority = t->priority,
+            .ulRunTimeCounter = task_run_time(t),
+            .usStackHighWaterMark = (configSTACK_DEPTH_TYPE)t->stack,
+            .xCoreID = tskNO_AFFINITY,
+        };
+    }
+    pthread_mutex_unlock(&tasksLock);
+    if (total)
+    {
+        *total = shim_run_time_counter();
+    }
+    return count;
+}
+
+/*********************
+*   ESP-IDF
+*********************/
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
@@ -0,0 +1,12 @@
+/***************************************************************************
+*@brief Host shim: esp_adc/adc_cali.h
+The schemes are implemented by the tests that need them.
+***************************************************************************/
+#pragma once
+
+#include "esp_err.h"
+#include "hal/adc_types.h"
+
+typedef struct adc_cali_scheme_t *adc_cali_handle_t;
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage);
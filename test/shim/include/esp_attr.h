@@ -0,0 +1,7 @@
+/***************************************************************************
+*@brief Host shim: esp_attr.h, there is no IRAM on the host
+***************************************************************************/
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
@@ -0,0 +1,35 @@
+/***************************************************************************
+*@brief Host shim: esp_log.h
+Lines are printed on stdout with the format of ESP_LOGx, without colors.
+***************************************************************************/
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+#define LOG_COLOR_E     ""
+#define LOG_COLOR_W     ""
+#define LOG_COLOR_I     ""
+#define LOG_COLOR_D     ""
+#define LOG_COLOR_V     ""
+#define LOG_RESET_COLOR ""
+
+uint32_t esp_log_timestamp(void);
+
+#define ESP_LOG_LEVEL(level, tag, format, ...) \
+    printf("%c (%lu) %s: " format "\n", "NEWIDV"[level], (unsigned long)esp_log_timestamp(), tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...)  ESP_LOG_LEVEL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  ESP_LOG_LEVEL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  ESP_LOG_LEVEL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)  do { } while (0)
+#define ESP_LOGV(tag, format, ...)  do { } while (0)
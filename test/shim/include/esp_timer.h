@@ -0,0 +1,8 @@
+/***************************************************************************
+*@brief Host shim: esp_timer.h, microseconds since the shim started
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,70 @@
+/***************************************************************************
+*@brief Host shim: the part of the FreeRTOS API used by the components
+Tasks are pthreads and ticks are milliseconds of CLOCK_MONOTONIC. The
+scheduler is the one of the host: priorities and cores are only stored, so
+the tests must not rely on them. Critical sections take one recursive mutex
+shared by every portMUX_TYPE, they must not block.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include "sdkconfig.h"
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE         ((BaseType_t)0)
+#define pdTRUE          ((BaseType_t)1)
+#define pdFAIL          pdFALSE
+#define pdPASS          pdTRUE
+#define errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY   (-1)
+
+#define portMAX_DELAY               ((TickType_t)0xFFFFFFFFUL)
+#define configTICK_RATE_HZ          1000
+#define portTICK_PERIOD_MS          ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define portNUM_PROCESSORS          2
+#define tskNO_AFFINITY              ((BaseType_t)0x7FFFFFFF)
+#define tskIDLE_PRIORITY            ((UBaseType_t)0)
+#define configMAX_PRIORITIES        25
+#define configMAX_TASK_NAME_LEN     16
+#define configMINIMAL_STACK_SIZE    768
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES
+#define configASSERT(x)             assert(x)
+
+/*Run time stats: the counter is in microseconds, the run time of a task is
+  the CPU time of its thread*/
+#define configUSE_TRACE_FACILITY            1
+#define configGENERATE_RUN_TIME_STATS       1
+#define configRUN_TIME_COUNTER_TYPE         uint32_t
+#define configSTACK_DEPTH_TYPE              uint32_t
+#define portGET_RUN_TIME_COUNTER_VALUE()    shim_run_time_counter()
+
+uint32_t shim_run_time_counter(void);
+
+/*Critical sections*/
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0, 0 }
+#define portMUX_INITIALIZE(mux)         do { (mux)->owner = 0; (mux)->count = 0; } while (0)
+
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+
+#define portENTER_CRITICAL(mux)         vPortEnterCritical()
+#define portEXIT_CRITICAL(mux)          vPortExitCritical()
+#define portENTER_CRITICAL_ISR(mux)     vPortEnterCritical()
+#define portEXIT_CRITICAL_ISR(mux)      vPortExitCritical()
+#define taskENTER_CRITICAL(mux)         vPortEnterCritical()
+#define taskEXIT_CRITICAL(mux)          vPortExitCritical()
+
+#define portYIELD_FROM_ISR(woken)       ((void)(woken))
+
+BaseType_t xPortGetCoreID(void);
@@ -0,0 +1,43 @@
+/***************************************************************************
+*@brief Host shim: queues
+Items are copied as in FreeRTOS. The static variants allocate their own
+memory, the buffers given are not used.
+***************************************************************************/
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+typedef struct {
+    void *dummy;
+} StaticQueue_t;
+
+#define queueSEND_TO_BACK   ((BaseType_t)0)
+#define queueSEND_TO_FRONT  ((BaseType_t)1)
+#define queueOVERWRITE      ((BaseType_t)2)
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+#define xQueueCreateStatic(length, itemSize, storage, buffer)   xQueueCreate(length, itemSize)
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void *item, TickType_t ticks, BaseType_t position);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+BaseType_t xQueueReset(QueueHandle_t queue);
+
+#define xQueueSend(queue, item, ticks)          xQueueGenericSend(queue, item, ticks, queueSEND_TO_BACK)
+#define xQueueSendToBack(queue, item, ticks)    xQueueGenericSend(queue, item, ticks, queueSEND_TO_BACK)
+#define xQueueSendToFront(queue, item, ticks)   xQueueGenericSend(queue, item, ticks, queueSEND_TO_FRONT)
+#define xQueueOverwrite(queue, item)            xQueueGenericSend(queue, item, 0, queueOVERWRITE)
+
+#define xQueueSendFromISR(queue, item, woken) \
+    (shim_no_task_woken(woken), xQueueGenericSend(queue, item, 0, queueSEND_TO_BACK))
+#define xQueueSendToBackFromISR(queue, item, woken) \
+    (shim_no_task_woken(woken), xQueueGenericSend(queue, item, 0, queueSEND_TO_BACK))
+#define xQueueOverwriteFromISR(queue, item, woken) \
+    (shim_no_task_woken(woken), xQueueGenericSend(queue, item, 0, queueOVERWRITE))
+#define xQueueReceiveFromISR(queue, item, woken) \
+    (shim_no_task_woken(woken), xQueueReceive(queue, item, 0))
@@ -0,0 +1,29 @@
+/***************************************************************************
+*@brief Host shim: semaphores and mutexes, queues of items without data
+A mutex remembers its holder but has no priority inheritance.
+***************************************************************************/
+#pragma once
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+typedef StaticQueue_t StaticSemaphore_t;
+
+QueueHandle_t xQueueCreateCountingSemaphore(UBaseType_t max, UBaseType_t initial);
+QueueHandle_t xQueueCreateMutex(void);
+TaskHandle_t xQueueGetMutexHolder(QueueHandle_t mutex);
+
+#define xSemaphoreCreateBinary()                        xQueueCreateCountingSemaphore(1, 0)
+#define xSemaphoreCreateBinaryStatic(buffer)            xQueueCreateCountingSemaphore(1, 0)
+#define xSemaphoreCreateCounting(max, initial)          xQueueCreateCountingSemaphore(max, initial)
+#define xSemaphoreCreateMutex()                         xQueueCreateMutex()
+#define xSemaphoreCreateMutexStatic(buffer)             xQueueCreateMutex()
+#define xSemaphoreGetMutexHolder(mutex)                 xQueueGetMutexHolder(mutex)
+#define vSemaphoreDelete(semaphore)                     vQueueDelete(semaphore)
+#define xSemaphoreTake(semaphore, ticks)                xQueueReceive(semaphore, NULL, ticks)
+#define xSemaphoreGive(semaphore)                       xQueueGenericSend(semaphore, NULL, 0, queueSEND_TO_BACK)
+#define uxSemaphoreGetCount(semaphore)                  uxQueueMessagesWaiting(semaphore)
+#define xSemaphoreGiveFromISR(semaphore, woken) \
+    (shim_no_task_woken(woken), xQueueGenericSend(semaphore, NULL, 0, queueSEND_TO_BACK))
+#define xSemaphoreTakeFromISR(semaphore, woken) \
+    (shim_no_task_woken(woken), xQueueReceive(semaphore, NULL, 0))
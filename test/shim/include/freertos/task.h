@@ -0,0 +1,118 @@
+/***************************************************************************
+*@brief Host shim: tasks, delays, task notifications and run time stats
+***************************************************************************/
+#pragma once
+
+#include <sched.h>
+#include "freertos/FreeRTOS.h"
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum {
+    eNoAction,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+typedef struct {
+    TickType_t xTimeOnEntering;
+} TimeOut_t;
+
+typedef enum {
+    eRunning,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid,
+} eTaskState;
+
+/*The stack is not measured: usStackHighWaterMark is the size given at creation*/
+typedef struct {
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    configRUN_TIME_COUNTER_TYPE ulRunTimeCounter;
+    StackType_t *pxStackBase;
+    configSTACK_DEPTH_TYPE usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+/*********************
+*   TASKS
+*********************/
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+#define xTaskCreate(function, name, stack, arg, priority, handle) \
+    xTaskCreatePinnedToCore(function, name, stack, arg, priority, handle, tskNO_AFFINITY)
+
+/*Deleting another task cancels its thread, at its next wait*/
+void vTaskDelete(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
+char *pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size, configRUN_TIME_COUNTER_TYPE *total);
+
+/*********************
+*   TIME
+*********************/
+TickType_t xTaskGetTickCount(void);
+#define xTaskGetTickCountFromISR()  xTaskGetTickCount()
+void vTaskDelay(TickType_t ticks);
+BaseType_t xTaskDelayUntil(TickType_t *previous, TickType_t increment);
+#define vTaskDelayUntil(previous, increment)    ((void)xTaskDelayUntil(previous, increment))
+void vTaskSetTimeOutState(TimeOut_t *timeout);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *ticks);
+#define taskYIELD()                 sched_yield()
+
+/*********************
+*   NOTIFICATIONS
+*********************/
+BaseType_t xTaskGenericNotify(TaskHandle_t task, UBaseType_t index, uint32_t value, eNotifyAction action,
+                              uint32_t *previous);
+BaseType_t xTaskGenericNotifyWait(UBaseType_t index, uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *value,
+                                  TickType_t ticks);
+uint32_t ulTaskGenericNotifyTake(UBaseType_t index, BaseType_t clear, TickType_t ticks);
+BaseType_t xTaskGenericNotifyStateClear(TaskHandle_t task, UBaseType_t index);
+uint32_t ulTaskGenericNotifyValueClear(TaskHandle_t task, UBaseType_t index, uint32_t bits);
+
+#define xTaskNotifyIndexed(task, index, value, action)  xTaskGenericNotify(task, index, value, action, NULL)
+#define xTaskNotify(task, value, action)                xTaskGenericNotify(task, 0, value, action, NULL)
+#define xTaskNotifyGiveIndexed(task, index)             xTaskGenericNotify(task, index, 0, eIncrement, NULL)
+#define xTaskNotifyGive(task)                           xTaskGenericNotify(task, 0, 0, eIncrement, NULL)
+#define xTaskNotifyWaitIndexed(index, entry, exit, value, ticks) \
+    xTaskGenericNotifyWait(index, entry, exit, value, ticks)
+#define xTaskNotifyWait(entry, exit, value, ticks)      xTaskGenericNotifyWait(0, entry, exit, value, ticks)
+#define ulTaskNotifyTakeIndexed(index, clear, ticks)    ulTaskGenericNotifyTake(index, clear, ticks)
+#define ulTaskNotifyTake(clear, ticks)                  ulTaskGenericNotifyTake(0, clear, ticks)
+#define xTaskNotifyStateClearIndexed(task, index)       xTaskGenericNotifyStateClear(task, index)
+#define xTaskNotifyStateClear(task)                     xTaskGenericNotifyStateClear(task, 0)
+#define ulTaskNotifyValueClearIndexed(task, index, bits) ulTaskGenericNotifyValueClear(task, index, bits)
+#define ulTaskNotifyValueClear(task, bits)              ulTaskGenericNotifyValueClear(task, 0, bits)
+
+/*From an ISR: the host has no ISRs, the callers run in a thread and never wake a higher priority task*/
+static inline BaseType_t shim_no_task_woken(BaseType_t *woken)
+{
+    if (woken)
+    {
+        *woken = pdFALSE;
+    }
+    return pdFALSE;
+}
+
+#define xTaskNotifyFromISR(task, value, action, woken) \
+    (shim_no_task_woken(woken), xTaskGenericNotify(task, 0, value, action, NULL))
+#define xTaskNotifyIndexedFromISR(task, index, value, action, woken) \
+    (shim_no_task_woken(woken), xTaskGenericNotify(task, index, value, action, NULL))
+#define vTaskNotifyGiveFromISR(task, woken) \
+    ((void)shim_no_task_woken(woken), (void)xTaskGenericNotify(task, 0, 0, eIncrement, NULL))
+#define vTaskNotifyGiveIndexedFromISR(task, index, woken) \
+    ((void)shim_no_task_woken(woken), (void)xTaskGenericNotify(task, index, 0, eIncrement, NULL))
@@ -0,0 +1,12 @@
+/***************************************************************************
+*@brief Host shim: project configuration of the host tests
+The options the tested components read, with the values of the projects.
+***************************************************************************/
+#pragma once
+
+#define CONFIG_IDF_TARGET_ESP32                         1
+#define CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES 2
+#define CONFIG_SPSC_RING_NOTIFY_INDEX                   1
+#define CONFIG_RESOURCE_SERVER_NOTIFY_INDEX             0
+#define CONFIG_FAIR_LOCK_NOTIFY_INDEX                   0
+#define CONFIG_FAIR_LOCK_MAX_WAITERS                    8
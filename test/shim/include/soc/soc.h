@@ -0,0 +1,12 @@
+/***************************************************************************
+*@brief Host shim: soc/soc.h
+The register writes go to fake_reg_write(), implemented by the tests that
+need them.
+***************************************************************************/
+#pragma once
+
+#include <stdint.h>
+
+void fake_reg_write(uint32_t reg, uint32_t value);
+
+#define REG_WRITE(_r, _v)   fake_reg_write((uint32_t)(_r), (uint32_t)(_v))
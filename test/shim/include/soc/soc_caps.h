@@ -0,0 +1,13 @@
+/***************************************************************************
+*@brief Host shim: soc/soc_caps.h of the ESP32 (ADC and GPIO)
+***************************************************************************/
+#pragma once
+
+#define SOC_ADC_PATT_LEN_MAX                16
+#define SOC_ADC_DIGI_RESULT_BYTES           2
+#define SOC_ADC_DIGI_DATA_BYTES_PER_CONV    4
+#define SOC_ADC_DIGI_MAX_BITWIDTH           12
+
+#define SOC_GPIO_PIN_COUNT                  40
+#define SOC_GPIO_VALID_GPIO_MASK            (0xFFFFFFFFFFULL & ~((1ULL << 24) | (0xFULL << 28)))
+#define SOC_GPIO_VALID_OUTPUT_GPIO_MASK     (SOC_GPIO_VALID_GPIO_MASK & ~(0x3FULL << 34))
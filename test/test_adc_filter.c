@@ -0,0 +1,268 @@
+/***************************************************************************
+*@brief Host test of adc_filter
+Synthetic noisy signals go through every filter and the outputs are compared
+with plain reference implementations (sorted window, full sum) or checked
+for their expected effect: spikes removed, noise reduced, steps followed.
+The cost per sample of every filter is printed, it is not checked: host
+nanoseconds say little about the cycles on the ESP32.
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "adc_filter.h"
+#include "test_check.h"
+
+#define SIGNAL_LEN      4096
+#define NOISE           8       /*Noise amplitude in raw counts, +-*/
+#define SPIKE_EVERY     97      /*Samples between isolated spikes*/
+#define BENCH_SAMPLES   (1 << 20)
+
+static uint16_t clean[SIGNAL_LEN];
+static uint16_t noisy[SIGNAL_LEN];
+static uint16_t out[SIGNAL_LEN];
+
+static uint32_t random_next(void)
+{
+    static uint32_t state = 27;
+
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+/*Slow ramp over the whole range, plus noise and isolated spikes to 0 or full scale*/
+static void make_signals(void)
+{
+    for (uint32_t i = 0; i < SIGNAL_LEN; i++)
+    {
+        int32_t value = (int32_t)(i * 4095 / (SIGNAL_LEN - 1));
+        int32_t noise = (int32_t)(random_next() % (2 * NOISE + 1)) - NOISE;
+
+        clean[i] = (uint16_t)value;
+        value += noise;
+        value = value < 0 ? 0 : (value > 4095 ? 4095 : value);
+        noisy[i] = (i % SPIKE_EVERY == SPIKE_EVERY / 2) ? (value < 2048 ? 4095 : 0) : (uint16_t)value;
+    }
+}
+
+static int compare(const void *a, const void *b)
+{
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+static uint32_t mean_error(const uint16_t *a, const uint16_t *b, uint32_t from, uint32_t to)
+{
+    uint64_t total = 0;
+
+    for (uint32_t i = from; i < to; i++)
+    {
+        total += (a[i] > b[i]) ? a[i] - b[i] : b[i] - a[i];
+    }
+    return (uint32_t)(total / (to - from));
+}
+
+/*********************
+*   TESTS
+*********************/
+static void test_median(void)
+{
+    adc_filter_median_t median;
+    uint16_t window[ADC_FILTER_MEDIAN_MAX];
+
+    /*Same output as sorting the last 'len' samples, with the window still filling too*/
+    for (uint8_t len = 1; len <= ADC_FILTER_MEDIAN_MAX; len += 2)
+    {
+        uint32_t mismatches = 0;
+
+        adc_filter_median_init(&median, len);
+        for (uint32_t i = 0; i < SIGNAL_LEN; i++)
+        {
+            uint32_t count = (i + 1 < len) ? i + 1 : len;
+            memcpy(window, &noisy[i + 1 - count], count * sizeof(uint16_t));
+            qsort(window, count, sizeof(uint16_t), compare);
+            mismatches += (adc_filter_median_step(&median, noisy[i]) != window[count / 2]);
+        }
+        TEST_CHECK_EQUAL(mismatches, 0);
+    }
+
+    /*Isolated spikes never reach the output of a 5 samples window, which
+      lags the ramp by 2 samples (2 counts)*/
+    uint32_t spikes = 0;
+    adc_filter_median_init(&median, 5);
+    adc_filter_median_process(&median, noisy, out, SIGNAL_LEN);
+    for (uint32_t i = 5; i < SIGNAL_LEN; i++)
+    {
+        spikes += (out[i] > clean[i] + NOISE + 2 || out[i] + NOISE + 2 < clean[i]);
+    }
+    TEST_CHECK_EQUAL(spikes, 0);
+}
+
+static void test_moving_average(void)
+{
+    adc_filter_ma_t ma;
+
+    for (uint8_t len = 1; len <= ADC_FILTER_MA_MAX; len *= 2)
+    {
+        uint32_t mismatches = 0;
+
+        adc_filter_ma_init(&ma, len);
+        for (uint32_t i = 0; i < SIGNAL_LEN; i++)
+        {
+            uint32_t count = (i + 1 < len) ? i + 1 : len;
+            uint32_t sum = 0;
+            for (uint32_t j = i + 1 - count; j <= i; j++)
+            {
+                sum += noisy[j];
+            }
+            mismatches += (adc_filter_ma_step(&ma, noisy[i]) != sum / count);
+        }
+        TEST_CHECK_EQUAL(mismatches, 0);
+    }
+
+    /*In place, after the median: the noise left is well under the input noise*/
+    adc_filter_median_t median;
+    adc_filter_median_init(&median, 5);
+    adc_filter_ma_init(&ma, 16);
+    adc_filter_median_process(&median, noisy, out, SIGNAL_LEN);
+    adc_filter_ma_process(&ma, out, out, SIGNAL_LEN);
+    TEST_CHECK(mean_error(out, clean, 64, SIGNAL_LEN) < NOISE / 2 + 8);   /*The ramp lags 8 samples (~8 counts)*/
+}
+
+static void test_iir(void)
+{
+    adc_filter_iir_t iir;
+
+    /*The first sample primes the output, a constant input stays exact*/
+    adc_filter_iir_init(&iir, 4);
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        TEST_CHECK_EQUAL(adc_filter_iir_step(&iir, 1234), 1234);
+    }
+
+    /*Step from 0 to 4000: never overshoots and settles within 1 count*/
+    adc_filter_iir_init(&iir, 2);
+    adc_filter_iir_step(&iir, 0);
+    uint16_t previous = 0;
+    uint16_t value = 0;
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        value = adc_filter_iir_step(&iir, 4000);
+        TEST_CHECK(value >= previous && value <= 4000);
+        previous = value;
+    }
+    TEST_CHECK(value >= 3999);
+
+    /*Smoother than the input on a noisy constant*/
+    uint32_t inputError = 0;
+    uint32_t outputError = 0;
+    adc_filter_iir_init(&iir, 3);
+    for (uint32_t i = 0; i < SIGNAL_LEN; i++)
+    {
+        int32_t noise = (int32_t)(random_next() % (2 * NOISE + 1)) - NOISE;
+        uint16_t filtered = adc_filter_iir_step(&iir, (uint16_t)(2000 + noise));
+        inputError += abs(noise);
+        outputError += abs((int32_t)filtered - 2000);
+    }
+    TEST_CHECK(outputError * 2 < inputError);
+}
+
+static void test_decimator(void)
+{
+    adc_filter_decim_t decim;
+    uint16_t expected[SIGNAL_LEN];
+    size_t written = 0;
+
+    /*Average of every 'ratio' samples, whatever the size of the blocks processed*/
+    for (uint16_t ratio = 1; ratio <= 64; ratio = ratio * 3 + 1)
+    {
+        size_t outputs = SIGNAL_LEN / ratio;
+        for (size_t k = 0; k < outputs; k++)
+        {
+            uint32_t sum = 0;
+            for (uint16_t j = 0; j < ratio; j++)
+            {
+                sum += noisy[k * ratio + j];
+            }
+            expected[k] = (uint16_t)(sum / ratio);
+        }
+
+        adc_filter_decim_init(&decim, ratio);
+        written = 0;
+        for (size_t start = 0, block = 1; start < SIGNAL_LEN; start += block, block = block % 37 + 7)
+        {
+            size_t n = (start + block > SIGNAL_LEN) ? SIGNAL_LEN - start : block;
+            written += adc_filter_decim_process(&decim, &noisy[start], &out[written], n);
+        }
+        TEST_CHECK_EQUAL(written, outputs);
+        TEST_CHECK(memcmp(out, expected, outputs * sizeof(uint16_t)) == 0);
+    }
+}
+
+/*********************
+*   BENCHMARK
+*********************/
+static double elapsed_ns(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+
+static void benchmark(void)
+{
+    static adc_filter_median_t median;
+    static adc_filter_ma_t ma;
+    static adc_filter_iir_t iir;
+    static adc_filter_decim_t decim;
+    static uint16_t block[SIGNAL_LEN];
+    struct timespec start;
+    volatile uint32_t sink = 0;
+
+    adc_filter_median_init(&median, 5);
+    adc_filter_ma_init(&ma, 16);
+    adc_filter_iir_init(&iir, 2);
+    adc_filter_decim_init(&decim, 50);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i += SIGNAL_LEN)
+    {
+        adc_filter_median_process(&median, noisy, block, SIGNAL_LEN);
+        sink += block[0];
+    }
+    printf("median 5      %6.2f ns/sample\n", elapsed_ns(&start) / BENCH_SAMPLES);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i += SIGNAL_LEN)
+    {
+        adc_filter_ma_process(&ma, noisy, block, SIGNAL_LEN);
+        sink += block[0];
+    }
+    printf("average 16    %6.2f ns/sample\n", elapsed_ns(&start) / BENCH_SAMPLES);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i += SIGNAL_LEN)
+    {
+        adc_filter_iir_process(&iir, noisy, block, SIGNAL_LEN);
+        sink += block[0];
+    }
+    printf("iir 1/4       %6.2f ns/sample\n", elapsed_ns(&start) / BENCH_SAMPLES);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i += SIGNAL_LEN)
+    {
+        sink += adc_filter_decim_process(&decim, noisy, block, SIGNAL_LEN);
+    }
+    printf("decimator 50  %6.2f ns/sample\n", elapsed_ns(&start) / BENCH_SAMPLES);
+}
+
+int main(void)
+{
+    make_signals();
+    test_median();
+    test_moving_average();
+    test_iir();
+    test_decimator();
+    benchmark();
+    return TEST_RESULT();
+}
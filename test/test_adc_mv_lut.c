@@ -0,0 +1,152 @@
+/***************************************************************************
+*@brief Host test of adc_mv_lut
+The line fitting scheme is faked here: it can be missing (no eFuse data),
+fail for some raw values or convert with a known line, and the table must
+hold, for every raw value, the conversion adc_mv_lut_get() stands for.
+***************************************************************************/
+#include <stdio.h>
+#include <stdbool.h>
+#include "esp_adc/adc_cali_scheme.h"
+#include "adc_mv_lut.h"
+#include "test_check.h"
+
+#define FAKE_OFFSET_MV  42      /*The fake line is apart from the reference formula*/
+#define FAKE_FAIL_EVERY 1000    /*Raw values multiple of it fail to convert*/
+
+static struct {
+    bool efuse;                             /*false: create fails as without eFuse data*/
+    bool failing;                           /*Some raw values fail to convert*/
+    adc_cali_line_fitting_config_t config;  /*Last configuration received*/
+    int created;
+    int deleted;
+} fake;
+
+static struct adc_cali_scheme_t {
+    adc_atten_t atten;
+} scheme;
+
+static int fake_mv(int raw)
+{
+    return raw * 3000 / 4095 + FAKE_OFFSET_MV;
+}
+
+esp_err_t adc_cali_create_scheme_line_fitting(const adc_cali_line_fitting_config_t *config, adc_cali_handle_t *ret_handle)
+{
+    fake.config = *config;
+    if (!fake.efuse)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    scheme.atten = config->atten;
+    *ret_handle = &scheme;
+    fake.created++;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_delete_scheme_line_fitting(adc_cali_handle_t handle)
+{
+    fake.deleted += (handle == &scheme);
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage)
+{
+    if (handle != &scheme || (fake.failing && raw % FAKE_FAIL_EVERY == 0))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *voltage = fake_mv(raw);
+    return ESP_OK;
+}
+
+/*********************
+*   TESTS
+*********************/
+static adc_mv_lut_t lut;
+
+static void test_reference(void)
+{
+    static const uint16_t fullScale[] = {1100, 1467, 2200, 3905};
+
+    for (adc_atten_t atten = ADC_ATTEN_DB_0; atten <= ADC_ATTEN_DB_12; atten++)
+    {
+        uint32_t mismatches = 0;
+
+        TEST_CHECK_EQUAL(adc_mv_lut_reference(atten, 0), 0);
+        TEST_CHECK_EQUAL(adc_mv_lut_reference(atten, 4095), fullScale[atten]);
+        for (uint32_t raw = 0; raw < ADC_MV_LUT_SIZE; raw++)
+        {
+            /*Nearest millivolt: within half a millivolt of the exact value*/
+            double exact = raw * (double)fullScale[atten] / 4095;
+            double error = adc_mv_lut_reference(atten, (uint16_t)raw) - exact;
+            mismatches += (error > 0.5 || error < -0.5);
+        }
+        TEST_CHECK_EQUAL(mismatches, 0);
+    }
+}
+
+static void test_no_efuse(void)
+{
+    uint32_t mismatches = 0;
+
+    fake.efuse = false;
+    TEST_CHECK_EQUAL(adc_mv_lut_build(&lut, ADC_UNIT_1, ADC_CHANNEL_6, ADC_ATTEN_DB_12), ESP_OK);
+    TEST_CHECK(!lut.calibrated);
+    for (uint32_t raw = 0; raw < ADC_MV_LUT_SIZE; raw++)
+    {
+        mismatches += (adc_mv_lut_get(&lut, (uint16_t)raw) != adc_mv_lut_reference(ADC_ATTEN_DB_12, (uint16_t)raw));
+    }
+    TEST_CHECK_EQUAL(mismatches, 0);
+}
+
+static void test_calibrated(void)
+{
+    uint32_t mismatches = 0;
+
+    fake.efuse = true;
+    fake.failing = false;
+    fake.created = fake.deleted = 0;
+    TEST_CHECK_EQUAL(adc_mv_lut_build(&lut, ADC_UNIT_1, ADC_CHANNEL_6, ADC_ATTEN_DB_6), ESP_OK);
+    TEST_CHECK(lut.calibrated);
+    TEST_CHECK_EQUAL(fake.config.unit_id, ADC_UNIT_1);
+    TEST_CHECK_EQUAL(fake.config.atten, ADC_ATTEN_DB_6);
+    TEST_CHECK_EQUAL(fake.config.bitwidth, ADC_BITWIDTH_12);
+    TEST_CHECK_EQUAL(fake.config.default_vref, 1100);
+    TEST_CHECK_EQUAL(fake.created, 1);
+    TEST_CHECK_EQUAL(fake.deleted, 1);
+    for (uint32_t raw = 0; raw < ADC_MV_LUT_SIZE; raw++)
+    {
+        mismatches += (adc_mv_lut_get(&lut, (uint16_t)raw) != fake_mv((int)raw));
+    }
+    TEST_CHECK_EQUAL(mismatches, 0);
+
+    /*Out of range raw values are masked into the table*/
+    TEST_CHECK_EQUAL(adc_mv_lut_get(&lut, ADC_MV_LUT_SIZE + 5), fake_mv(5));
+}
+
+static void test_failed_conversions(void)
+{
+    uint32_t mismatches = 0;
+
+    fake.efuse = true;
+    fake.failing = true;
+    TEST_CHECK_EQUAL(adc_mv_lut_build(&lut, ADC_UNIT_1, ADC_CHANNEL_6, ADC_ATTEN_DB_2_5), ESP_OK);
+    TEST_CHECK(lut.calibrated);
+    for (uint32_t raw = 0; raw < ADC_MV_LUT_SIZE; raw++)
+    {
+        uint16_t expected = (raw % FAKE_FAIL_EVERY == 0) ? adc_mv_lut_reference(ADC_ATTEN_DB_2_5, (uint16_t)raw)
+                                                         : (uint16_t)fake_mv((int)raw);
+        mismatches += (adc_mv_lut_get(&lut, (uint16_t)raw) != expected);
+    }
+    TEST_CHECK_EQUAL(mismatches, 0);
+}
+
+int main(void)
+{
+    TEST_CHECK_EQUAL(adc_mv_lut_build(NULL, ADC_UNIT_1, ADC_CHANNEL_6, ADC_ATTEN_DB_12), ESP_ERR_INVALID_ARG);
+    test_reference();
+    test_no_efuse();
+    test_calibrated();
+    test_failed_conversions();
+    return TEST_RESULT();
+}
@@ -0,0 +1,270 @@
+/***************************************************************************
+*@brief Host test of adc_scan
+Interleaved frames of several channels (and of a channel that is not in the
+table) are fed to adc_scan_process_frame: the ring of every channel must
+hold what its own filter chain gives for its own samples only, across the
+wrap of the ring. Then a reader task checks, while frames are published,
+that every snapshot was written by a single frame (sequence lock).
+***************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "adc_filter.h"
+#include "adc_scan.h"
+#include "test_check.h"
+
+#define CONVERSIONS         64      /*Conversions per frame, all channels*/
+#define PATTERN_LEN         4       /*3 channels of the table and one that is not*/
+#define FRAMES              40
+#define PER_CHANNEL         (FRAMES * CONVERSIONS / PATTERN_LEN)
+#define STRESS_CHANNELS     4
+#define STRESS_FRAMES       200000
+#define STRESS_BUDGET_MS    5000    /*Bounds the wait for the reader*/
+
+static const adc_scan_channel_t channels[] = {
+    { .channel = ADC_CHANNEL_3, .atten = ADC_ATTEN_DB_12, .rate_div = 1 },
+    { .channel = ADC_CHANNEL_6, .atten = ADC_ATTEN_DB_12, .rate_div = 4 },
+    { .channel = ADC_CHANNEL_7, .atten = ADC_ATTEN_DB_12, .rate_div = 2,
+      .filter = { .median_len = 3, .ma_len = 4, .iir_shift = 2 } },
+};
+static const adc_channel_t pattern[PATTERN_LEN] = { ADC_CHANNEL_3, ADC_CHANNEL_6, ADC_CHANNEL_7, ADC_CHANNEL_0 };
+
+static uint32_t updates;
+
+static void count_update(adc_scan_handle_t scan, void *arg)
+{
+    updates++;
+}
+
+static uint32_t random_next(void)
+{
+    static uint32_t state = 30;
+
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+static void put_sample(uint8_t *frame, uint32_t i, adc_channel_t channel, uint16_t value)
+{
+    adc_digi_output_data_t result = { .type1 = { .data = value, .channel = channel } };
+    memcpy(&frame[i * ADC_STREAM_SAMPLE_BYTES], &result, ADC_STREAM_SAMPLE_BYTES);
+}
+
+static adc_scan_handle_t new_scan(const adc_scan_channel_t *table, uint8_t count, uint32_t conversions,
+                                  adc_scan_update_cb_t on_update)
+{
+    adc_scan_handle_t scan = NULL;
+    adc_scan_config_t config = {
+        .channels = table,
+        .channel_count = count,
+        .sample_freq_hz = 20000,
+        .frame_samples = conversions,
+        .buffer_frames = 4,
+        .on_update = on_update,
+        .task_priority = 2,
+        .task_stack = 1024*3,
+    };
+
+    TEST_CHECK_EQUAL(adc_scan_new(&config, &scan), ESP_OK);
+    return scan;
+}
+
+/*********************
+*   DEMULTIPLEXER
+*********************/
+static uint16_t raw[3][PER_CHANNEL];        /*Samples given to each channel of the table*/
+static uint16_t expected[3][PER_CHANNEL];   /*What each filter chain stores*/
+static uint32_t expectedCount[3];
+
+/*The filter chain of a channel applied to all its samples at once*/
+static void reference_chain(uint8_t index)
+{
+    const adc_scan_channel_t *channel = &channels[index];
+    adc_filter_median_t median;
+    adc_filter_decim_t decim;
+    adc_filter_ma_t ma;
+    adc_filter_iir_t iir;
+    uint16_t value = 0;
+
+    adc_filter_median_init(&median, channel->filter.median_len);
+    adc_filter_decim_init(&decim, channel->rate_div);
+    adc_filter_ma_init(&ma, channel->filter.ma_len);
+    adc_filter_iir_init(&iir, channel->filter.iir_shift);
+
+    expectedCount[index] = 0;
+    for (uint32_t i = 0; i < PER_CHANNEL; i++)
+    {
+        value = (channel->filter.median_len > 1) ? adc_filter_median_step(&median, raw[index][i]) : raw[index][i];
+        expectedCount[index] += adc_filter_decim_process(&decim, &value, &expected[index][expectedCount[index]], 1);
+    }
+    if (channel->filter.ma_len > 1)
+    {
+        adc_filter_ma_process(&ma, expected[index], expected[index], expectedCount[index]);
+    }
+    if (channel->filter.iir_shift > 0)
+    {
+        adc_filter_iir_process(&iir, expected[index], expected[index], expectedCount[index]);
+    }
+}
+
+static void test_demultiplexer(void)
+{
+    uint8_t frame[CONVERSIONS * ADC_STREAM_SAMPLE_BYTES];
+    uint16_t history[ADC_SCAN_RING_LEN];
+    adc_scan_snapshot_t snapshot;
+    uint32_t lateValues = 0;
+
+    adc_scan_handle_t scan = new_scan(channels, 3, CONVERSIONS, count_update);
+    if (!scan)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < PER_CHANNEL; i++)
+    {
+        raw[0][i] = (uint16_t)(i % 4096);
+        raw[1][i] = (uint16_t)(random_next() % 4096);
+        raw[2][i] = (uint16_t)(2000 + random_next() % 64 + ((i % 29 == 0) ? 1500 : 0));   /*Spikes for the median*/
+    }
+    for (uint8_t c = 0; c < 3; c++)
+    {
+        reference_chain(c);
+    }
+
+    for (uint32_t f = 0; f < FRAMES; f++)
+    {
+        for (uint32_t i = 0; i < CONVERSIONS; i++)
+        {
+            uint32_t n = (f * CONVERSIONS + i) / PATTERN_LEN;
+            uint32_t slot = i % PATTERN_LEN;
+            put_sample(frame, i, pattern[slot], (slot < 3) ? raw[slot][n] : 4095);
+        }
+        adc_scan_process_frame(scan, frame, sizeof(frame));
+
+        /*The snapshot holds the newest stored value of every channel*/
+        adc_scan_read(scan, &snapshot);
+        TEST_CHECK_EQUAL(snapshot.sequence, f + 1);
+        for (uint8_t c = 0; c < 3; c++)
+        {
+            uint32_t stored = (f + 1) * (CONVERSIONS / PATTERN_LEN) / channels[c].rate_div;
+            lateValues += (snapshot.value[c] != expected[c][stored - 1]);
+            uint16_t latest = 0;
+            TEST_CHECK_EQUAL(adc_scan_latest(scan, c, &latest), ESP_OK);
+            lateValues += (latest != snapshot.value[c]);
+        }
+    }
+    TEST_CHECK_EQUAL(lateValues, 0);
+    TEST_CHECK_EQUAL(updates, FRAMES);
+
+    /*The rings keep the newest samples, oldest first, after wrapping*/
+    for (uint8_t c = 0; c < 3; c++)
+    {
+        uint32_t n = adc_scan_history(scan, c, history, ADC_SCAN_RING_LEN);
+        uint32_t kept = (expectedCount[c] < ADC_SCAN_RING_LEN) ? expectedCount[c] : ADC_SCAN_RING_LEN;
+
+        TEST_CHECK_EQUAL(n, kept);
+        TEST_CHECK(memcmp(history, &expected[c][expectedCount[c] - kept], kept * sizeof(uint16_t)) == 0);
+    }
+    TEST_CHECK_EQUAL(adc_scan_history(scan, 0, history, 10), 10);
+    TEST_CHECK(memcmp(history, &expected[0][expectedCount[0] - 10], 10 * sizeof(uint16_t)) == 0);
+
+    /*An index beyond the table of 3 channels reads nothing*/
+    uint16_t beyond = 0xBEEF;
+    TEST_CHECK_EQUAL(adc_scan_latest(scan, 3, &beyond), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(adc_scan_latest(scan, ADC_SCAN_MAX_CHANNELS, &beyond), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(beyond, 0xBEEF);
+    TEST_CHECK_EQUAL(adc_scan_history(scan, 3, history, 10), 0);
+
+    adc_scan_delete(scan);
+}
+
+/*********************
+*   SEQUENCE LOCK
+*********************/
+typedef struct {
+    adc_scan_handle_t scan;
+    atomic_bool done;
+    atomic_bool finished;
+    uint32_t reads;
+    uint32_t torn;          /*Snapshots mixing values of different frames*/
+    uint32_t backwards;     /*Sequence lower than the previous read*/
+} reader_t;
+
+static void reader_task(void *arg)
+{
+    reader_t *reader = (reader_t *)arg;
+    adc_scan_snapshot_t snapshot;
+    uint32_t last = 0;
+
+    while (!atomic_load(&reader->done))
+    {
+        adc_scan_read(reader->scan, &snapshot);
+        for (uint8_t c = 1; c < STRESS_CHANNELS; c++)
+        {
+            reader->torn += (snapshot.value[c] != snapshot.value[0] + c);
+        }
+        reader->backwards += (snapshot.sequence < last);
+        last = snapshot.sequence;
+        reader->reads++;
+    }
+    atomic_store(&reader->finished, true);
+    vTaskDelete(NULL);
+}
+
+static void test_sequence_lock(void)
+{
+    static const adc_scan_channel_t table[STRESS_CHANNELS] = {
+        { .channel = ADC_CHANNEL_0, .atten = ADC_ATTEN_DB_12, .rate_div = 1 },
+        { .channel = ADC_CHANNEL_1, .atten = ADC_ATTEN_DB_12, .rate_div = 1 },
+        { .channel = ADC_CHANNEL_2, .atten = ADC_ATTEN_DB_12, .rate_div = 1 },
+        { .channel = ADC_CHANNEL_3, .atten = ADC_ATTEN_DB_12, .rate_div = 1 },
+    };
+    static reader_t reader;
+    uint8_t frame[STRESS_CHANNELS * ADC_STREAM_SAMPLE_BYTES];
+
+    reader.scan = new_scan(table, STRESS_CHANNELS, STRESS_CHANNELS, NULL);
+    if (!reader.scan)
+    {
+        return;
+    }
+
+    /*The first frame is published before the reader starts: no zeros from adc_scan_new*/
+    for (uint8_t c = 0; c < STRESS_CHANNELS; c++)
+    {
+        put_sample(frame, c, table[c].channel, c);
+    }
+    adc_scan_process_frame(reader.scan, frame, sizeof(frame));
+    TEST_CHECK(xTaskCreatePinnedToCore(reader_task, "reader", 1024*3, &reader, 2, NULL, tskNO_AFFINITY) == pdPASS);
+
+    /*Every frame gives the channel c the value base + c*/
+    for (uint32_t f = 1; f < STRESS_FRAMES; f++)
+    {
+        uint16_t base = (uint16_t)(f % 4000);
+        for (uint8_t c = 0; c < STRESS_CHANNELS; c++)
+        {
+            put_sample(frame, c, table[c].channel, base + c);
+        }
+        adc_scan_process_frame(reader.scan, frame, sizeof(frame));
+    }
+    atomic_store(&reader.done, true);
+    for (uint32_t waited = 0; !atomic_load(&reader.finished) && waited < STRESS_BUDGET_MS; waited++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    printf("sequence lock: %u reads during %u frames\n", reader.reads, STRESS_FRAMES);
+    TEST_CHECK(atomic_load(&reader.finished));
+    TEST_CHECK(reader.reads > 0);
+    TEST_CHECK_EQUAL(reader.torn, 0);
+    TEST_CHECK_EQUAL(reader.backwards, 0);
+    adc_scan_delete(reader.scan);
+}
+
+int main(void)
+{
+    test_demultiplexer();
+    test_sequence_lock();
+    return TEST_RESULT();
+}
@@ -0,0 +1,269 @@
+/***************************************************************************
+*@brief Host test of adc_stream
+The frames of a recorded Potenciometer turn are completed by the fake DMA
+and must reach the consumer whole and in order, each one with the time the
+DMA completed it. Then the consumer is held until the driver ring buffer
+overflows: the frames stored are still delivered, in order, and the last one
+keeps its own completion time. Last the frames are notified before the
+driver stores them, as on_conv_done can run first on the target: each one
+must still be delivered without waiting for the next completion.
+Usage: test_adc_stream <recording>, one raw value per line ('#' comments).
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "adc_stream.h"
+#include "fake_adc_continuous.h"
+#include "test_check.h"
+
+#define POT_CHANNEL     ADC_CHANNEL_4
+#define FRAME_SAMPLES   100
+#define FRAME_BYTES     (FRAME_SAMPLES * ADC_STREAM_SAMPLE_BYTES)
+#define BUFFER_FRAMES   4
+#define MAX_SAMPLES     4096
+#define WAIT_TICKS      2000    /*Longest wait for the stream task*/
+
+typedef struct {
+    uint16_t values[MAX_SAMPLES];   /*Samples received, in order*/
+    atomic_uint count;
+    atomic_uint frames;
+    int64_t stamps[MAX_SAMPLES / FRAME_SAMPLES];  /*last_frame_us seen by every frame*/
+    adc_stream_handle_t stream;
+    atomic_bool hold;               /*The consumer does not return while true*/
+    uint32_t badChannels;
+    uint32_t badLengths;
+} consumer_t;
+
+static consumer_t consumer;
+static uint16_t recording[MAX_SAMPLES];
+
+/*Same consumer interface as adc_scan: raw frames from the stream task*/
+static void on_frame(const uint8_t *frame, uint32_t len, void *arg)
+{
+    consumer_t *c = (consumer_t *)arg;
+    uint32_t count = atomic_load(&c->count);
+    uint32_t frames = atomic_load(&c->frames);
+    adc_stream_stats_t stats;
+
+    while (atomic_load(&c->hold))
+    {
+        vTaskDelay(1);
+    }
+    adc_stream_get_stats(c->stream, &stats);
+    c->stamps[frames % (MAX_SAMPLES / FRAME_SAMPLES)] = stats.last_frame_us;
+    if (len != FRAME_BYTES)
+    {
+        c->badLengths++;
+    }
+    for (uint32_t i = 0; i < adc_stream_sample_count(len); i++)
+    {
+        if (adc_stream_sample_channel(frame, i) != POT_CHANNEL)
+        {
+            c->badChannels++;
+        }
+        if (count < MAX_SAMPLES)
+        {
+            c->values[count++] = adc_stream_sample_value(frame, i);
+        }
+    }
+    atomic_store(&c->count, count);
+    atomic_fetch_add(&c->frames, 1);
+}
+
+static uint32_t read_recording(const char *path, uint16_t *values, uint32_t max)
+{
+    FILE *file = fopen(path, "r");
+    char line[64];
+    uint32_t count = 0;
+
+    if (file == NULL)
+    {
+        printf("%s could not be opened\n", path);
+        return 0;
+    }
+    while (count < max && fgets(line, sizeof(line), file))
+    {
+        if (line[0] != '#' && line[0] != '\n')
+        {
+            values[count++] = (uint16_t)strtoul(line, NULL, 10);
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+/*DMA frame of FRAME_SAMPLES results, as the ESP32 writes them (TYPE1)*/
+static void make_frame(const uint16_t *values, uint8_t *frame)
+{
+    for (uint32_t i = 0; i < FRAME_SAMPLES; i++)
+    {
+        adc_digi_output_data_t result = { .type1 = { .data = values[i], .channel = POT_CHANNEL } };
+        memcpy(&frame[i * ADC_STREAM_SAMPLE_BYTES], &result, ADC_STREAM_SAMPLE_BYTES);
+    }
+}
+
+static bool wait_frames(uint32_t frames)
+{
+    TickType_t start = xTaskGetTickCount();
+
+    while (atomic_load(&consumer.frames) < frames)
+    {
+        if (xTaskGetTickCount() - start > WAIT_TICKS)
+        {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+    return true;
+}
+
+/*********************
+*   TESTS
+*********************/
+static void test_replay(adc_stream_handle_t stream, adc_continuous_handle_t driver, uint32_t samples)
+{
+    uint8_t frame[FRAME_BYTES];
+    uint32_t frames = samples / FRAME_SAMPLES;
+    adc_stream_stats_t stats;
+
+    for (uint32_t k = 0; k < frames; k++)
+    {
+        make_frame(&recording[k * FRAME_SAMPLES], frame);
+        int64_t before = esp_timer_get_time();
+        TEST_CHECK_EQUAL(fake_adc_continuous_complete(driver, frame), ESP_OK);
+        int64_t after = esp_timer_get_time();
+        TEST_CHECK(wait_frames(k + 1));
+
+        /*The consumer sees the completion time of the frame it was handed*/
+        TEST_CHECK_EQUAL(adc_stream_get_stats(stream, &stats), ESP_OK);
+        TEST_CHECK_EQUAL(stats.frames, k + 1);
+        TEST_CHECK(stats.last_frame_us >= before && stats.last_frame_us <= after);
+    }
+
+    TEST_CHECK_EQUAL(atomic_load(&consumer.count), frames * FRAME_SAMPLES);
+    TEST_CHECK(memcmp(consumer.values, recording, frames * FRAME_SAMPLES * sizeof(uint16_t)) == 0);
+    TEST_CHECK_EQUAL(consumer.badChannels, 0);
+    TEST_CHECK_EQUAL(consumer.badLengths, 0);
+    TEST_CHECK_EQUAL(stats.overflows, 0);
+}
+
+static void test_overflow(adc_stream_handle_t stream, adc_continuous_handle_t driver, uint32_t samples)
+{
+    uint8_t frame[FRAME_BYTES];
+    uint32_t delivered = atomic_load(&consumer.frames);
+    uint32_t accepted = 0;
+    int64_t before[BUFFER_FRAMES + 1];
+    int64_t after[BUFFER_FRAMES + 1];
+    adc_stream_stats_t stats;
+
+    /*The first frame is taken by the stream task, the next ones fill the driver*/
+    atomic_store(&consumer.hold, true);
+    atomic_store(&consumer.count, 0);
+    for (uint32_t k = 0; k < BUFFER_FRAMES + 4; k++)
+    {
+        make_frame(&recording[(k * FRAME_SAMPLES) % (samples - FRAME_SAMPLES)], frame);
+        int64_t start = esp_timer_get_time();
+        esp_err_t ret = fake_adc_continuous_complete(driver, frame);
+        if (ret == ESP_OK && accepted <= BUFFER_FRAMES)
+        {
+            before[accepted] = start;
+            after[accepted] = esp_timer_get_time();
+            accepted++;
+        }
+        vTaskDelay(2);
+    }
+    TEST_CHECK(accepted >= BUFFER_FRAMES && accepted <= BUFFER_FRAMES + 1);
+
+    atomic_store(&consumer.hold, false);
+    TEST_CHECK(wait_frames(delivered + accepted));
+    vTaskDelay(10);     /*Nothing else must arrive*/
+
+    TEST_CHECK_EQUAL(adc_stream_get_stats(stream, &stats), ESP_OK);
+    TEST_CHECK_EQUAL(stats.frames, delivered + accepted);
+    TEST_CHECK_EQUAL(stats.overflows, BUFFER_FRAMES + 4 - accepted);
+    TEST_CHECK(stats.last_frame_us >= before[accepted - 1] && stats.last_frame_us <= after[accepted - 1]);
+
+    /*Frames delivered late are still paired with their own completion time*/
+    for (uint32_t k = 0; k < accepted; k++)
+    {
+        int64_t stamp = consumer.stamps[(delivered + k) % (MAX_SAMPLES / FRAME_SAMPLES)];
+        TEST_CHECK(stamp >= before[k] && stamp <= after[k]);
+        TEST_CHECK(memcmp(&consumer.values[k * FRAME_SAMPLES], &recording[(k * FRAME_SAMPLES) % (samples - FRAME_SAMPLES)],
+                          FRAME_SAMPLES * sizeof(uint16_t)) == 0);
+    }
+}
+
+static void test_late_store(adc_stream_handle_t stream, adc_continuous_handle_t driver, uint32_t samples)
+{
+    uint8_t frame[FRAME_BYTES];
+    uint32_t delivered = atomic_load(&consumer.frames);
+    adc_stream_stats_t stats;
+
+    fake_adc_continuous_set_late_store(driver, true);
+    atomic_store(&consumer.count, 0);
+    for (uint32_t k = 0; k < BUFFER_FRAMES; k++)
+    {
+        make_frame(&recording[(k * FRAME_SAMPLES) % (samples - FRAME_SAMPLES)], frame);
+        TEST_CHECK_EQUAL(fake_adc_continuous_complete(driver, frame), ESP_OK);
+        TEST_CHECK(wait_frames(delivered + k + 1));
+        TEST_CHECK(memcmp(&consumer.values[k * FRAME_SAMPLES], &recording[(k * FRAME_SAMPLES) % (samples - FRAME_SAMPLES)],
+                          FRAME_SAMPLES * sizeof(uint16_t)) == 0);
+    }
+    fake_adc_continuous_set_late_store(driver, false);
+
+    TEST_CHECK_EQUAL(adc_stream_get_stats(stream, &stats), ESP_OK);
+    TEST_CHECK_EQUAL(stats.frames, delivered + BUFFER_FRAMES);
+}
+
+int main(int argc, char **argv)
+{
+    static const adc_stream_channel_t channels[] = { { .channel = POT_CHANNEL, .atten = ADC_ATTEN_DB_12 } };
+    adc_stream_handle_t stream = NULL;
+    uint32_t samples = (argc > 1) ? read_recording(argv[1], recording, MAX_SAMPLES) : 0;
+
+    TEST_CHECK(samples >= 2 * FRAME_SAMPLES);
+    if (samples < 2 * FRAME_SAMPLES)
+    {
+        return TEST_RESULT();
+    }
+
+    adc_stream_config_t config = {
+        .channels = channels,
+        .channel_count = 1,
+        .sample_freq_hz = 20000,
+        .frame_samples = FRAME_SAMPLES,
+        .buffer_frames = BUFFER_FRAMES,
+        .on_frame = on_frame,
+        .arg = &consumer,
+        .task_priority = 2,
+        .task_stack = 1024*3,
+    };
+    TEST_CHECK_EQUAL(adc_stream_new(&config, &stream), ESP_OK);
+    consumer.stream = stream;
+    adc_continuous_handle_t driver = fake_adc_continuous_last();
+    TEST_CHECK(stream && driver);
+    if (!stream || !driver)
+    {
+        return TEST_RESULT();
+    }
+
+    /*One pattern entry of ADC1 for the channel, frames of whole conversions*/
+    const adc_continuous_config_t *pattern = fake_adc_continuous_config(driver);
+    TEST_CHECK_EQUAL(pattern->pattern_num, 1);
+    TEST_CHECK_EQUAL(pattern->adc_pattern[0].channel, POT_CHANNEL);
+    TEST_CHECK_EQUAL(pattern->adc_pattern[0].unit, ADC_UNIT_1);
+    TEST_CHECK_EQUAL(pattern->format, ADC_DIGI_OUTPUT_FORMAT_TYPE1);
+    TEST_CHECK_EQUAL(fake_adc_continuous_frame_size(driver), FRAME_BYTES);
+
+    TEST_CHECK_EQUAL(adc_stream_start(stream), ESP_OK);
+    test_replay(stream, driver, samples);
+    test_overflow(stream, driver, samples);
+    test_late_store(stream, driver, samples);
+    TEST_CHECK_EQUAL(adc_stream_stop(stream), ESP_OK);
+    TEST_CHECK_EQUAL(adc_stream_delete(stream), ESP_OK);
+    return TEST_RESULT();
+}
@@ -0,0 +1,120 @@
+/***************************************************************************
+*@brief Host test of adc_zone
+Values are fed around the edges of a zone table: the zone must only change
+beyond the hysteresis, and every change must reach the subscriber queue.
+With the queue full, the detector stays in the zone the subscriber knows
+and sends the transition with the next value beyond the edge.
+***************************************************************************/
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "adc_zone.h"
+#include "test_check.h"
+
+#define HYSTERESIS  40
+
+static const uint16_t edges[] = { 750, 1500, 2250, 3000 };
+
+static adc_zone_t detector;
+static QueueHandle_t queue;
+
+static void init_detector(UBaseType_t queueLength)
+{
+    if (queue)
+    {
+        vQueueDelete(queue);
+    }
+    queue = xQueueCreate(queueLength, sizeof(adc_zone_event_t));
+    adc_zone_config_t config = {
+        .edges = edges,
+        .edge_count = sizeof(edges) / sizeof(edges[0]),
+        .hysteresis = HYSTERESIS,
+        .subscriber = queue,
+    };
+    adc_zone_init(&detector, &config);
+}
+
+/*The next event must be from -> to*/
+static void check_event(uint8_t from, uint8_t to)
+{
+    adc_zone_event_t event = { 0 };
+
+    TEST_CHECK(xQueueReceive(queue, &event, 0) == pdTRUE);
+    TEST_CHECK_EQUAL(event.from, from);
+    TEST_CHECK_EQUAL(event.to, to);
+}
+
+static void test_hysteresis(void)
+{
+    init_detector(8);
+
+    /*The first value sets the zone and sends it*/
+    TEST_CHECK(adc_zone_update(&detector, 1000));
+    check_event(0, 1);
+
+    /*Around the 1500 edge: no change until 1540, then none until below 1460*/
+    TEST_CHECK(!adc_zone_update(&detector, 1500));
+    TEST_CHECK(!adc_zone_update(&detector, 1539));
+    TEST_CHECK(adc_zone_update(&detector, 1540));
+    check_event(1, 2);
+    TEST_CHECK(!adc_zone_update(&detector, 1470));
+    TEST_CHECK(!adc_zone_update(&detector, 1460));
+    TEST_CHECK(adc_zone_update(&detector, 1459));
+    check_event(2, 1);
+
+    /*A jump crosses several edges in one event*/
+    TEST_CHECK(adc_zone_update(&detector, 4000));
+    check_event(1, 4);
+    TEST_CHECK(adc_zone_update(&detector, 0));
+    check_event(4, 0);
+
+    adc_zone_stats_t stats = adc_zone_get_stats(&detector);
+    TEST_CHECK_EQUAL(stats.transitions, 5);
+    TEST_CHECK_EQUAL(stats.suppressed, 4);
+    TEST_CHECK_EQUAL(stats.dropped_events, 0);
+    TEST_CHECK_EQUAL(uxQueueMessagesWaiting(queue), 0);
+}
+
+static void test_full_queue(void)
+{
+    adc_zone_event_t event;
+
+    init_detector(1);
+    TEST_CHECK(adc_zone_update(&detector, 100));
+
+    /*The subscriber did not read zone 0 yet: the transition waits*/
+    TEST_CHECK(!adc_zone_update(&detector, 1000));
+    TEST_CHECK_EQUAL(adc_zone_current(&detector), 0);
+    TEST_CHECK_EQUAL(adc_zone_get_stats(&detector).dropped_events, 1);
+
+    /*Read, then the same value sends the transition*/
+    check_event(0, 0);
+    TEST_CHECK(adc_zone_update(&detector, 1000));
+    TEST_CHECK_EQUAL(adc_zone_current(&detector), 1);
+    check_event(0, 1);
+
+    /*A transition missed while full and then undone sends nothing: the
+      subscriber already has the current zone*/
+    TEST_CHECK(adc_zone_update(&detector, 1600));
+    TEST_CHECK(!adc_zone_update(&detector, 2400));
+    TEST_CHECK(xQueueReceive(queue, &event, 0) == pdTRUE && event.to == 2);
+    TEST_CHECK(!adc_zone_update(&detector, 1600));
+    TEST_CHECK_EQUAL(uxQueueMessagesWaiting(queue), 0);
+    TEST_CHECK_EQUAL(adc_zone_current(&detector), 2);
+
+    /*The first event is sent again too if the queue was full*/
+    init_detector(1);
+    adc_zone_event_t other = { 0 };
+    xQueueSend(queue, &other, 0);
+    TEST_CHECK(!adc_zone_update(&detector, 2000));
+    xQueueReceive(queue, &other, 0);
+    TEST_CHECK(adc_zone_update(&detector, 2000));
+    check_event(0, 2);
+}
+
+int main(void)
+{
+    test_hysteresis();
+    test_full_queue();
+    return TEST_RESULT();
+}
@@ -0,0 +1,34 @@
+/***************************************************************************
+*@brief Checks of the host tests
+A failed TEST_CHECK() prints where and what failed and the test goes on, so
+one run reports every failure. main() returns TEST_RESULT().
+***************************************************************************/
+#pragma once
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+#define TEST_CHECK(condition)                                                       \
+    do {                                                                            \
+        if (!(condition))                                                           \
+        {                                                                           \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);    \
+            testFailures++;                                                         \
+        }                                                                           \
+    } while (0)
+
+/*Same check, printing the two values compared*/
+#define TEST_CHECK_EQUAL(actual, expected)                                          \
+    do {                                                                            \
+        long long testActual = (long long)(actual);                                 \
+        long long testExpected = (long long)(expected);                             \
+        if (testActual != testExpected)                                             \
+        {                                                                           \
+            printf("%s:%d: check failed: %s is %lld, expected %lld\n", __FILE__,    \
+                   __LINE__, #actual, testActual, testExpected);                    \
+            testFailures++;                                                         \
+        }                                                                           \
+    } while (0)
+
+#define TEST_RESULT()   (printf("%s: %d failed checks\n", __FILE__, testFailures), testFailures ? 1 : 0)
@@ -0,0 +1,235 @@
+/***************************************************************************
+*@brief Host test of fair_lock
+A task takes the lock again as soon as it gives it, while slower tasks take
+it now and then: with the FIFO handoff none of them waits longer than the
+holds of the tasks that can be queued ahead of it. Then the handoff order,
+the full queue, the timeout and a stray notification on
+FAIR_LOCK_NOTIFY_INDEX (which must not make a waiter return) are checked.
+The waits are wall clock times, so the slack only holds while the test has
+the CPU of the host: it is registered SERIAL and ctest -j runs it alone.
+***************************************************************************/
+#include <stdio.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "fair_lock.h"
+#include "test_check.h"
+
+#define SLOW_TASKS      3
+#define HOLD_US         1000
+#define SLOW_PERIOD_MS  20
+#define RUN_MS          1000
+#define SLACK_US        10000   /*Scheduling of the host*/
+#define WAIT_BOUND_US   (SLOW_TASKS * HOLD_US + SLACK_US)   /*Every other task queued ahead*/
+#define SHORT_TIMEOUT   30
+
+static fair_lock_t lock;
+
+typedef struct {
+    const char *name;
+    bool hammer;            /*Takes the lock again right after giving it*/
+    uint32_t takes;
+    int64_t worst_us;
+    atomic_bool done;
+} contender_t;
+
+static atomic_bool stop;
+
+static void hold(void)
+{
+    int64_t end = esp_timer_get_time() + HOLD_US;
+    while (esp_timer_get_time() < end)
+    {
+    }
+}
+
+static void contender_task(void *arg)
+{
+    contender_t *c = (contender_t *)arg;
+
+    while (!atomic_load(&stop))
+    {
+        int64_t start = esp_timer_get_time();
+        if (fair_lock_take(&lock, portMAX_DELAY) == pdTRUE)
+        {
+            int64_t waited = esp_timer_get_time() - start;
+            c->worst_us = (waited > c->worst_us) ? waited : c->worst_us;
+            c->takes++;
+            hold();
+            fair_lock_give(&lock);
+        }
+        if (!c->hammer)
+        {
+            vTaskDelay(pdMS_TO_TICKS(SLOW_PERIOD_MS));
+        }
+    }
+    atomic_store(&c->done, true);
+    vTaskDelete(NULL);
+}
+
+static void wait_flag(atomic_bool *flag)
+{
+    for (int i = 0; i < 2000 && !atomic_load(flag); i++)
+    {
+        vTaskDelay(1);
+    }
+}
+
+static void wait_queued(uint8_t count)
+{
+    for (int i = 0; i < 2000 && lock.count != count; i++)
+    {
+        vTaskDelay(1);
+    }
+}
+
+/*********************
+*   TESTS
+*********************/
+static void test_worst_wait(void)
+{
+    static contender_t contenders[SLOW_TASKS + 1] = {
+        { .name = "hammer", .hammer = true },
+        { .name = "slow0" },
+        { .name = "slow1" },
+        { .name = "slow2" },
+    };
+
+    for (int i = 0; i <= SLOW_TASKS; i++)
+    {
+        TEST_CHECK(xTaskCreate(contender_task, contenders[i].name, 1024*3, &contenders[i], 5, NULL) == pdPASS);
+    }
+    vTaskDelay(pdMS_TO_TICKS(RUN_MS));
+    atomic_store(&stop, true);
+
+    for (int i = 0; i <= SLOW_TASKS; i++)
+    {
+        contender_t *c = &contenders[i];
+        wait_flag(&c->done);
+        printf("%-6s %4u takes, worst wait %5lld us (bound %d us)\n", c->name, c->takes, (long long)c->worst_us,
+               WAIT_BOUND_US);
+        TEST_CHECK(atomic_load(&c->done));
+        TEST_CHECK(c->worst_us <= WAIT_BOUND_US);
+        TEST_CHECK(c->takes >= (c->hammer ? RUN_MS / 5 : RUN_MS / SLOW_PERIOD_MS / 2));
+    }
+    TEST_CHECK(lock.owner == NULL);
+    TEST_CHECK_EQUAL(lock.count, 0);
+}
+
+/*Each waiter records when it got the lock and gives it at once*/
+static atomic_uint handoffOrder;
+
+typedef struct {
+    uint32_t order;
+    BaseType_t taken;
+    TickType_t timeout;
+    TickType_t waited;
+    atomic_bool done;
+} waiter_t;
+
+static void waiter_task(void *arg)
+{
+    waiter_t *w = (waiter_t *)arg;
+    TickType_t start = xTaskGetTickCount();
+
+    w->taken = fair_lock_take(&lock, w->timeout);
+    w->waited = xTaskGetTickCount() - start;
+    if (w->taken == pdTRUE)
+    {
+        w->order = atomic_fetch_add(&handoffOrder, 1);
+        fair_lock_give(&lock);
+    }
+    atomic_store(&w->done, true);
+    vTaskDelete(NULL);
+}
+
+static void test_fifo_and_full_queue(void)
+{
+    static waiter_t waiters[FAIR_LOCK_MAX_WAITERS + 1];
+    uint32_t outOfOrder = 0;
+
+    TEST_CHECK_EQUAL(fair_lock_take(&lock, 0), pdTRUE);
+    TEST_CHECK_EQUAL(fair_lock_take(&lock, 0), pdFALSE);
+
+    /*Queued one at a time, so the queue order is the creation order*/
+    for (uint8_t i = 0; i < FAIR_LOCK_MAX_WAITERS; i++)
+    {
+        waiters[i].timeout = portMAX_DELAY;
+        TEST_CHECK(xTaskCreate(waiter_task, "waiter", 1024*3, &waiters[i], 5, NULL) == pdPASS);
+        wait_queued(i + 1);
+    }
+    TEST_CHECK_EQUAL(lock.count, FAIR_LOCK_MAX_WAITERS);
+
+    /*No room: fails at once whatever the timeout*/
+    waiter_t *extra = &waiters[FAIR_LOCK_MAX_WAITERS];
+    extra->timeout = pdMS_TO_TICKS(1000);
+    TEST_CHECK(xTaskCreate(waiter_task, "extra", 1024*3, extra, 5, NULL) == pdPASS);
+    wait_flag(&extra->done);
+    TEST_CHECK_EQUAL(extra->taken, pdFALSE);
+    TEST_CHECK(extra->waited < 100);
+
+    uint32_t handoffs = lock.handoffs;
+    TEST_CHECK_EQUAL(fair_lock_give(&lock), pdTRUE);
+    for (uint8_t i = 0; i < FAIR_LOCK_MAX_WAITERS; i++)
+    {
+        wait_flag(&waiters[i].done);
+        TEST_CHECK_EQUAL(waiters[i].taken, pdTRUE);
+        outOfOrder += (waiters[i].order != i);
+    }
+    TEST_CHECK_EQUAL(outOfOrder, 0);
+    TEST_CHECK_EQUAL(lock.handoffs - handoffs, FAIR_LOCK_MAX_WAITERS);
+    TEST_CHECK(lock.owner == NULL);
+}
+
+static void test_timeout(void)
+{
+    static waiter_t waiter = { .timeout = SHORT_TIMEOUT };
+
+    TEST_CHECK_EQUAL(fair_lock_take(&lock, 0), pdTRUE);
+    TEST_CHECK(xTaskCreate(waiter_task, "late", 1024*3, &waiter, 5, NULL) == pdPASS);
+    wait_flag(&waiter.done);
+    TEST_CHECK_EQUAL(waiter.taken, pdFALSE);
+    TEST_CHECK(waiter.waited >= SHORT_TIMEOUT);
+    TEST_CHECK_EQUAL(lock.count, 0);
+
+    /*Nobody left to hand it to*/
+    TEST_CHECK_EQUAL(fair_lock_give(&lock), pdTRUE);
+    TEST_CHECK(lock.owner == NULL);
+}
+
+static void test_stray_notification(void)
+{
+    static waiter_t waiter = { .timeout = portMAX_DELAY };
+    TaskHandle_t task = NULL;
+
+    TEST_CHECK_EQUAL(fair_lock_take(&lock, 0), pdTRUE);
+    TEST_CHECK(xTaskCreate(waiter_task, "stray", 1024*3, &waiter, 5, &task) == pdPASS);
+    wait_queued(1);
+
+    /*A notification that is not a handoff: the waiter checks and keeps waiting*/
+    xTaskNotifyGiveIndexed(task, FAIR_LOCK_NOTIFY_INDEX);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_CHECK(!atomic_load(&waiter.done));
+    TEST_CHECK(lock.owner == xTaskGetCurrentTaskHandle());
+    TEST_CHECK_EQUAL(lock.count, 1);
+
+    TEST_CHECK_EQUAL(fair_lock_give(&lock), pdTRUE);
+    wait_flag(&waiter.done);
+    TEST_CHECK_EQUAL(waiter.taken, pdTRUE);
+    TEST_CHECK(lock.owner == NULL);
+
+    /*Only the owner gives*/
+    TEST_CHECK_EQUAL(fair_lock_give(&lock), pdFALSE);
+}
+
+int main(void)
+{
+    TEST_CHECK_EQUAL(fair_lock_init(NULL), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(fair_lock_init(&lock), ESP_OK);
+    test_worst_wait();
+    test_fifo_and_full_queue();
+    test_timeout();
+    test_stray_notification();
+    return TEST_RESULT();
+}
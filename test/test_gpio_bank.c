@@ -0,0 +1,130 @@
+/***************************************************************************
+*@brief Host test of gpio_bank
+The W1TS/W1TC registers are emulated on two output words: every level
+combination of a bank that spans both words must reach exactly the bank
+pins, in the four writes of gpio_bank_apply(), leaving the others alone.
+***************************************************************************/
+#include <stdio.h>
+#include "soc/soc.h"
+#include "gpio_bank.h"
+#include "test_check.h"
+
+static uint32_t out[2];     /*GPIO_OUT_REG and GPIO_OUT1_REG*/
+static uint32_t writes;
+static uint32_t badRegisters;
+
+void fake_reg_write(uint32_t reg, uint32_t value)
+{
+    writes++;
+    switch (reg)
+    {
+    case GPIO_OUT_W1TS_REG:
+        out[0] |= value;
+        break;
+    case GPIO_OUT_W1TC_REG:
+        out[0] &= ~value;
+        break;
+    case GPIO_OUT1_W1TS_REG:
+        out[1] |= value;
+        break;
+    case GPIO_OUT1_W1TC_REG:
+        out[1] &= ~value;
+        break;
+    default:
+        badRegisters++;
+        break;
+    }
+}
+
+static const gpio_num_t pins[] = {
+    GPIO_NUM_2, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_21, GPIO_NUM_32, GPIO_NUM_33,
+};
+#define PIN_COUNT   (sizeof(pins) / sizeof(pins[0]))
+
+/*Output words expected after writing 'levels' over 'background'*/
+static void expected_words(uint32_t levels, uint32_t background, uint32_t words[2])
+{
+    words[0] = words[1] = background;
+    for (uint8_t i = 0; i < PIN_COUNT; i++)
+    {
+        uint32_t bit = 1UL << (pins[i] % 32);
+        if (levels & (1UL << i))
+        {
+            words[pins[i] / 32] |= bit;
+        }
+        else
+        {
+            words[pins[i] / 32] &= ~bit;
+        }
+    }
+}
+
+static void test_levels(void)
+{
+    static const uint32_t backgrounds[] = { 0, 0xFFFFFFFF, 0xA5A5A5A5 };
+    gpio_bank_t bank;
+    gpio_bank_state_t state;
+    uint32_t mismatches = 0;
+    uint32_t overlaps = 0;
+    uint32_t words[2];
+
+    TEST_CHECK_EQUAL(gpio_bank_init(&bank, pins, PIN_COUNT), ESP_OK);
+    for (uint32_t b = 0; b < sizeof(backgrounds) / sizeof(backgrounds[0]); b++)
+    {
+        for (uint32_t levels = 0; levels < (1UL << PIN_COUNT); levels++)
+        {
+            gpio_bank_prepare(&bank, levels, &state);
+            for (uint8_t w = 0; w < GPIO_BANK_WORDS; w++)
+            {
+                overlaps += ((state.set[w] & state.clear[w]) != 0);
+            }
+
+            out[0] = out[1] = backgrounds[b];
+            writes = 0;
+            gpio_bank_apply(&state);
+            expected_words(levels, backgrounds[b], words);
+            mismatches += (out[0] != words[0] || out[1] != words[1] || writes != 4);
+
+            /*Same result in one call*/
+            out[0] = out[1] = backgrounds[b];
+            gpio_bank_write(&bank, levels);
+            mismatches += (out[0] != words[0] || out[1] != words[1]);
+        }
+    }
+    TEST_CHECK_EQUAL(mismatches, 0);
+    TEST_CHECK_EQUAL(overlaps, 0);
+    TEST_CHECK_EQUAL(badRegisters, 0);
+
+    /*Set and clear together cover exactly the bank pins*/
+    gpio_bank_prepare(&bank, 0x5A, &state);
+    TEST_CHECK_EQUAL(state.set[0] | state.clear[0], (1UL << 2) | (1UL << 4) | (1UL << 5) | (1UL << 18) | (1UL << 19) | (1UL << 21));
+    TEST_CHECK_EQUAL(state.set[1] | state.clear[1], (1UL << 0) | (1UL << 1));
+
+    /*An empty bank writes empty masks*/
+    TEST_CHECK_EQUAL(gpio_bank_init(&bank, pins, 0), ESP_OK);
+    out[0] = out[1] = 0x12345678;
+    gpio_bank_write(&bank, 0xFFFFFFFF);
+    TEST_CHECK(out[0] == 0x12345678 && out[1] == 0x12345678);
+}
+
+static void test_invalid_pins(void)
+{
+    static const gpio_num_t rejected[] = { GPIO_NUM_NC, GPIO_NUM_24, GPIO_NUM_34, GPIO_NUM_39, GPIO_NUM_MAX };
+    static const gpio_num_t many[GPIO_BANK_MAX_PINS + 1] = { GPIO_NUM_2 };
+    gpio_bank_t bank;
+
+    for (uint32_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); i++)
+    {
+        gpio_num_t bad[] = { GPIO_NUM_2, rejected[i] };
+        TEST_CHECK_EQUAL(gpio_bank_init(&bank, bad, 2), ESP_ERR_INVALID_ARG);
+    }
+    TEST_CHECK_EQUAL(gpio_bank_init(&bank, many, GPIO_BANK_MAX_PINS + 1), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(gpio_bank_init(NULL, pins, PIN_COUNT), ESP_ERR_INVALID_ARG);
+}
+
+int main(void)
+{
+    test_levels();
+    test_invalid_pins();
+    return TEST_RESULT();
+}
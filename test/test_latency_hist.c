@@ -0,0 +1,131 @@
+/***************************************************************************
+*@brief Host test of latency_hist
+Percentiles of known distributions are compared with the exact ones taken
+from the sorted samples: the histogram gives the upper edge of the bin of
+the exact value, never more than the maximum, and the maximum for the
+samples in the overflow.
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "latency_hist.h"
+#include "test_check.h"
+
+#define SAMPLES     20000
+#define HIST_RANGE  (LATENCY_HIST_BINS * LATENCY_HIST_BIN_CYCLES)
+
+static latency_hist_t hist;
+static uint32_t samples[SAMPLES];
+static uint32_t sorted[SAMPLES];
+
+static uint32_t random_next(void)
+{
+    static uint32_t state = 44;
+
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+static int compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*What the histogram must answer, from the exact percentile*/
+static uint32_t expected_percentile(uint32_t count, uint32_t permille)
+{
+    uint32_t target = (uint32_t)(((uint64_t)count * permille + 999) / 1000);
+    uint32_t exact = sorted[target - 1];
+    uint32_t max = sorted[count - 1];
+    uint32_t edge = (exact / LATENCY_HIST_BIN_CYCLES + 1) * LATENCY_HIST_BIN_CYCLES - 1;
+
+    if (exact >= HIST_RANGE)
+    {
+        return max;
+    }
+    return (edge < max) ? edge : max;
+}
+
+static void check_distribution(const char *name, uint32_t count)
+{
+    static const uint32_t permilles[] = { 1, 100, 500, 900, 990, 999, 1000 };
+    uint32_t mismatches = 0;
+
+    latency_hist_reset(&hist);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        latency_hist_add(&hist, samples[i]);
+        sorted[i] = samples[i];
+    }
+    qsort(sorted, count, sizeof(uint32_t), compare);
+
+    TEST_CHECK_EQUAL(hist.count, count);
+    TEST_CHECK_EQUAL(hist.min, sorted[0]);
+    TEST_CHECK_EQUAL(hist.max, sorted[count - 1]);
+    for (uint32_t i = 0; i < sizeof(permilles) / sizeof(permilles[0]); i++)
+    {
+        uint32_t got = latency_hist_percentile(&hist, permilles[i]);
+        uint32_t expected = expected_percentile(count, permilles[i]);
+        if (got != expected)
+        {
+            printf("%s: p%u.%u is %u, expected %u\n", name, permilles[i] / 10, permilles[i] % 10, got, expected);
+            mismatches++;
+        }
+    }
+    printf("%s: p50 %u, p99 %u, max %u cycles\n", name, latency_hist_percentile(&hist, 500),
+           latency_hist_percentile(&hist, 990), hist.max);
+    TEST_CHECK_EQUAL(mismatches, 0);
+}
+
+int main(void)
+{
+    /*Empty*/
+    latency_hist_reset(&hist);
+    TEST_CHECK_EQUAL(hist.count, 0);
+    TEST_CHECK_EQUAL(hist.min, UINT32_MAX);
+    TEST_CHECK_EQUAL(latency_hist_percentile(&hist, 500), 0);
+    TEST_CHECK_EQUAL(latency_hist_percentile(&hist, 990), 0);
+
+    /*One value: every percentile is that value, not the edge of its bin*/
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        samples[i] = 100;
+    }
+    check_distribution("constant", 100);
+    TEST_CHECK_EQUAL(latency_hist_percentile(&hist, 500), 100);
+
+    /*Uniform, a known p50 and p99*/
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        samples[i] = i;
+    }
+    check_distribution("uniform", 10000);
+    TEST_CHECK_EQUAL(latency_hist_percentile(&hist, 500), 5023);    /*4999 is in the bin ending at 5023*/
+    TEST_CHECK_EQUAL(latency_hist_percentile(&hist, 990), 9919);    /*9899 is in the bin ending at 9919*/
+
+    /*Heavy tail: mostly ~300 cycles, some preemptions up to beyond the last bin*/
+    for (uint32_t i = 0; i < SAMPLES; i++)
+    {
+        uint32_t r = random_next();
+        samples[i] = 250 + r % 100;
+        if (r % 100 == 0)
+        {
+            samples[i] += random_next() % (2 * HIST_RANGE);
+        }
+    }
+    check_distribution("tail", SAMPLES);
+    TEST_CHECK(hist.overflow > 0);
+
+    /*1 % in the overflow: p99 is still in the bins, p99.9 is the maximum*/
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        samples[i] = (i < 990) ? 100 : HIST_RANGE + i;
+    }
+    check_distribution("overflow", 1000);
+    TEST_CHECK_EQUAL(hist.overflow, 10);
+    TEST_CHECK_EQUAL(latency_hist_percentile(&hist, 990), 127);
+    TEST_CHECK_EQUAL(latency_hist_percentile(&hist, 999), HIST_RANGE + 999);
+    return TEST_RESULT();
+}
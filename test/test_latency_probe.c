@@ -0,0 +1,145 @@
+/***************************************************************************
+*@brief Host test of latency_probe
+With a clock set by the test, every primitive must carry the stamp of the
+signal to the waiter, a disarmed probe must not signal and arming must drop
+the signals left. Then a task standing for the GPTimer signals through the
+FromISR calls of the shim every tick while the main task waits: every wake
+up must be measured, and a stamp newer than the wake up (which would wrap to
+a huge latency) must never be used.
+***************************************************************************/
+#include <stdio.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "latency_hist.h"
+#include "latency_probe.h"
+#include "test_check.h"
+
+#define SAMPLES         200     /*Wake ups measured for every primitive*/
+#define WRAP_BOUND_US   1000000 /*A latency above it is a stale stamp, not a slow host*/
+#define SHORT_TIMEOUT   10
+
+static latency_probe_t probe;
+static volatile uint32_t fakeNow;
+static atomic_bool stopTimer;
+
+static uint32_t fake_clock(void)
+{
+    return fakeNow;
+}
+
+static uint32_t us_clock(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+/*Stands for the GPTimer interrupt*/
+static void timer_task(void *arg)
+{
+    while (!atomic_load(&stopTimer))
+    {
+        latency_probe_signal_from_isr(&probe);
+        vTaskDelay(1);
+    }
+    vTaskDelete(NULL);
+}
+
+/*********************
+*   TESTS
+*********************/
+static void test_stamps(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t latency = 0;
+
+    TEST_CHECK_EQUAL(latency_probe_init(&probe, NULL), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(latency_probe_init(&probe, fake_clock), ESP_OK);
+    TEST_CHECK_EQUAL(latency_probe_arm(&probe, LATENCY_PROBE_PRIMITIVES, self), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(latency_probe_arm(&probe, LATENCY_PROBE_SEMAPHORE, NULL), ESP_ERR_INVALID_ARG);
+
+    for (latency_probe_primitive_t primitive = 0; primitive < LATENCY_PROBE_PRIMITIVES; primitive++)
+    {
+        printf("%s\n", latency_probe_name(primitive));
+
+        /*Disarmed: no signal*/
+        TEST_CHECK(!latency_probe_signal_from_isr(&probe));
+        TEST_CHECK_EQUAL(latency_probe_arm(&probe, primitive, self), ESP_OK);
+        latency_probe_disarm(&probe);
+        TEST_CHECK(!latency_probe_signal_from_isr(&probe));
+        TEST_CHECK_EQUAL(latency_probe_wait(&probe, SHORT_TIMEOUT, &latency), ESP_ERR_TIMEOUT);
+
+        /*Signals left from a previous measure are dropped by the arm*/
+        TEST_CHECK_EQUAL(latency_probe_arm(&probe, primitive, self), ESP_OK);
+        latency_probe_signal_from_isr(&probe);
+        TEST_CHECK_EQUAL(latency_probe_arm(&probe, primitive, self), ESP_OK);
+        TEST_CHECK_EQUAL(latency_probe_wait(&probe, SHORT_TIMEOUT, &latency), ESP_ERR_TIMEOUT);
+
+        /*The last stamp before the wake up is measured*/
+        fakeNow = 100;
+        latency_probe_signal_from_isr(&probe);
+        fakeNow = 130;
+        latency_probe_signal_from_isr(&probe);
+        fakeNow = 175;
+        TEST_CHECK_EQUAL(latency_probe_wait(&probe, SHORT_TIMEOUT, &latency), ESP_OK);
+        TEST_CHECK_EQUAL(latency, 45);
+        TEST_CHECK_EQUAL(latency_probe_wait(&probe, SHORT_TIMEOUT, &latency), ESP_ERR_TIMEOUT);  /*Given once*/
+
+        /*The clock wraps*/
+        fakeNow = UINT32_MAX - 9;
+        latency_probe_signal_from_isr(&probe);
+        fakeNow = 10;
+        TEST_CHECK_EQUAL(latency_probe_wait(&probe, SHORT_TIMEOUT, &latency), ESP_OK);
+        TEST_CHECK_EQUAL(latency, 20);
+        latency_probe_disarm(&probe);
+    }
+    latency_probe_deinit(&probe);
+}
+
+static void test_timer(void)
+{
+    static latency_hist_t hist;
+    TaskHandle_t timer = NULL;
+
+    TEST_CHECK_EQUAL(latency_probe_init(&probe, us_clock), ESP_OK);
+    TEST_CHECK(xTaskCreate(timer_task, "timer", 1024*2, NULL, 3, &timer) == pdPASS);
+
+    for (latency_probe_primitive_t primitive = 0; primitive < LATENCY_PROBE_PRIMITIVES; primitive++)
+    {
+        uint32_t latency = 0;
+        uint32_t timeouts = 0;
+
+        latency_hist_reset(&hist);
+        TEST_CHECK_EQUAL(latency_probe_arm(&probe, primitive, xTaskGetCurrentTaskHandle()), ESP_OK);
+        while (hist.count < SAMPLES && timeouts < SAMPLES)
+        {
+            if (latency_probe_wait(&probe, pdMS_TO_TICKS(100), &latency) == ESP_OK)
+            {
+                latency_hist_add(&hist, latency);
+            }
+            else
+            {
+                timeouts++;
+            }
+        }
+        latency_probe_disarm(&probe);
+
+        printf("%-9s: %lu wake ups, p50 %lu us, p99 %lu us, max %lu us\n", latency_probe_name(primitive),
+               (unsigned long)hist.count, (unsigned long)latency_hist_percentile(&hist, 500),
+               (unsigned long)latency_hist_percentile(&hist, 990), (unsigned long)hist.max);
+        TEST_CHECK_EQUAL(hist.count, SAMPLES);
+        TEST_CHECK_EQUAL(timeouts, 0);
+        TEST_CHECK(hist.max < WRAP_BOUND_US);
+    }
+
+    atomic_store(&stopTimer, true);
+    vTaskDelay(pdMS_TO_TICKS(10));
+    latency_probe_deinit(&probe);
+}
+
+int main(void)
+{
+    test_stamps();
+    test_timer();
+    return TEST_RESULT();
+}
@@ -0,0 +1,155 @@
+/***************************************************************************
+*@brief Host test of log_rate
+The clock is a fake one (LOG_RATE_NOW_MS is defined before the include) and
+the log macro records the lines, so the cadence of every macro and the
+"(+N suppressed)" counts are checked call by call, across the wrap around
+of the clock too.
+***************************************************************************/
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include "test_check.h"
+
+static uint32_t fakeNow;
+#define LOG_RATE_NOW_MS()   (fakeNow)
+#include "log_rate.h"
+
+#define MAX_LINES   64
+#define LINE_LEN    96
+
+static char lines[MAX_LINES][LINE_LEN];
+static uint32_t lineCount;
+
+static void capture(const char *tag, const char *format, ...)
+{
+    va_list args;
+
+    if (lineCount < MAX_LINES)
+    {
+        va_start(args, format);
+        vsnprintf(lines[lineCount], LINE_LEN, format, args);
+        va_end(args);
+    }
+    lineCount++;
+}
+
+#define CAPTURE(tag, format, ...)   capture(tag, format, ##__VA_ARGS__)
+
+static void clear_lines(void)
+{
+    lineCount = 0;
+    memset(lines, 0, sizeof(lines));
+}
+
+/*********************
+*   TESTS
+*********************/
+static void test_every_n(void)
+{
+    uint32_t evaluated = 0;
+
+    /*Lines at calls 0, 10, 20 and 30; the arguments are only evaluated for them*/
+    clear_lines();
+    for (uint32_t i = 0; i < 35; i++)
+    {
+        LOG_EVERY_N(10, CAPTURE, "test", "call %u, line %u", i, evaluated++);
+    }
+    TEST_CHECK_EQUAL(lineCount, 4);
+    TEST_CHECK_EQUAL(evaluated, 4);
+    TEST_CHECK(strcmp(lines[0], "call 0, line 0") == 0);
+    TEST_CHECK(strcmp(lines[1], "call 10, line 1 (+9 suppressed)") == 0);
+    TEST_CHECK(strcmp(lines[3], "call 30, line 3 (+9 suppressed)") == 0);
+
+    /*1 of every 1 is every call, without a suppressed count*/
+    clear_lines();
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        LOG_EVERY_N(1, CAPTURE, "test", "every %u", i);
+    }
+    TEST_CHECK_EQUAL(lineCount, 5);
+    TEST_CHECK(strcmp(lines[4], "every 4") == 0);
+
+    /*n = 0 (a runtime setting left at zero) logs every call too, it must not wrap to 1 of 2^32*/
+    uint32_t n = 0;
+    clear_lines();
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        LOG_EVERY_N(n, CAPTURE, "test", "zero %u", i);
+    }
+    TEST_CHECK_EQUAL(lineCount, 5);
+    TEST_CHECK(strcmp(lines[4], "zero 4") == 0);
+}
+
+/*Calls every 7 ms to a site limited to one line every 100 ms*/
+static void run_every_ms(uint32_t start, uint32_t calls)
+{
+    fakeNow = start;
+    for (uint32_t i = 0; i < calls; i++, fakeNow += 7)
+    {
+        LOG_EVERY_MS(100, CAPTURE, "test", "t %u", fakeNow - start);
+    }
+}
+
+static void test_every_ms(void)
+{
+    /*Lines at 0, 105, 210... (the first call 100 ms or more after the last line)*/
+    clear_lines();
+    run_every_ms(1000, 100);
+    TEST_CHECK_EQUAL(lineCount, 7);
+    TEST_CHECK(strcmp(lines[0], "t 0") == 0);
+    TEST_CHECK(strcmp(lines[1], "t 105 (+14 suppressed)") == 0);
+    TEST_CHECK(strcmp(lines[6], "t 630 (+14 suppressed)") == 0);
+
+    /*Same cadence when the clock wraps around. The site keeps its state: the
+      first call is a line counting the 9 calls suppressed after t 630*/
+    clear_lines();
+    run_every_ms(UINT32_MAX - 300, 100);
+    TEST_CHECK_EQUAL(lineCount, 7);
+    TEST_CHECK(strcmp(lines[0], "t 0 (+9 suppressed)") == 0);
+    TEST_CHECK(strcmp(lines[3], "t 315 (+14 suppressed)") == 0);    /*After the wrap*/
+}
+
+static void test_on_change(void)
+{
+    static const int values[] = { 1, 1, 1, 2, 2, 3, 3, 3, 3, 1 };
+    uint32_t reads = 0;
+
+    clear_lines();
+    for (uint32_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        LOG_ON_CHANGE((reads++, values[i]), CAPTURE, "test", "value %d", values[i]);
+    }
+    TEST_CHECK_EQUAL(reads, 10);    /*The value is read once per call*/
+    TEST_CHECK_EQUAL(lineCount, 4);
+    TEST_CHECK(strcmp(lines[0], "value 1") == 0);
+    TEST_CHECK(strcmp(lines[1], "value 2 (+2 suppressed)") == 0);
+    TEST_CHECK(strcmp(lines[2], "value 3 (+1 suppressed)") == 0);
+    TEST_CHECK(strcmp(lines[3], "value 1 (+3 suppressed)") == 0);
+}
+
+static void test_call_sites(void)
+{
+    /*Two sites in the same loop count separately*/
+    clear_lines();
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        LOG_EVERY_N(3, CAPTURE, "test", "a %u", i);
+        LOG_EVERY_N(2, CAPTURE, "test", "b %u", i);
+    }
+    TEST_CHECK_EQUAL(lineCount, 5);
+    TEST_CHECK(strcmp(lines[0], "a 0") == 0);
+    TEST_CHECK(strcmp(lines[1], "b 0") == 0);
+    TEST_CHECK(strcmp(lines[2], "b 2 (+1 suppressed)") == 0);
+    TEST_CHECK(strcmp(lines[3], "a 3 (+2 suppressed)") == 0);
+    TEST_CHECK(strcmp(lines[4], "b 4 (+1 suppressed)") == 0);
+}
+
+int main(void)
+{
+    test_every_n();
+    test_every_ms();
+    test_on_change();
+    test_call_sites();
+    return TEST_RESULT();
+}
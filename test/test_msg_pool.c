@@ -0,0 +1,264 @@
+/***************************************************************************
+*@brief Host test of msg_pool
+Messages go from the main task to a consumer task and back to the pool
+whole and in order, every block aligned for any type. Freeing a block twice,
+a pointer from outside the pool or one inside a block is rejected. With the
+pool exhausted msg_pool_alloc() blocks until a block is freed. Then the cost
+of handing a message over is printed for payloads from 4 B to 2 KB, copied
+through a Queue and passed as a pool block. The pool pays a second queue
+(its free list) per message, which only pays off once the copy costs more:
+on the host memcpy() is cheap next to the pthread queue of the shim.
+***************************************************************************/
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "msg_pool.h"
+#include "test_check.h"
+
+#define BLOCKS          8
+#define BLOCK_SIZE      100     /*Not a multiple of MSG_POOL_ALIGN*/
+#define ROUND_TRIPS     1000
+#define STALL_TICKS     20
+
+#define BENCH_MESSAGES  20000   /*Messages streamed for every payload size and mode*/
+#define BENCH_DEPTH     8
+#define BENCH_MAX       2048
+
+typedef struct {
+    uint32_t sequence;
+    uint8_t payload[BLOCK_SIZE - sizeof(uint32_t)];
+} message_t;
+
+static msg_pool_t pool;
+static uint8_t storage[MSG_POOL_STORAGE_SIZE(BLOCK_SIZE, BLOCKS)] __attribute__((aligned(MSG_POOL_ALIGN)));
+static QueueHandle_t queue;
+static atomic_uint received;
+static atomic_uint corrupted;
+
+static void consumer_task(void *arg)
+{
+    TaskHandle_t caller = (TaskHandle_t)arg;
+
+    for (uint32_t i = 0; i < ROUND_TRIPS; i++)
+    {
+        message_t *message = msg_pool_receive(queue, portMAX_DELAY);
+        bool whole = message->sequence == i;
+
+        for (size_t b = 0; b < sizeof(message->payload); b++)
+        {
+            whole = whole && message->payload[b] == (uint8_t)(i + b);
+        }
+        atomic_fetch_add(&corrupted, !whole);
+        atomic_fetch_add(&received, 1);
+        msg_pool_free(&pool, message);
+    }
+    xTaskNotifyGive(caller);
+    vTaskDelete(NULL);
+}
+
+/*Frees a block after STALL_TICKS, while the main task waits for one*/
+static void late_free_task(void *arg)
+{
+    vTaskDelay(STALL_TICKS);
+    msg_pool_free(&pool, arg);
+    vTaskDelete(NULL);
+}
+
+/*********************
+*   TESTS
+*********************/
+static void test_init(void)
+{
+    TEST_CHECK_EQUAL(msg_pool_init(&pool, storage + 1, BLOCK_SIZE, BLOCKS), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(msg_pool_init(&pool, storage, BLOCK_SIZE, MSG_POOL_MAX_BLOCKS + 1), ESP_ERR_INVALID_SIZE);
+    TEST_CHECK_EQUAL(msg_pool_init(&pool, storage, 0, BLOCKS), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(msg_pool_init(&pool, storage, BLOCK_SIZE, BLOCKS), ESP_OK);
+    TEST_CHECK_EQUAL(pool.block_size % MSG_POOL_ALIGN, 0);
+    TEST_CHECK(pool.block_size >= BLOCK_SIZE);
+    TEST_CHECK_EQUAL(msg_pool_available(&pool), BLOCKS);
+}
+
+static void test_round_trip(void)
+{
+    queue = msg_pool_queue_create(&pool);
+    TEST_CHECK(queue != NULL);
+    TEST_CHECK(xTaskCreate(consumer_task, "consumer", 1024*2, xTaskGetCurrentTaskHandle(), 2, NULL) == pdPASS);
+
+    for (uint32_t i = 0; i < ROUND_TRIPS; i++)
+    {
+        message_t *message = msg_pool_alloc(&pool, portMAX_DELAY);
+        TEST_CHECK_EQUAL((uintptr_t)message % MSG_POOL_ALIGN, 0);
+        message->sequence = i;
+        for (size_t b = 0; b < sizeof(message->payload); b++)
+        {
+            message->payload[b] = (uint8_t)(i + b);
+        }
+        TEST_CHECK_EQUAL(msg_pool_send(queue, message, portMAX_DELAY), ESP_OK);
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    TEST_CHECK_EQUAL(atomic_load(&received), ROUND_TRIPS);
+    TEST_CHECK_EQUAL(atomic_load(&corrupted), 0);
+    TEST_CHECK_EQUAL(msg_pool_available(&pool), BLOCKS);
+    TEST_CHECK(msg_pool_receive(queue, 0) == NULL);
+    vQueueDelete(queue);
+}
+
+static void test_bad_free(void)
+{
+    uint8_t local[BLOCK_SIZE];
+    BaseType_t woken = pdFALSE;
+    uint8_t *block = msg_pool_alloc(&pool, 0);
+
+    TEST_CHECK(block != NULL);
+    TEST_CHECK_EQUAL(msg_pool_free(&pool, local), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(msg_pool_free(&pool, block + 1), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(msg_pool_free(&pool, storage + sizeof(storage)), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(msg_pool_free_from_isr(&pool, local, &woken), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(msg_pool_available(&pool), BLOCKS - 1);
+
+    TEST_CHECK_EQUAL(msg_pool_free(&pool, block), ESP_OK);
+    TEST_CHECK_EQUAL(msg_pool_free(&pool, block), ESP_ERR_INVALID_STATE);
+    TEST_CHECK_EQUAL(msg_pool_free_from_isr(&pool, block, &woken), ESP_ERR_INVALID_STATE);
+    TEST_CHECK_EQUAL(msg_pool_available(&pool), BLOCKS);   /*Not queued twice*/
+
+    block = msg_pool_alloc(&pool, 0);
+    TEST_CHECK_EQUAL(msg_pool_free_from_isr(&pool, block, &woken), ESP_OK);
+    TEST_CHECK_EQUAL(msg_pool_available(&pool), BLOCKS);
+}
+
+static void test_exhaustion(void)
+{
+    void *blocks[BLOCKS];
+
+    for (int i = 0; i < BLOCKS; i++)
+    {
+        blocks[i] = msg_pool_alloc(&pool, 0);
+        TEST_CHECK(blocks[i] != NULL);
+    }
+    TEST_CHECK(msg_pool_alloc(&pool, 0) == NULL);
+
+    TickType_t start = xTaskGetTickCount();
+    TEST_CHECK(msg_pool_alloc(&pool, STALL_TICKS / 2) == NULL);
+    TEST_CHECK(xTaskGetTickCount() - start >= STALL_TICKS / 2);
+
+    /*The producer blocks until the consumer frees a block, and gets that one*/
+    TEST_CHECK(xTaskCreate(late_free_task, "late_free", 1024*2, blocks[3], 2, NULL) == pdPASS);
+    start = xTaskGetTickCount();
+    void *block = msg_pool_alloc(&pool, portMAX_DELAY);
+    TEST_CHECK(block == blocks[3]);
+    TEST_CHECK(xTaskGetTickCount() - start >= STALL_TICKS - 1);
+
+    for (int i = 0; i < BLOCKS; i++)
+    {
+        TEST_CHECK_EQUAL(msg_pool_free(&pool, blocks[i]), ESP_OK);
+    }
+    TEST_CHECK_EQUAL(msg_pool_available(&pool), BLOCKS);
+}
+
+/*********************
+*   BENCHMARK
+*********************/
+static const uint16_t payloads[] = { 4, 64, 256, 1024, 2048 };
+
+typedef struct {
+    QueueHandle_t queue;
+    msg_pool_t *pool;           /*NULL: the payload is copied into the queue*/
+    size_t payload;
+    TaskHandle_t caller;        /*Notified when the consumer finishes*/
+    uint32_t checksum;          /*Keeps the consumer reading the payload*/
+} stream_t;
+
+static uint8_t benchStorage[MSG_POOL_STORAGE_SIZE(BENCH_MAX, BENCH_DEPTH)] __attribute__((aligned(MSG_POOL_ALIGN)));
+static uint8_t producerFrame[BENCH_MAX];
+static uint8_t consumerFrame[BENCH_MAX];
+
+static void stream_consumer(void *arg)
+{
+    stream_t *stream = (stream_t *)arg;
+
+    for (uint32_t i = 0; i < BENCH_MESSAGES; i++)
+    {
+        if (stream->pool)
+        {
+            uint8_t *block = msg_pool_receive(stream->queue, portMAX_DELAY);
+            stream->checksum += block[stream->payload - 1];
+            msg_pool_free(stream->pool, block);
+        }
+        else
+        {
+            xQueueReceive(stream->queue, consumerFrame, portMAX_DELAY);
+            stream->checksum += consumerFrame[stream->payload - 1];
+        }
+    }
+    xTaskNotifyGive(stream->caller);
+    vTaskDelete(NULL);
+}
+
+/*Streams BENCH_MESSAGES to a consumer task, returns the microseconds taken*/
+static int64_t stream_messages(msg_pool_t *bench, size_t payload)
+{
+    stream_t stream = {
+        .queue = bench ? msg_pool_queue_create(bench) : xQueueCreate(BENCH_DEPTH, payload),
+        .pool = bench,
+        .payload = payload,
+        .caller = xTaskGetCurrentTaskHandle(),
+    };
+
+    TEST_CHECK(stream.queue != NULL);
+    TEST_CHECK(xTaskCreate(stream_consumer, "stream", 1024*2, &stream, 2, NULL) == pdPASS);
+
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < BENCH_MESSAGES; i++)
+    {
+        if (bench)
+        {
+            uint8_t *block = msg_pool_alloc(bench, portMAX_DELAY);
+            block[payload - 1] = 1;     /*The producer writes the message in place*/
+            msg_pool_send(stream.queue, block, portMAX_DELAY);
+        }
+        else
+        {
+            producerFrame[payload - 1] = 1;
+            xQueueSend(stream.queue, producerFrame, portMAX_DELAY);
+        }
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    TEST_CHECK_EQUAL(stream.checksum, BENCH_MESSAGES);
+    vQueueDelete(stream.queue);
+    return elapsed;
+}
+
+static void bench_copy_vs_pool(void)
+{
+    static msg_pool_t bench;
+
+    printf("%7s %14s %10s %14s %10s\n", "payload", "copy msgs/s", "copy us", "pool msgs/s", "pool us");
+    for (size_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++)
+    {
+        TEST_CHECK_EQUAL(msg_pool_init(&bench, benchStorage, payloads[i], BENCH_DEPTH), ESP_OK);
+
+        int64_t copy = stream_messages(NULL, payloads[i]);
+        int64_t zero = stream_messages(&bench, payloads[i]);
+        printf("%7u %14.0f %10.3f %14.0f %10.3f\n", payloads[i],
+               BENCH_MESSAGES * 1e6 / copy, (double)copy / BENCH_MESSAGES,
+               BENCH_MESSAGES * 1e6 / zero, (double)zero / BENCH_MESSAGES);
+        vQueueDelete(bench.free);
+    }
+}
+
+int main(void)
+{
+    test_init();
+    test_round_trip();
+    test_bad_free();
+    test_exhaustion();
+    bench_copy_vs_pool();
+    return TEST_RESULT();
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+*@brief Host test of periodic_out
+Outputs with different periods and phases share the engine task, and two of
+them burn 3 ms per execution. The n-th execution of every output must happen
+no earlier than start + phase + n * period and within a constant slack
+of it: if the execution time accumulated as drift, the last executions
+would be tens of ticks late.
+The ticks are the wall clock, so the slack only holds while the test has the
+CPU of the host: it is registered SERIAL and ctest -j runs it alone.
+***************************************************************************/
+#include <stdio.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "periodic_out.h"
+#include "test_check.h"
+
+#define OUTPUTS         4
+#define RECORDS         40      /*Executions recorded per output*/
+#define BURN_US         3000
+#define RUN_MS          450     /*About 40 periods of the 10 ms output*/
+#define SLACK_TICKS     20      /*Scheduling of the host, it does not grow with n*/
+
+typedef struct {
+    TickType_t period;
+    TickType_t phase;
+    bool burn;
+    TickType_t ticks[RECORDS];
+    volatile uint32_t count;
+} output_t;
+
+static output_t outputs[OUTPUTS] = {
+    { .period = 10, .phase = 0, .burn = true },
+    { .period = 7, .phase = 3 },
+    { .period = 25, .phase = 5, .burn = true },
+    { .period = 1000, .phase = 1000 },     /*Never due during the test*/
+};
+
+static void action(void *arg)
+{
+    output_t *output = (output_t *)arg;
+
+    if (output->count < RECORDS)
+    {
+        output->ticks[output->count] = xTaskGetTickCount();
+    }
+    output->count++;
+
+    int64_t end = esp_timer_get_time() + BURN_US;
+    while (output->burn && esp_timer_get_time() < end)
+    {
+    }
+}
+
+static void dummy(void *arg)
+{
+}
+
+int main(void)
+{
+    static periodic_out_entry_t storage[OUTPUTS];
+    periodic_out_t engine;
+
+    TEST_CHECK_EQUAL(periodic_out_init(&engine, storage, OUTPUTS), ESP_OK);
+    TEST_CHECK_EQUAL(periodic_out_start(&engine, "periodic", 1024*3, 5, tskNO_AFFINITY), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(periodic_out_add(&engine, 0, 0, dummy, NULL), ESP_ERR_INVALID_ARG);
+
+    /*Added out of deadline order: the heap sorts them*/
+    for (int i = OUTPUTS - 1; i >= 0; i--)
+    {
+        TEST_CHECK_EQUAL(periodic_out_add(&engine, outputs[i].period, outputs[i].phase, action, &outputs[i]), ESP_OK);
+    }
+    TEST_CHECK_EQUAL(periodic_out_add(&engine, 1, 0, dummy, NULL), ESP_ERR_NO_MEM);
+    TEST_CHECK_EQUAL(periodic_out_start(&engine, "periodic", 1024*3, 5, tskNO_AFFINITY), ESP_OK);
+    TEST_CHECK_EQUAL(periodic_out_add(&engine, 1, 0, dummy, NULL), ESP_ERR_INVALID_STATE);
+    TEST_CHECK_EQUAL(periodic_out_start(&engine, "periodic", 1024*3, 5, tskNO_AFFINITY), ESP_ERR_INVALID_STATE);
+
+    vTaskDelay(pdMS_TO_TICKS(RUN_MS));
+    vTaskDelete(engine.task);
+
+    for (uint8_t o = 0; o < OUTPUTS; o++)
+    {
+        output_t *output = &outputs[o];
+        uint32_t due = (RUN_MS - SLACK_TICKS >= output->phase) ? (RUN_MS - SLACK_TICKS - output->phase) / output->period + 1 : 0;
+        uint32_t recorded = (output->count < RECORDS) ? output->count : RECORDS;
+        uint32_t early = 0;
+        uint32_t late = 0;
+        TickType_t worst = 0;
+
+        for (uint32_t n = 0; n < recorded; n++)
+        {
+            TickType_t deadline = engine.start + output->phase + n * output->period;
+            TickType_t delay = output->ticks[n] - deadline;
+
+            early += ((int32_t)delay < 0);
+            late += ((int32_t)delay > SLACK_TICKS);
+            worst = ((int32_t)delay > (int32_t)worst) ? delay : worst;
+        }
+        printf("period %3u: %2u executions, worst delay %u ticks\n",
+               (unsigned)output->period, (unsigned)output->count, (unsigned)worst);
+        TEST_CHECK(output->count >= (due < RECORDS ? due : RECORDS));
+        TEST_CHECK_EQUAL(early, 0);
+        TEST_CHECK_EQUAL(late, 0);
+    }
+    TEST_CHECK_EQUAL(outputs[3].count, 0);
+    return TEST_RESULT();
+}
@@ -0,0 +1,134 @@
+/***************************************************************************
+*@brief Host test of spsc_ring
+A producer task streams sequence numbers through a small ring to the main
+task, both blocking on full and empty: every item must arrive whole, once
+and in order. A lost wake up does not show as an error (the timeout checks
+again), so receives and sends that stall for STALL_TICKS are counted too.
+The race between the check and the registration of a waiter is only hit
+with the two tasks on different CPUs: a single CPU host mostly switches
+them at their blocking points.
+***************************************************************************/
+#include <stdio.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "spsc_ring.h"
+#include "test_check.h"
+
+#define CAPACITY        16
+#define ITEMS           2000000
+#define STALL_TICKS     100
+#define EMPTY_TIMEOUT   20
+
+typedef struct {
+    uint32_t sequence;
+    uint32_t check;     /*~sequence, a torn copy breaks the pair*/
+} item_t;
+
+static spsc_ring_t ring;
+static item_t storage[CAPACITY];
+static atomic_uint producerStalls;
+static atomic_bool producerDone;
+
+static void producer_task(void *arg)
+{
+    for (uint32_t i = 0; i < ITEMS; i++)
+    {
+        item_t item = { .sequence = i, .check = ~i };
+
+        /*Every other item takes the non blocking path first*/
+        if ((i & 1) && spsc_ring_push(&ring, &item))
+        {
+            continue;
+        }
+        TickType_t start = xTaskGetTickCount();
+        while (spsc_ring_send(&ring, &item, STALL_TICKS) != ESP_OK)
+        {
+            atomic_fetch_add(&producerStalls, 1);
+        }
+        if (xTaskGetTickCount() - start >= STALL_TICKS)
+        {
+            atomic_fetch_add(&producerStalls, 1);
+        }
+    }
+    atomic_store(&producerDone, true);
+    vTaskDelete(NULL);
+}
+
+static void test_stream(void)
+{
+    uint32_t expected = 0;
+    uint32_t outOfOrder = 0;
+    uint32_t torn = 0;
+    uint32_t stalls = 0;
+    item_t item;
+
+    TEST_CHECK_EQUAL(spsc_ring_init(&ring, storage, sizeof(item_t), CAPACITY), ESP_OK);
+    TEST_CHECK(xTaskCreate(producer_task, "producer", 1024*3, NULL, 5, NULL) == pdPASS);
+
+    TickType_t begin = xTaskGetTickCount();
+    while (expected < ITEMS)
+    {
+        TickType_t start = xTaskGetTickCount();
+        if (!((expected & 3) == 0 && spsc_ring_pop(&ring, &item)))
+        {
+            if (spsc_ring_receive(&ring, &item, STALL_TICKS) != ESP_OK)
+            {
+                stalls++;
+                if (atomic_load(&producerDone) && spsc_ring_count(&ring) == 0)
+                {
+                    break;
+                }
+                continue;
+            }
+        }
+        stalls += (xTaskGetTickCount() - start >= STALL_TICKS);
+        torn += (item.check != ~item.sequence);
+        outOfOrder += (item.sequence != expected);
+        expected = item.sequence + 1;
+    }
+    printf("%u items in %u ms\n", expected, (unsigned)(xTaskGetTickCount() - begin));
+
+    TEST_CHECK_EQUAL(expected, ITEMS);
+    TEST_CHECK_EQUAL(outOfOrder, 0);
+    TEST_CHECK_EQUAL(torn, 0);
+    TEST_CHECK_EQUAL(stalls, 0);
+    TEST_CHECK_EQUAL(atomic_load(&producerStalls), 0);
+    TEST_CHECK_EQUAL(spsc_ring_count(&ring), 0);
+}
+
+static void test_full_and_empty(void)
+{
+    item_t item = { 0 };
+
+    TEST_CHECK_EQUAL(spsc_ring_init(&ring, storage, sizeof(item_t), 12), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQUAL(spsc_ring_init(&ring, storage, sizeof(item_t), CAPACITY), ESP_OK);
+    TEST_CHECK_EQUAL(spsc_ring_capacity(&ring), CAPACITY);
+
+    /*Empty: the receive waits for the whole timeout*/
+    TickType_t start = xTaskGetTickCount();
+    TEST_CHECK_EQUAL(spsc_ring_receive(&ring, &item, EMPTY_TIMEOUT), ESP_ERR_TIMEOUT);
+    TEST_CHECK(xTaskGetTickCount() - start >= EMPTY_TIMEOUT);
+    TEST_CHECK(!spsc_ring_pop(&ring, &item));
+
+    /*Full: push fails, send times out*/
+    for (uint32_t i = 0; i < CAPACITY; i++)
+    {
+        item.sequence = i;
+        TEST_CHECK(spsc_ring_push(&ring, &item));
+    }
+    TEST_CHECK_EQUAL(spsc_ring_count(&ring), CAPACITY);
+    TEST_CHECK(!spsc_ring_push(&ring, &item));
+    start = xTaskGetTickCount();
+    TEST_CHECK_EQUAL(spsc_ring_send(&ring, &item, EMPTY_TIMEOUT), ESP_ERR_TIMEOUT);
+    TEST_CHECK(xTaskGetTickCount() - start >= EMPTY_TIMEOUT);
+    TEST_CHECK(spsc_ring_pop(&ring, &item) && item.sequence == 0);
+    TEST_CHECK_EQUAL(spsc_ring_send(&ring, &item, 0), ESP_OK);
+}
+
+int main(void)
+{
+    test_full_and_empty();
+    test_stream();
+    return TEST_RESULT();
+}
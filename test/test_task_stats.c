@@ -0,0 +1,239 @@
+/***************************************************************************
+*@brief Host test of task_stats
+A task busy half of the time and a task that only sleeps are sampled over
+a window: their CPU share must be about 500 and 0 per mille. Then the
+switch hook, the truncation to TASK_STATS_MAX_TASKS, the binary record, its
+frame and the periodic sampling from the timer daemon are checked.
+The run time of a task is the CPU time of its thread and the busy task burns
+CPU time, but the shares are per mille of the wall clock window: they only
+hold while the test has the CPU of the host, so it is registered SERIAL and
+ctest -j runs it alone.
+***************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "task_stats.h"
+#include "test_check.h"
+
+#define WINDOW_MS       500
+#define BUSY_MS         5       /*The busy task burns BUSY_MS then sleeps BUSY_MS*/
+#define EXTRA_TASKS     (TASK_STATS_MAX_TASKS + 2)
+#define PERIOD_MS       50
+
+static task_stats_t stats;
+
+static const task_stats_task_t *find_task(const char *name)
+{
+    const task_stats_task_t *tasks = task_stats_tasks(&stats);
+
+    for (uint8_t i = 0; i < stats.count; i++)
+    {
+        if (strcmp(tasks[i].name, name) == 0)
+        {
+            return &tasks[i];
+        }
+    }
+    return NULL;
+}
+
+static int64_t thread_cpu_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/*Burns CPU time, not wall time: a preempted task still burns BUSY_MS*/
+static void busy_task(void *arg)
+{
+    while (1)
+    {
+        int64_t end = thread_cpu_us() + BUSY_MS * 1000;
+        while (thread_cpu_us() < end)
+        {
+        }
+        vTaskDelay(pdMS_TO_TICKS(BUSY_MS));
+    }
+}
+
+static void sleeping_task(void *arg)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+/*********************
+*   TESTS
+*********************/
+static void test_cpu_share(void)
+{
+    TaskHandle_t busy = NULL;
+    TaskHandle_t sleeper = NULL;
+
+    TEST_CHECK_EQUAL(task_stats_init(&stats), ESP_OK);
+    TEST_CHECK(xTaskCreate(busy_task, "busy", 1024*2, NULL, 2, &busy) == pdPASS);
+    TEST_CHECK(xTaskCreate(sleeping_task, "sleeper", 1024*2, NULL, 2, &sleeper) == pdPASS);
+
+    /*The first sample only sets the reference*/
+    TEST_CHECK_EQUAL(task_stats_sample(&stats), ESP_OK);
+    TEST_CHECK_EQUAL(stats.sequence, 1);
+    TEST_CHECK_EQUAL(stats.window, 0);
+    TEST_CHECK(find_task("busy") && find_task("busy")->cpu == 0);
+
+    vTaskDelay(pdMS_TO_TICKS(WINDOW_MS));
+    TEST_CHECK_EQUAL(task_stats_sample(&stats), ESP_OK);
+    task_stats_log(&stats);
+
+    const task_stats_task_t *busyStats = find_task("busy");
+    const task_stats_task_t *sleeperStats = find_task("sleeper");
+    const task_stats_task_t *mainStats = find_task("main");
+    TEST_CHECK(busyStats && sleeperStats && mainStats);
+    if (busyStats && sleeperStats && mainStats)
+    {
+        printf("busy %u, sleeper %u, main %u per mille, overhead %u per mille\n",
+               busyStats->cpu, sleeperStats->cpu, mainStats->cpu, stats.overhead_permille);
+        TEST_CHECK(busyStats->cpu >= 250 && busyStats->cpu <= 700);
+        TEST_CHECK(sleeperStats->cpu < 50);
+        TEST_CHECK(mainStats->cpu < 50);
+    }
+    TEST_CHECK(stats.window >= (WINDOW_MS - 1) * 1000 && stats.window < WINDOW_MS * 1000 * 2);   /*Delays count whole ticks*/
+    TEST_CHECK(stats.overhead_permille < 50);
+    TEST_CHECK_EQUAL(stats.flags & TASK_STATS_FLAG_SWITCHES, 0);
+
+    vTaskDelete(busy);
+    vTaskDelete(sleeper);
+}
+
+static void test_switches(void)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        task_stats_switched_in();
+    }
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_CHECK_EQUAL(task_stats_sample(&stats), ESP_OK);
+
+    /*20 switches in about 100 ms*/
+    const task_stats_task_t *mainStats = find_task("main");
+    TEST_CHECK(stats.flags & TASK_STATS_FLAG_SWITCHES);
+    TEST_CHECK(mainStats && mainStats->switches >= 100 && mainStats->switches <= 200);
+}
+
+static void test_truncation(void)
+{
+    TaskHandle_t extra[EXTRA_TASKS];
+    char name[configMAX_TASK_NAME_LEN];
+
+    for (int i = 0; i < EXTRA_TASKS; i++)
+    {
+        snprintf(name, sizeof(name), "extra%d", i);
+        TEST_CHECK(xTaskCreate(sleeping_task, name, 1024*2, NULL, 1, &extra[i]) == pdPASS);
+    }
+    TEST_CHECK(uxTaskGetNumberOfTasks() > TASK_STATS_MAX_TASKS);
+    TEST_CHECK_EQUAL(task_stats_sample(&stats), ESP_OK);
+    TEST_CHECK_EQUAL(stats.count, TASK_STATS_MAX_TASKS);
+    TEST_CHECK(stats.flags & TASK_STATS_FLAG_TRUNCATED);
+
+    for (int i = 0; i < EXTRA_TASKS; i++)
+    {
+        vTaskDelete(extra[i]);
+    }
+    TEST_CHECK_EQUAL(task_stats_sample(&stats), ESP_OK);
+    TEST_CHECK_EQUAL(stats.count, uxTaskGetNumberOfTasks());
+    TEST_CHECK_EQUAL(stats.flags & TASK_STATS_FLAG_TRUNCATED, 0);
+}
+
+static void test_encode(void)
+{
+    uint8_t record[TASK_STATS_RECORD_MAX];
+    size_t len = 0;
+    const task_stats_task_t *tasks = task_stats_tasks(&stats);
+
+    TEST_CHECK_EQUAL(task_stats_encode(&stats, record, TASK_STATS_HEADER_SIZE, &len), ESP_ERR_INVALID_SIZE);
+    TEST_CHECK_EQUAL(task_stats_encode(&stats, record, sizeof(record), &len), ESP_OK);
+    TEST_CHECK_EQUAL(len, TASK_STATS_HEADER_SIZE + stats.count * TASK_STATS_TASK_SIZE);
+
+    /*Little endian header, then the first task*/
+    TEST_CHECK(record[0] == 'T' && record[1] == 'S');
+    TEST_CHECK_EQUAL(record[2], TASK_STATS_VERSION);
+    TEST_CHECK_EQUAL(record[3], stats.count);
+    TEST_CHECK_EQUAL(record[4], stats.flags);
+    TEST_CHECK_EQUAL(record[6] | record[7] << 8, stats.overhead_permille);
+    TEST_CHECK_EQUAL(record[8] | record[9] << 8 | record[10] << 16 | (uint32_t)record[11] << 24, stats.sequence);
+    TEST_CHECK_EQUAL(record[12] | record[13] << 8 | record[14] << 16 | (uint32_t)record[15] << 24, stats.window);
+
+    const uint8_t *task = &record[TASK_STATS_HEADER_SIZE];
+    TEST_CHECK_EQUAL(task[0] | task[1] << 8, tasks[0].number);
+    TEST_CHECK_EQUAL(task[2] | task[3] << 8, tasks[0].cpu);
+    TEST_CHECK(strncmp((const char *)&task[8], tasks[0].name, TASK_STATS_NAME_LEN) == 0);
+}
+
+/*The frame carries the record with its bytes escaped and a CRC*/
+static void test_frame(void)
+{
+    uint8_t record[TASK_STATS_RECORD_MAX];
+    uint8_t frame[TASK_STATS_FRAME_MAX];
+    uint8_t unescaped[TASK_STATS_RECORD_MAX + 2];
+    size_t len = 0, framed = 0, out = 0;
+    uint32_t sequence = stats.sequence;
+
+    stats.sequence = 0x0A0DA57D;        /*Every byte that must be escaped*/
+    TEST_CHECK_EQUAL(task_stats_encode(&stats, record, sizeof(record), &len), ESP_OK);
+    TEST_CHECK_EQUAL(task_stats_encode_frame(&stats, frame, STREAM_FRAME_MAX_SIZE(len) - 1, &framed),
+                     ESP_ERR_INVALID_SIZE);
+    TEST_CHECK_EQUAL(task_stats_encode_frame(&stats, frame, sizeof(frame), &framed), ESP_OK);
+    stats.sequence = sequence;
+
+    TEST_CHECK(frame[0] == 0xA5 && frame[1] == 0x53);
+    for (size_t i = 2; i < framed && out < sizeof(unescaped); i++)
+    {
+        TEST_CHECK(frame[i] != '\n' && frame[i] != '\r' && frame[i] != STREAM_FRAME_SYNC_BYTE);
+        unescaped[out++] = (frame[i] == STREAM_FRAME_ESCAPE) ? frame[++i] ^ 0x20 : frame[i];
+    }
+    TEST_CHECK_EQUAL(out, len + 2);
+    TEST_CHECK(memcmp(unescaped, record, len) == 0);
+    TEST_CHECK_EQUAL(unescaped[len] | unescaped[len + 1] << 8, stream_frame_crc(record, len));
+    TEST_CHECK_EQUAL(stream_frame_crc((const uint8_t *)"123456789", 9), 0x29B1);     /*CCITT-FALSE check value*/
+}
+
+static atomic_uint samples;
+
+static void on_sample(const task_stats_t *sampled, void *arg)
+{
+    atomic_fetch_add(&samples, 1);
+}
+
+static void test_periodic(void)
+{
+    TEST_CHECK_EQUAL(task_stats_stop(&stats), ESP_ERR_INVALID_STATE);
+    TEST_CHECK_EQUAL(task_stats_start(&stats, PERIOD_MS, on_sample, NULL), ESP_OK);
+    TEST_CHECK_EQUAL(task_stats_start(&stats, PERIOD_MS, on_sample, NULL), ESP_ERR_INVALID_STATE);
+
+    vTaskDelay(pdMS_TO_TICKS(6 * PERIOD_MS + PERIOD_MS / 2));
+    TEST_CHECK_EQUAL(task_stats_stop(&stats), ESP_OK);
+    unsigned count = atomic_load(&samples);
+    printf("%u samples in %d ms\n", count, 6 * PERIOD_MS + PERIOD_MS / 2);
+    TEST_CHECK(count >= 5 && count <= 6);
+    TEST_CHECK(find_task("Tmr Svc") != NULL);
+
+    /*No sample after the stop*/
+    vTaskDelay(pdMS_TO_TICKS(3 * PERIOD_MS));
+    TEST_CHECK_EQUAL(atomic_load(&samples), count);
+}
+
+int main(void)
+{
+    test_cpu_share();
+    test_switches();
+    test_truncation();
+    test_encode();
+    test_frame();
+    test_periodic();
+    return TEST_RESULT();
+}
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""Rebuilds the text of the binary records streamed by the deferred_log component.
+
+The records only carry the address of their format string, the strings are
+read back from the ELF of the same build. The frames are found by
+stream_frame.py, which skips the text around them and drops corrupted records.
+The lines get the letter of their level and, on a terminal, its color.
+
+Usage: deferred_log_decode.py build/app.elf [capture.bin]   (stdin by default)
+"""
+import re
+import struct
+import sys
+
+import stream_frame
+
+SYNC = stream_frame.sync(0x5A)
+HEADER = struct.Struct('<BBII')         # args, level, timestamp (us), format address
+MAX_ARGS = 4
+LEVELS = 'NEWIDV'                       # Letter of every esp_log_level_t
+COLORS = {'E': '\033[0;31m', 'W': '\033[0;33m', 'I': '\033[0;32m'}
+RESET = '\033[0m'
+SHT_PROGBITS = 1
+SHF_ALLOC = 0x2
+
+# %[flags][width][.precision][length]conversion, '*' widths are not supported
+SPEC = re.compile(r'%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcsp%])')
+
+
+class Elf:
+    """Allocated sections of a 32 bits little endian ELF, to read strings by address."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+            raise ValueError('{} is not a 32 bits little endian ELF'.format(path))
+        shoff, = struct.unpack_from('<I', data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from('<IIIIII', data, shoff + i * shentsize)
+            if sh_type == SHT_PROGBITS and flags & SHF_ALLOC and size:
+                self.sections.append((addr, data[offset:offset + size]))
+
+    def string(self, address):
+        for start, content in self.sections:
+            if start <= address < start + len(content):
+                end = content.find(b'\0', address - start)
+                if end >= 0:
+                    return content[address - start:end].decode('utf-8', 'replace')
+        return None
+
+
+def format_record(elf, fmt, args):
+    """printf() of the target, with the 32 bits arguments of the record."""
+    args = list(args)
+
+    def convert(match):
+        flags, width, precision, _, conversion = match.groups()
+        if conversion == '%':
+            return '%'
+        value = args.pop(0) if args else 0
+        spec = '%' + flags + width + ('.' + precision if precision else '')
+        if conversion == 's':
+            text = elf.string(value)
+            return (spec + 's') % (text if text is not None else '<0x{:08x}>'.format(value))
+        if conversion == 'p':
+            return '0x{:08x}'.format(value)
+        if conversion == 'c':
+            return (spec + 'c') % chr(value & 0xFF)
+        if conversion in 'di':
+            value = value - (1 << 32) if value & 0x80000000 else value
+            conversion = 'd'
+        return (spec + conversion.replace('u', 'd')) % value
+
+    return SPEC.sub(convert, fmt)
+
+
+def record_length(record):
+    """Length of the record announced by its args count, once read."""
+    if not record:
+        return HEADER.size
+    if record[0] > MAX_ARGS:
+        return None
+    return HEADER.size + record[0] * 4
+
+
+def decode(elf, data, out, colors=False):
+    for record in stream_frame.records(data, SYNC, record_length):
+        nargs, level, timestamp, address = HEADER.unpack_from(record)
+        args = struct.unpack_from('<{}I'.format(nargs), record, HEADER.size)
+        fmt = elf.string(address) if address else None
+        if address and fmt is None:
+            text = '<format 0x{:08x} not in the ELF>'.format(address)
+        elif address:
+            text = format_record(elf, fmt, args)
+        else:
+            text = '{} log records dropped'.format(args[0] if args else 0)
+        letter = LEVELS[level] if level < len(LEVELS) else '?'
+        line = '{} ({}) {}'.format(letter, timestamp // 1000, text)
+        if colors and letter in COLORS:
+            line = COLORS[letter] + line + RESET
+        out.write(line + '\n')
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit(__doc__)
+    elf = Elf(sys.argv[1])
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+    decode(elf, data, sys.stdout, sys.stdout.isatty())
+
+
+if __name__ == '__main__':
+    main()
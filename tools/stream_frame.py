@@ -0,0 +1,70 @@
+"""Host side of the stream_frame component: finds the framed records of a stream.
+
+A frame is the 2 bytes sync of its stream, then the record and its CRC-16 with
+the bytes 0x0A, 0x0D, 0xA5 and 0x7D escaped as 0x7D, byte XOR 0x20. Bytes that
+are not frames (boot messages, ESP_LOGx lines) are skipped until the next valid
+sync, and a record whose CRC does not match is dropped.
+"""
+import struct
+
+SYNC_BYTE = 0xA5
+ESCAPE = 0x7D                           # Followed by the escaped byte XOR 0x20
+CRC = struct.Struct('<H')
+
+
+def sync(stream_id):
+    """Sync bytes of a stream, as STREAM_FRAME_SYNC(id)."""
+    return bytes((SYNC_BYTE, stream_id))
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as stream_frame_crc()."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def unescape(data, pos, length):
+    """Record bytes from 'pos' (just after a sync) until a complete record and its CRC.
+
+    'length' gets the record bytes read so far and returns the record length
+    (without the CRC) they announce, or None when they are not a valid record.
+    Returns (record, end) or (None, end) when the bytes are not a record: a sync
+    byte appeared, the data ended or 'length' rejected them.
+    """
+    record = bytearray()
+    needed = length(record)
+    while needed is not None and len(record) < needed + CRC.size:
+        if pos >= len(data) or data[pos] == SYNC_BYTE:
+            return None, pos
+        byte = data[pos]
+        pos += 1
+        if byte == ESCAPE:
+            if pos >= len(data) or data[pos] == SYNC_BYTE:
+                return None, pos
+            byte = data[pos] ^ 0x20
+            pos += 1
+        record.append(byte)
+        if len(record) <= needed:
+            needed = length(record)
+    if needed is None:
+        return None, pos
+    return bytes(record), pos
+
+
+def records(data, stream_sync, length):
+    """Every record of the stream whose CRC matches, without its CRC."""
+    pos = 0
+    while True:
+        pos = data.find(stream_sync, pos)
+        if pos < 0:
+            return
+        record, end = unescape(data, pos + len(stream_sync), length)
+        if record is None or CRC.unpack_from(record, len(record) - CRC.size)[0] != crc16(record[:-CRC.size]):
+            pos += 1        # Not a record or corrupted, look for the next sync
+            continue
+        yield record[:-CRC.size]
+        pos = end
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Prints the CPU usage records streamed by the task_stats component.
+
+The framed records (task_stats_encode_frame()) are found by stream_frame.py,
+which skips the text around them and drops corrupted records. Every record is
+printed as the text report of task_stats_log(): one line per sample, then one
+line per task.
+
+Usage: task_stats_decode.py [capture.bin]   (stdin by default)
+"""
+import struct
+import sys
+
+import stream_frame
+
+SYNC = stream_frame.sync(0x53)
+MAGIC = 0x5354                          # 'TS'
+VERSION = 1
+HEADER = struct.Struct('<HBBBBHII')     # magic, version, tasks, flags, reserved, overhead, sequence, window
+TASK = struct.Struct('<HHHH8s')         # number, cpu, switches, stack free, name
+FLAG_SWITCHES = 1 << 0
+FLAG_TRUNCATED = 1 << 1
+
+
+def record_length(record):
+    """Length of the record announced by its header, once read."""
+    if len(record) >= 2 and struct.unpack_from('<H', record)[0] != MAGIC:
+        return None
+    if len(record) >= 3 and record[2] != VERSION:
+        return None
+    if len(record) < 4:
+        return HEADER.size
+    return HEADER.size + record[3] * TASK.size
+
+
+def decode(data, out):
+    for record in stream_frame.records(data, SYNC, record_length):
+        _, _, tasks, flags, _, overhead, sequence, window = HEADER.unpack_from(record)
+        switches = flags & FLAG_SWITCHES
+        out.write('Sample {}, window {} counts, overhead {}.{} %, switches {}{}\n'.format(
+            sequence, window, overhead // 10, overhead % 10, 'counted' if switches else 'n/a',
+            ', truncated' if flags & FLAG_TRUNCATED else ''))
+        for i in range(tasks):
+            number, cpu, count, stack, name = TASK.unpack_from(record, HEADER.size + i * TASK.size)
+            out.write('  {:<8} #{:<3} cpu {:3}.{} %  switches/s {:>5}  stack free {}\n'.format(
+                name.rstrip(b'\0').decode('utf-8', 'replace'), number, cpu // 10, cpu % 10,
+                count if switches else 'n/a', stack))
+
+
+def main():
+    if len(sys.argv) not in (1, 2):
+        sys.exit(__doc__)
+    if len(sys.argv) == 2:
+        with open(sys.argv[1], 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+    decode(data, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()